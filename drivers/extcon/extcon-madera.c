@@ -10,6 +10,7 @@
 
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/delay.h>
 #include <linux/err.h>
@@ -23,6 +24,8 @@
 #include <linux/property.h>
 #include <linux/power_supply.h>
 #include <linux/regmap.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/regulator/consumer.h>
 
@@ -36,6 +39,9 @@
 #include <linux/mfd/madera/pdata.h>
 #include <linux/mfd/madera/registers.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/extcon_madera.h>
+
 #define MADERA_MAX_MICD_RANGE		8
 
 #define MADERA_MICD_CLAMP_MODE_JD1L	0x4
@@ -54,14 +60,23 @@
 #define MADERA_HPDET_DEBOUNCE_MS	500
 #define MADERA_DEFAULT_MICD_TIMEOUT_MS	2000
 
-#define MADERA_HPDONE_PROBE_INTERVAL_MS	20
-#define MADERA_HPDONE_PROBE_COUNT	15
+/*
+ * The HPDET IRQ can't be used to end the wait, which runs from the state
+ * machine in the same IRQ thread, so HP_DONE is polled on a short interval
+ */
+#define MADERA_HPDONE_PROBE_INTERVAL_US	5000
+#define MADERA_HPDONE_PROBE_COUNT	60
 
 #define MADERA_MICROPHONE_MIN_OHM	1258
 #define MADERA_MICROPHONE_MAX_OHM	30000
 
 #define MADERA_HP_TUNING_INVALID	-1
 
+#define MADERA_BUTTON_DEFAULT_SAMPLES	3
+#define MADERA_BUTTON_MAX_SAMPLES	50
+#define MADERA_HP_TUNING_MAX_REGS	32
+#define MADERA_HP_TUNING_MAX_GAP	2
+
 static const unsigned int madera_cable[] = {
 	EXTCON_MECHANICAL,
 	EXTCON_JACK_HEADPHONE,
@@ -514,6 +529,62 @@ static ssize_t madera_extcon_show(struct device *dev,
 
 static DEVICE_ATTR(hp1_impedance, 0444, madera_extcon_show, NULL);
 
+static const char * const madera_jack_lat_names[] = {
+	[MADERA_JACK_LAT_DEBOUNCE] = "debounce",
+	[MADERA_JACK_LAT_MICD] = "micd",
+	[MADERA_JACK_LAT_HPDET_STEP] = "hpdet_step",
+	[MADERA_JACK_LAT_HPDET] = "hpdet",
+	[MADERA_JACK_LAT_TUNING] = "tuning",
+	[MADERA_JACK_LAT_TOTAL] = "total",
+	[MADERA_JACK_LAT_BUTTON] = "button",
+};
+
+static void madera_jack_lat_record(struct madera_extcon *info,
+				   enum madera_jack_lat_phase phase,
+				   ktime_t start)
+{
+	struct madera_jack_lat_hist *hist = &info->lat_hist[phase];
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket;
+
+	if (us < 0)
+		us = 0;
+
+	trace_madera_jack_latency(info->dev, madera_jack_lat_names[phase], us);
+
+	bucket = fls((unsigned int)div_s64(us, 1000));
+	if (bucket >= MADERA_JACK_LAT_NUM_BUCKETS)
+		bucket = MADERA_JACK_LAT_NUM_BUCKETS - 1;
+
+	hist->count++;
+	hist->total_us += us;
+	if (us > hist->max_us)
+		hist->max_us = us;
+	hist->bucket[bucket]++;
+}
+
+/* Close the current phase of an insertion and start timing the next one */
+static void madera_jack_lat_phase_end(struct madera_extcon *info,
+				      enum madera_jack_lat_phase phase)
+{
+	if (!ktime_to_ns(info->lat_insert))
+		return;
+
+	madera_jack_lat_record(info, phase, info->lat_phase);
+	info->lat_phase = ktime_get();
+}
+
+/* Time spent measuring in an HPDET range, called whenever the range changes */
+static void madera_hpdet_lat_step(struct madera_extcon *info)
+{
+	if (!ktime_to_ns(info->lat_insert))
+		return;
+
+	madera_jack_lat_record(info, MADERA_JACK_LAT_HPDET_STEP,
+			       info->lat_hpdet_step);
+	info->lat_hpdet_step = ktime_get();
+}
+
 inline void madera_extcon_report(struct madera_extcon *info,
 				 int which, bool attached)
 {
@@ -522,6 +593,8 @@ inline void madera_extcon_report(struct madera_extcon *info,
 	dev_info(info->dev, "Extcon report: %d is %s\n",
 		which, attached ? "attached" : "removed");
 
+	trace_madera_jack_report(info->dev, which, attached);
+
 	ret = extcon_set_state_sync(info->edev, which, attached);
 	if (ret != 0)
 		dev_warn(info->dev, "Failed to report cable state: %d\n", ret);
@@ -570,6 +643,10 @@ int madera_jds_set_state(struct madera_extcon *info,
 	int ret = 0;
 
 	if (new_state != info->state) {
+		trace_madera_jds_state(info->dev, madera_jds_get_mode(info),
+				       new_state ? new_state->mode :
+				       MADERA_ACCDET_MODE_INVALID);
+
 		if (info->state)
 			info->state->stop(info);
 
@@ -1011,13 +1088,13 @@ static void madera_extcon_set_mode(struct madera_extcon *info, int mode)
 	info->micd_mode = mode;
 }
 
-static void madera_extcon_next_mode(struct madera_extcon *info)
+static void madera_extcon_change_mode(struct madera_extcon *info,
+				      int new_mode)
 {
 	int old_mode = info->micd_mode;
-	int new_mode;
 	bool change_bias = false;
 
-	new_mode = (old_mode + 1) % info->num_micd_modes;
+	trace_madera_micd_mode(info->dev, new_mode);
 
 	dev_dbg(info->dev, "change micd mode %d->%d (bias %d->%d)\n",
 		old_mode, new_mode,
@@ -1037,6 +1114,43 @@ static void madera_extcon_next_mode(struct madera_extcon *info)
 		madera_extcon_enable_micbias(info);
 }
 
+static void madera_extcon_next_mode(struct madera_extcon *info)
+{
+	madera_extcon_change_mode(info,
+				  (info->micd_mode + 1) % info->num_micd_modes);
+}
+
+/*
+ * Record a low impedance reading for the current mode and move on to the
+ * next unmeasured one. Once every mode has been measured the mode with the
+ * highest impedance is selected, that being the polarity most likely to have
+ * the microphone on the sense pin. Returns true when a decision is made.
+ */
+static bool madera_micd_classify(struct madera_extcon *info,
+				 unsigned int ohms)
+{
+	int i, best = 0;
+
+	info->micd_class_ohms[info->micd_mode] = ohms;
+
+	if (info->micd_class_count < info->num_micd_modes) {
+		madera_extcon_next_mode(info);
+		return false;
+	}
+
+	for (i = 1; i < info->num_micd_modes; i++)
+		if (info->micd_class_ohms[i] > info->micd_class_ohms[best])
+			best = i;
+
+	dev_dbg(info->dev, "MICD classify: mode %d, %u ohms\n",
+		best, info->micd_class_ohms[best]);
+
+	if (best != info->micd_mode)
+		madera_extcon_change_mode(info, best);
+
+	return true;
+}
+
 static int madera_micd_adc_read(struct madera_extcon *info)
 {
 	struct madera *madera = info->madera;
@@ -1083,7 +1197,7 @@ static int madera_micd_read(struct madera_extcon *info)
 			return ret;
 		}
 
-		dev_info(info->dev, "MICDET: 0x%x\n", val);
+		dev_dbg(info->dev, "MICDET: 0x%x\n", val);
 
 		if (!(val & MADERA_MICD_VALID)) {
 			dev_warn(info->dev,
@@ -1131,6 +1245,51 @@ static void madera_extcon_notify_micd(const struct madera_extcon *info,
 	madera_call_notifiers(info->madera, MADERA_NOTIFY_MICDET, &data);
 }
 
+static bool madera_extcon_fast_reinsert_ok(struct madera_extcon *info,
+					   ktime_t now)
+{
+	const struct madera_extcon_accessory *acc = &info->last_acc;
+	unsigned int window = info->pdata->fast_reinsert_ms;
+
+	if (!window || !acc->valid || info->pdata->custom_jd)
+		return false;
+
+	if (ktime_to_ms(ktime_sub(now, acc->removed)) > window)
+		return false;
+
+	dev_dbg(info->dev, "Fast re-insert: expecting %s %d.%02d ohms\n",
+		acc->have_mic ? "headset" : "headphone",
+		acc->hp_imp_x100 / 100, acc->hp_imp_x100 % 100);
+
+	return true;
+}
+
+/* The accessory differs from the last one, fall back to full detection */
+static void madera_extcon_fast_reinsert_miss(struct madera_extcon *info)
+{
+	dev_dbg(info->dev, "Fast re-insert: accessory changed\n");
+
+	info->fast_reinsert = false;
+	info->fast_reinsert_misses++;
+}
+
+static void madera_extcon_save_accessory(struct madera_extcon *info,
+					 int hp_imp_x100)
+{
+	struct madera_extcon_accessory *acc = &info->last_acc;
+
+	if (info->fast_reinsert) {
+		info->fast_reinsert = false;
+		info->fast_reinsert_hits++;
+	}
+
+	acc->have_mic = info->have_mic;
+	acc->micd_mode = info->micd_mode;
+	acc->hpdet_range = info->hpdet_range;
+	acc->hp_imp_x100 = hp_imp_x100;
+	acc->valid = true;
+}
+
 static int madera_hpdet_calc_calibration(const struct madera_extcon *info,
 			int dacval,
 			const struct madera_hpdet_trims *trims,
@@ -1261,6 +1420,8 @@ static int madera_hpdet_read(struct madera_extcon *info)
 	/* The value is in 0.5 ohm increments, get it in hundredths */
 	ohms_x100 = val * 50;
 
+	info->hpdet_range = info->hpdet_init_range;
+
 	if (is_jdx_micdetx_pin)
 		goto done;
 
@@ -1268,14 +1429,33 @@ static int madera_hpdet_read(struct madera_extcon *info)
 	range = (range & MADERA_HP_IMPEDANCE_RANGE_MASK) >>
 		MADERA_HP_IMPEDANCE_RANGE_SHIFT;
 
+	/*
+	 * A fast re-insert measures in the last accessory's range, if the
+	 * reading is below that range start again from the lowest one
+	 */
+	if (info->fast_reinsert && range > info->hpdet_init_range &&
+	    ((val / 2) < info->hpdet_ranges[range].min)) {
+		madera_extcon_fast_reinsert_miss(info);
+		madera_hpdet_lat_step(info);
+		madera_hpdet_restart(info);
+		return -EAGAIN;
+	}
+
 	/* Skip up a range, or report? */
 	if (range < info->num_hpdet_ranges - 1 &&
 	    ((val / 2) >= info->hpdet_ranges[range].max)) {
+		if (info->fast_reinsert)
+			madera_extcon_fast_reinsert_miss(info);
+
 		range++;
 		dev_dbg(info->dev, "Moving to HPDET range %d-%d\n",
 			info->hpdet_ranges[range].min,
 			info->hpdet_ranges[range].max);
 
+		trace_madera_hpdet_range(info->dev, range);
+
+		madera_hpdet_lat_step(info);
+
 		regmap_update_bits(madera->regmap,
 				   MADERA_HEADPHONE_DETECT_1,
 				   MADERA_HP_IMPEDANCE_RANGE_MASK,
@@ -1284,6 +1464,8 @@ static int madera_hpdet_read(struct madera_extcon *info)
 		return -EAGAIN;
 	}
 
+	info->hpdet_range = range;
+
 	if (info->hpdet_trims) {
 		/* Perform calibration */
 		ret = madera_hpdet_calibrate(info, range, &ohms_x100);
@@ -1326,6 +1508,88 @@ done:
 	return (int)ohms_x100;
 }
 
+/*
+ * Write only the registers of a tuning patch that differ from the values in
+ * the register cache. Consecutive changed registers are written as a single
+ * raw transfer, and short gaps of unchanged registers are included in the
+ * transfer when that is cheaper than starting a new one. All the transfers
+ * are queued asynchronously and completed together.
+ */
+static int madera_tune_headphone_patch(struct madera_extcon *info,
+				       const struct reg_sequence *patch,
+				       int patch_len)
+{
+	struct regmap *regmap = info->madera->regmap;
+	bool changed[MADERA_HP_TUNING_MAX_REGS];
+	__be16 *buf;
+	unsigned int val;
+	int i, start, end, last, written = 0;
+	int ret, err;
+
+	if (patch_len > MADERA_HP_TUNING_MAX_REGS ||
+	    regmap_get_val_bytes(regmap) != sizeof(*buf))
+		return regmap_multi_reg_write(regmap, patch, patch_len);
+
+	for (i = 0; i < patch_len; i++) {
+		/* Only simple runs of consecutive registers can be merged */
+		if (patch[i].delay_us ||
+		    (i && patch[i].reg != patch[i - 1].reg + 1))
+			return regmap_multi_reg_write(regmap, patch, patch_len);
+
+		/* Anything not in the cache must be written */
+		ret = regmap_read(regmap, patch[i].reg, &val);
+		changed[i] = ret || val != patch[i].def;
+	}
+
+	/* Must stay valid until the async writes complete */
+	buf = kmalloc_array(patch_len, sizeof(*buf), GFP_KERNEL | GFP_DMA);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < patch_len; i++)
+		buf[i] = cpu_to_be16(patch[i].def);
+
+	ret = 0;
+	for (start = 0; start < patch_len; start = end) {
+		if (!changed[start]) {
+			end = start + 1;
+			continue;
+		}
+
+		last = start;
+		for (end = start + 1; end < patch_len; end++) {
+			if (end - last > MADERA_HP_TUNING_MAX_GAP + 1)
+				break;
+
+			if (changed[end])
+				last = end;
+		}
+		end = last + 1;
+
+		ret = regmap_raw_write_async(regmap, patch[start].reg,
+					     &buf[start],
+					     (end - start) * sizeof(*buf));
+		if (ret)
+			break;
+
+		written += end - start;
+	}
+
+	err = regmap_async_complete(regmap);
+	if (!ret)
+		ret = err;
+
+	kfree(buf);
+
+	if (ret)
+		return ret;
+
+	dev_dbg(info->dev, "HP tuning wrote %d of %d registers\n",
+		written, patch_len);
+
+	return 0;
+}
+
 static int madera_tune_headphone(struct madera_extcon *info, int reading)
 {
 	struct madera *madera = info->madera;
@@ -1367,9 +1631,9 @@ static int madera_tune_headphone(struct madera_extcon *info, int reading)
 
 		info->hp_tuning_level = 1;
 
-		ret = regmap_multi_reg_write(madera->regmap,
-					     tuning[1].patch,
-					     tuning[1].patch_len);
+		ret = madera_tune_headphone_patch(info,
+						  tuning[1].patch,
+						  tuning[1].patch_len);
 		return ret;
 	}
 
@@ -1386,11 +1650,13 @@ static int madera_tune_headphone(struct madera_extcon *info, int reading)
 	if (info->hp_tuning_level != i) {
 		dev_dbg(info->dev, "New tuning level %d\n", i);
 
+		trace_madera_hp_tuning(info->dev, i);
+
 		info->hp_tuning_level = i;
 
-		ret = regmap_multi_reg_write(madera->regmap,
-					     tuning[i].patch,
-					     tuning[i].patch_len);
+		ret = madera_tune_headphone_patch(info,
+						  tuning[i].patch,
+						  tuning[i].patch_len);
 		if (ret) {
 			dev_err(info->dev,
 				"Failed to apply HP tuning %d\n", ret);
@@ -1405,13 +1671,17 @@ void madera_set_headphone_imp(struct madera_extcon *info, int ohms_x100)
 {
 	struct madera *madera = info->madera;
 	struct madera_hpdet_notify_data data;
+	ktime_t start;
 
 	madera->hp_impedance_x100[0] = ohms_x100;
 
 	data.impedance_x100 = ohms_x100;
 	madera_call_notifiers(madera, MADERA_NOTIFY_HPDET, &data);
 
+	start = ktime_get();
 	madera_tune_headphone(info, ohms_x100);
+	if (ktime_to_ns(info->lat_insert))
+		madera_jack_lat_record(info, MADERA_JACK_LAT_TUNING, start);
 }
 EXPORT_SYMBOL_GPL(madera_set_headphone_imp);
 
@@ -1568,6 +1838,13 @@ int madera_hpdet_start(struct madera_extcon *info)
 		break;
 	}
 
+	/* Go straight to the range the last accessory was measured in */
+	if (info->fast_reinsert)
+		regmap_update_bits(madera->regmap, MADERA_HEADPHONE_DETECT_1,
+				   MADERA_HP_IMPEDANCE_RANGE_MASK,
+				   info->last_acc.hpdet_range <<
+				   MADERA_HP_IMPEDANCE_RANGE_SHIFT);
+
 	ret = regmap_update_bits(madera->regmap, MADERA_HEADPHONE_DETECT_1,
 				 MADERA_HP_POLL, MADERA_HP_POLL);
 	if (ret) {
@@ -1575,6 +1852,8 @@ int madera_hpdet_start(struct madera_extcon *info)
 		goto err;
 	}
 
+	info->lat_hpdet_step = ktime_get();
+
 	return 0;
 
 err:
@@ -1635,7 +1914,8 @@ static int madera_hpdet_wait(struct madera_extcon *info)
 		if (val & MADERA_HP_DONE_MASK)
 			return 0;
 
-		msleep(MADERA_HPDONE_PROBE_INTERVAL_MS);
+		usleep_range(MADERA_HPDONE_PROBE_INTERVAL_US,
+			     MADERA_HPDONE_PROBE_INTERVAL_US + 1000);
 	}
 
 	dev_err(madera->dev, "HPDET did not appear to complete\n");
@@ -1689,9 +1969,13 @@ int madera_hpdet_reading(struct madera_extcon *info, int val)
 {
 	dev_dbg(info->dev, "Reading HPDET %d\n", val);
 
+	trace_madera_hpdet_reading(info->dev, val);
+
 	if (val < 0)
 		return val;
 
+	madera_jack_lat_phase_end(info, MADERA_JACK_LAT_HPDET);
+
 	madera_set_headphone_imp(info, val);
 
 	if (!info->have_mic && val > MADERA_HPDET_LINEOUT)
@@ -1699,6 +1983,14 @@ int madera_hpdet_reading(struct madera_extcon *info, int val)
 	else
 		madera_extcon_report(info, EXTCON_JACK_HEADPHONE, true);
 
+	if (ktime_to_ns(info->lat_insert)) {
+		madera_jack_lat_record(info, MADERA_JACK_LAT_TOTAL,
+				       info->lat_insert);
+		info->lat_insert = ktime_set(0, 0);
+	}
+
+	madera_extcon_save_accessory(info, val);
+
 	if (info->have_mic)
 		madera_jds_set_state(info, &madera_micd_button);
 	else
@@ -1917,6 +2209,11 @@ int madera_micd_mic_reading(struct madera_extcon *info, int val)
 
 	ohms = madera_hohm_to_ohm((unsigned int)val);
 
+	if (info->micd_class_ohms) {
+		info->micd_class_count++;
+		info->micd_class_measurements++;
+	}
+
 	/* Due to jack detect this should never happen */
 	if (ohms > MADERA_MICROPHONE_MAX_OHM) {
 		dev_warn(info->dev, "Detected open circuit\n");
@@ -1931,6 +2228,21 @@ int madera_micd_mic_reading(struct madera_extcon *info, int val)
 		goto done;
 	}
 
+	/*
+	 * A re-inserted headphone was already tried in every polarity, but
+	 * the first reading can catch the plug part way in so wait for a
+	 * second low reading before skipping the polarity checks
+	 */
+	if (info->fast_reinsert && !info->last_acc.have_mic) {
+		if (!info->fast_reinsert_confirm) {
+			info->fast_reinsert_confirm = true;
+			return -EAGAIN;
+		}
+
+		dev_dbg(info->dev, "Fast re-insert: headphone\n");
+		goto done;
+	}
+
 	/*
 	 * If we detected a lower impedence during initial startup
 	 * then we probably have the wrong polarity, flip it.  Don't
@@ -1941,6 +2253,17 @@ int madera_micd_mic_reading(struct madera_extcon *info, int val)
 	if (((info->micd_ranges[0].max > MADERA_MICD_WRONG_POLARITY) ||
 	    (ohms > info->micd_ranges[0].max)) &&
 	    info->num_micd_modes > 1) {
+		if (info->fast_reinsert)
+			madera_extcon_fast_reinsert_miss(info);
+
+		if (info->micd_class_ohms) {
+			if (!madera_micd_classify(info, ohms))
+				return -EAGAIN;
+
+			dev_dbg(info->dev, "Classified HP/line\n");
+			goto done;
+		}
+
 		if (info->jack_flips >= info->num_micd_modes * 10) {
 			dev_dbg(info->dev, "Detected HP/line\n");
 			goto done;
@@ -1960,6 +2283,17 @@ int madera_micd_mic_reading(struct madera_extcon *info, int val)
 	dev_dbg(info->dev, "Headphone detected\n");
 
 done:
+	if (info->micd_class_ohms) {
+		info->micd_class_runs++;
+		info->micd_class_max = max_t(u32, info->micd_class_max,
+					     info->micd_class_count);
+	}
+
+	if (info->fast_reinsert && info->have_mic != info->last_acc.have_mic)
+		madera_extcon_fast_reinsert_miss(info);
+
+	madera_jack_lat_phase_end(info, MADERA_JACK_LAT_MICD);
+
 	pm_runtime_mark_last_busy(info->dev);
 
 	if (info->pdata->hpdet_channel)
@@ -1990,6 +2324,8 @@ void madera_micd_mic_timeout(struct madera_extcon *info)
 
 	dev_dbg(info->dev, "MICD timed out, reporting HP\n");
 
+	madera_jack_lat_phase_end(info, MADERA_JACK_LAT_MICD);
+
 	if (info->pdata->hpdet_channel)
 		ret = madera_jds_set_state(info, &madera_hpdet_right);
 	else
@@ -2007,7 +2343,7 @@ static int madera_jack_present(struct madera_extcon *info,
 	unsigned int present, val;
 	int ret;
 
-	ret = regmap_read(madera->regmap, MADERA_IRQ1_RAW_STATUS_7, &val);
+	ret = madera_irq_read_status(madera, MADERA_IRQ1_RAW_STATUS_7, &val);
 	if (ret) {
 		dev_err(info->dev, "Failed to read jackdet status: %d\n", ret);
 		return ret;
@@ -2123,6 +2459,8 @@ static void madera_micd_handler(struct work_struct *work)
 
 	dev_info(info->dev, "Mic impedance %d ohms\n", ret);
 
+	trace_madera_micd_reading(info->dev, ret);
+
 	madera_jds_reading(info, madera_ohm_to_hohm((unsigned int)ret));
 
 out:
@@ -2140,6 +2478,135 @@ spurious:
 	mutex_unlock(&info->lock);
 }
 
+static enum hrtimer_restart madera_button_timer(struct hrtimer *timer)
+{
+	struct madera_extcon *info = container_of(timer, struct madera_extcon,
+						  button_timer);
+
+	kthread_queue_work(info->button_worker, &info->button_work);
+
+	return HRTIMER_NORESTART;
+}
+
+static void madera_button_start_sampling(struct madera_extcon *info)
+{
+	if (info->button_stopping)
+		return;
+
+	info->button_irq_time = ktime_get();
+	info->button_count = 0;
+	info->button_total = 0;
+
+	hrtimer_start(&info->button_timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+}
+
+/*
+ * Sample MICD until enough consecutive readings agree, then report the
+ * button state straight away rather than waiting for further MICD IRQs
+ */
+static void madera_button_work(struct kthread_work *work)
+{
+	struct madera_extcon *info = container_of(work, struct madera_extcon,
+						  button_work);
+	unsigned int samples = info->pdata->micd_button_samples;
+	int val;
+
+	if (!samples)
+		samples = MADERA_BUTTON_DEFAULT_SAMPLES;
+
+	mutex_lock(&info->lock);
+
+	/* Sampling is abandoned if we left button detection */
+	if (info->button_stopping || info->state != &madera_micd_button)
+		goto out;
+
+	val = madera_micd_read(info);
+	if (val < 0)
+		goto out;
+
+	if (info->button_count && val == info->button_sample) {
+		info->button_count++;
+	} else {
+		info->button_sample = val;
+		info->button_count = 1;
+	}
+
+	if (info->button_count >= samples) {
+		if (val != info->micd_res_old) {
+			info->micd_res_old = val;
+			madera_micd_button_process(info, val);
+			madera_jack_lat_record(info, MADERA_JACK_LAT_BUTTON,
+					       info->button_irq_time);
+		}
+		goto out;
+	}
+
+	if (++info->button_total >= MADERA_BUTTON_MAX_SAMPLES) {
+		dev_dbg(info->dev, "Button readings did not settle\n");
+		goto out;
+	}
+
+	hrtimer_start(&info->button_timer,
+		      ns_to_ktime(info->pdata->micd_button_sample_us *
+				  NSEC_PER_USEC),
+		      HRTIMER_MODE_REL);
+
+out:
+	mutex_unlock(&info->lock);
+}
+
+static int madera_button_init_sampling(struct madera_extcon *info)
+{
+	/* Run alongside, not above, the threaded IRQ handlers */
+	struct sched_param param = { .sched_priority = MAX_USER_RT_PRIO / 2 };
+
+	info->button_worker = kthread_create_worker(0, "%s-button",
+						    dev_name(info->dev));
+	if (IS_ERR(info->button_worker)) {
+		int ret = PTR_ERR(info->button_worker);
+
+		info->button_worker = NULL;
+		return ret;
+	}
+
+	sched_setscheduler(info->button_worker->task, SCHED_FIFO, &param);
+
+	kthread_init_work(&info->button_work, madera_button_work);
+	hrtimer_init(&info->button_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	info->button_timer.function = madera_button_timer;
+
+	return 0;
+}
+
+static void madera_button_free_sampling(struct madera_extcon *info)
+{
+	if (!info->button_worker)
+		return;
+
+	/* Stop the work re-arming the timer before the worker goes away */
+	mutex_lock(&info->lock);
+	info->button_stopping = true;
+	mutex_unlock(&info->lock);
+
+	hrtimer_cancel(&info->button_timer);
+	kthread_destroy_worker(info->button_worker);
+	hrtimer_cancel(&info->button_timer);
+	info->button_worker = NULL;
+}
+
+/*
+ * Called without info->lock once the jack has been removed, the work sees
+ * the state has changed so a sample already in progress won't re-arm
+ */
+static void madera_button_cancel_sampling(struct madera_extcon *info)
+{
+	if (!info->button_worker)
+		return;
+
+	hrtimer_cancel(&info->button_timer);
+	kthread_cancel_work_sync(&info->button_work);
+}
+
 static irqreturn_t madera_micdet(int irq, void *data)
 {
 	struct madera_extcon *info = data;
@@ -2151,6 +2618,12 @@ static irqreturn_t madera_micdet(int irq, void *data)
 
 	mutex_lock(&info->lock);
 
+	if (info->button_worker && info->state == &madera_micd_button) {
+		madera_button_start_sampling(info);
+		mutex_unlock(&info->lock);
+		return IRQ_HANDLED;
+	}
+
 	if (!info->detecting)
 		debounce = 0;
 
@@ -2221,20 +2694,23 @@ static irqreturn_t madera_jackdet(int irq, void *data)
 	unsigned int val, mask;
 	bool cancelled_state;
 	int i, present;
+	ktime_t irq_time = ktime_get();
 
 	dev_info(info->dev, "jackdet IRQ");
 
 	cancelled_state = madera_jds_cancel_timeout(info);
 
-	pm_runtime_get_sync(info->dev);
-
 	mutex_lock(&info->lock);
 
+	/*
+	 * The jack status is read before taking a runtime reference so that
+	 * a bounce can be suppressed while the codec stays asleep when the
+	 * IRQ is serviced from the light wake path.
+	 */
 	val = 0;
 	present = madera_jack_present(info, &val);
 	if (present < 0) {
 		mutex_unlock(&info->lock);
-		pm_runtime_put_autosuspend(info->dev);
 		return IRQ_NONE;
 	}
 
@@ -2243,10 +2719,15 @@ static irqreturn_t madera_jackdet(int irq, void *data)
 		if (cancelled_state)
 			madera_jds_start_timeout(info);
 
-		goto out;
+		mutex_unlock(&info->lock);
+		return IRQ_HANDLED;
 	}
 	info->last_jackdet = val;
 
+	pm_runtime_get_sync(info->dev);
+
+	trace_madera_jackdet(info->dev, present);
+
 	mask = MADERA_MICD_CLAMP_DB | MADERA_JD1_DB;
 
 	if (info->pdata->jd_use_jd2)
@@ -2259,13 +2740,27 @@ static irqreturn_t madera_jackdet(int irq, void *data)
 
 		info->have_mic = false;
 		info->jack_flips = 0;
+		info->micd_class_count = 0;
+
+		info->lat_insert = irq_time;
+		info->lat_phase = irq_time;
+
+		info->fast_reinsert = madera_extcon_fast_reinsert_ok(info,
+								     irq_time);
+		info->fast_reinsert_confirm = false;
+		if (info->fast_reinsert)
+			madera_extcon_set_mode(info, info->last_acc.micd_mode);
+		info->last_acc.valid = false;
 
 		if (info->pdata->init_mic_delay_ms)
 			msleep(info->pdata->init_mic_delay_ms);
 
+		madera_jack_lat_phase_end(info, MADERA_JACK_LAT_DEBOUNCE);
+
 		if (info->pdata->custom_jd)
 			madera_jds_set_state(info, info->pdata->custom_jd);
-		else if (info->pdata->micd_software_compare)
+		else if (info->pdata->micd_software_compare ||
+			 info->pdata->micd_classify)
 			madera_jds_set_state(info, &madera_micd_adc_mic);
 		else
 			madera_jds_set_state(info, &madera_micd_microphone);
@@ -2278,6 +2773,9 @@ static irqreturn_t madera_jackdet(int irq, void *data)
 		dev_dbg(info->dev, "Detected jack removal\n");
 
 		info->have_mic = false;
+		info->lat_insert = ktime_set(0, 0);
+		info->fast_reinsert = false;
+		info->last_acc.removed = irq_time;
 		info->micd_res_old = 0;
 		info->micd_debounce = 0;
 		info->micd_count = 0;
@@ -2300,15 +2798,130 @@ static irqreturn_t madera_jackdet(int irq, void *data)
 		madera_set_magic_bit(info, false);
 	}
 
-out:
 	mutex_unlock(&info->lock);
 
+	if (!present)
+		madera_button_cancel_sampling(info);
+
 	pm_runtime_mark_last_busy(info->dev);
 	pm_runtime_put_autosuspend(info->dev);
 
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int madera_jack_lat_show(struct seq_file *s, void *data)
+{
+	struct madera_extcon *info = s->private;
+	const struct madera_jack_lat_hist *hist;
+	int i, j;
+
+	mutex_lock(&info->lock);
+
+	for (i = 0; i < MADERA_JACK_LAT_NUM_PHASES; i++) {
+		hist = &info->lat_hist[i];
+
+		seq_printf(s, "%s: count=%u avg_us=%llu max_us=%u\n",
+			   madera_jack_lat_names[i], hist->count,
+			   hist->count ? div_u64(hist->total_us, hist->count) : 0,
+			   hist->max_us);
+
+		for (j = 0; j < MADERA_JACK_LAT_NUM_BUCKETS; j++) {
+			if (!hist->bucket[j])
+				continue;
+
+			seq_printf(s, "  >=%ums: %u\n",
+				   j ? 1 << (j - 1) : 0, hist->bucket[j]);
+		}
+	}
+
+	mutex_unlock(&info->lock);
+
+	return 0;
+}
+
+static int madera_jack_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, madera_jack_lat_show, inode->i_private);
+}
+
+/* Any write clears the histograms */
+static ssize_t madera_jack_lat_write(struct file *file,
+				     const char __user *user_buf,
+				     size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct madera_extcon *info = s->private;
+
+	mutex_lock(&info->lock);
+	memset(info->lat_hist, 0, sizeof(info->lat_hist));
+	mutex_unlock(&info->lock);
+
+	return count;
+}
+
+static const struct file_operations madera_jack_lat_fops = {
+	.open = madera_jack_lat_open,
+	.read = seq_read,
+	.write = madera_jack_lat_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void madera_extcon_init_debugfs(struct madera_extcon *info)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir(dev_name(info->dev), NULL);
+	if (IS_ERR_OR_NULL(root))
+		goto err;
+
+	if (!debugfs_create_file("jack_latency", 0644, root, info,
+				 &madera_jack_lat_fops))
+		goto err;
+
+	if (!debugfs_create_u32("fast_reinsert_hits", 0444, root,
+				&info->fast_reinsert_hits))
+		goto err;
+
+	if (!debugfs_create_u32("fast_reinsert_misses", 0444, root,
+				&info->fast_reinsert_misses))
+		goto err;
+
+	if (!debugfs_create_u32("micd_classify_runs", 0444, root,
+				&info->micd_class_runs))
+		goto err;
+
+	if (!debugfs_create_u32("micd_classify_measurements", 0444, root,
+				&info->micd_class_measurements))
+		goto err;
+
+	if (!debugfs_create_u32("micd_classify_max", 0444, root,
+				&info->micd_class_max))
+		goto err;
+
+	info->debugfs_root = root;
+	return;
+
+err:
+	debugfs_remove_recursive(root);
+	dev_warn(info->dev, "Failed to create debugfs\n");
+}
+
+static void madera_extcon_cleanup_debugfs(struct madera_extcon *info)
+{
+	debugfs_remove_recursive(info->debugfs_root);
+}
+#else
+static inline void madera_extcon_init_debugfs(struct madera_extcon *info)
+{
+}
+
+static inline void madera_extcon_cleanup_debugfs(struct madera_extcon *info)
+{
+}
+#endif
+
 /* Map a level onto a slot in the register bank */
 static void madera_micd_set_level(struct madera *madera, int index,
 				  unsigned int level)
@@ -2500,6 +3113,12 @@ static void madera_extcon_process_accdet_node(struct madera_extcon *info,
 	fwnode_property_read_u32(node, "cirrus,micd-manual-debounce",
 				 &pdata->micd_manual_debounce);
 
+	fwnode_property_read_u32(node, "cirrus,micd-button-sample-us",
+				 &pdata->micd_button_sample_us);
+
+	fwnode_property_read_u32(node, "cirrus,micd-button-samples",
+				 &pdata->micd_button_samples);
+
 	fwnode_property_read_u32(node, "cirrus,micd-bias-start-time",
 				 &pdata->micd_bias_start_time);
 
@@ -2512,6 +3131,9 @@ static void madera_extcon_process_accdet_node(struct madera_extcon *info,
 	fwnode_property_read_u32(node, "cirrus,micd-timeout-ms",
 				 &pdata->micd_timeout_ms);
 
+	fwnode_property_read_u32(node, "cirrus,fast-reinsert-ms",
+				 &pdata->fast_reinsert_ms);
+
 	/* don't override any preset force_micbias enable */
 	if (fwnode_property_present(node, "cirrus,micd-force-micbias"))
 		pdata->micd_force_micbias = true;
@@ -2520,6 +3142,9 @@ static void madera_extcon_process_accdet_node(struct madera_extcon *info,
 		fwnode_property_present(node,
 					"cirrus,micd-software-compare");
 
+	pdata->micd_classify =
+		fwnode_property_present(node, "cirrus,micd-classify");
+
 	pdata->micd_open_circuit_declare =
 		fwnode_property_present(node,
 					"cirrus,micd-open-circuit-declare");
@@ -2671,14 +3296,18 @@ static void madera_extcon_dump_config(struct madera_extcon *info)
 		MADERA_EXTCON_PDATA_DUMP(hpdet_channel, "%d");
 		MADERA_EXTCON_PDATA_DUMP(micd_detect_debounce_ms, "%d");
 		MADERA_EXTCON_PDATA_DUMP(micd_manual_debounce, "%d");
+		MADERA_EXTCON_PDATA_DUMP(micd_button_sample_us, "%u");
+		MADERA_EXTCON_PDATA_DUMP(micd_button_samples, "%u");
 		MADERA_EXTCON_PDATA_DUMP(micd_bias_start_time, "%d");
 		MADERA_EXTCON_PDATA_DUMP(micd_rate, "%d");
 		MADERA_EXTCON_PDATA_DUMP(micd_dbtime, "%d");
 		MADERA_EXTCON_PDATA_DUMP(micd_timeout_ms, "%d");
+		MADERA_EXTCON_PDATA_DUMP(fast_reinsert_ms, "%u");
 		MADERA_EXTCON_PDATA_DUMP(micd_clamp_mode, "%u");
 		MADERA_EXTCON_PDATA_DUMP(micd_force_micbias, "%u");
 		MADERA_EXTCON_PDATA_DUMP(micd_open_circuit_declare, "%u");
 		MADERA_EXTCON_PDATA_DUMP(micd_software_compare, "%u");
+		MADERA_EXTCON_PDATA_DUMP(micd_classify, "%u");
 
 		if (info->micd_pol_gpio[0] > 0)
 			dev_dbg(info->dev, "micd_pol_gpio: %d\n",
@@ -3149,6 +3778,17 @@ static int madera_extcon_probe(struct platform_device *pdev)
 
 	madera_extcon_set_mode(info, 0);
 
+	if (pdata->micd_classify) {
+		info->micd_class_ohms = devm_kcalloc(&pdev->dev,
+						     info->num_micd_modes,
+						     sizeof(*info->micd_class_ohms),
+						     GFP_KERNEL);
+		if (!info->micd_class_ohms) {
+			ret = -ENOMEM;
+			goto err_input;
+		}
+	}
+
 	/*
 	 * Invalidate the tuning level so that the first detection
 	 * will always apply a tuning
@@ -3193,6 +3833,14 @@ static int madera_extcon_probe(struct platform_device *pdev)
 		goto err_input;
 	}
 
+	if (pdata->micd_button_sample_us) {
+		ret = madera_button_init_sampling(info);
+		if (ret)
+			dev_warn(&pdev->dev,
+				 "Failed to start button sampling thread: %d\n",
+				 ret);
+	}
+
 	ret = madera_request_irq(madera, MADERA_IRQ_MICDET1,
 				 "MICDET", madera_micdet, info);
 	if (ret) {
@@ -3253,6 +3901,10 @@ static int madera_extcon_probe(struct platform_device *pdev)
 		goto err_fall;
 	}
 
+	/* Jack bounces can be filtered without resuming the codec */
+	madera_set_irq_light_wake(madera, jack_irq_rise, 1);
+	madera_set_irq_light_wake(madera, jack_irq_fall, 1);
+
 	ret = regulator_allow_bypass(info->micvdd, true);
 	if (ret)
 		dev_warn(info->dev,
@@ -3289,6 +3941,8 @@ static int madera_extcon_probe(struct platform_device *pdev)
 
 	madera_extcon_dump_config(info);
 
+	madera_extcon_init_debugfs(info);
+
 	if (info->usbc_headset_support) {
 		info->psy_nb.notifier_call = madera_psy_notifier;
 		power_supply_reg_notifier(&info->psy_nb);
@@ -3299,6 +3953,8 @@ static int madera_extcon_probe(struct platform_device *pdev)
 	return 0;
 
 err_fall_wake:
+	madera_set_irq_light_wake(madera, jack_irq_rise, 0);
+	madera_set_irq_light_wake(madera, jack_irq_fall, 0);
 	madera_set_irq_wake(madera, jack_irq_fall, 0);
 err_fall:
 	madera_free_irq(madera, jack_irq_fall, info);
@@ -3311,6 +3967,7 @@ err_hpdet:
 err_micdet:
 	madera_free_irq(madera, MADERA_IRQ_MICDET1, info);
 err_input:
+	madera_button_free_sampling(info);
 err_register:
 	pm_runtime_disable(&pdev->dev);
 
@@ -3342,15 +3999,19 @@ static int madera_extcon_remove(struct platform_device *pdev)
 		jack_irq_fall = MADERA_IRQ_JD1_FALL;
 	}
 
+	madera_set_irq_light_wake(madera, jack_irq_rise, 0);
+	madera_set_irq_light_wake(madera, jack_irq_fall, 0);
 	madera_set_irq_wake(madera, jack_irq_rise, 0);
 	madera_set_irq_wake(madera, jack_irq_fall, 0);
 	madera_free_irq(madera, MADERA_IRQ_HPDET, info);
 	madera_free_irq(madera, MADERA_IRQ_MICDET1, info);
 	madera_free_irq(madera, jack_irq_rise, info);
 	madera_free_irq(madera, jack_irq_fall, info);
+	madera_button_free_sampling(info);
 	regmap_update_bits(madera->regmap, MADERA_JACK_DETECT_ANALOGUE,
 			   MADERA_JD1_ENA | MADERA_JD2_ENA, 0);
 
+	madera_extcon_cleanup_debugfs(info);
 	device_remove_file(&pdev->dev, &dev_attr_hp1_impedance);
 	kfree(info->hpdet_trims);
 
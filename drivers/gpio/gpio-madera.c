@@ -12,15 +12,27 @@
 #include <linux/gpio.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/platform_device.h>
 
 #include <linux/mfd/madera/core.h>
 #include <linux/mfd/madera/pdata.h>
 #include <linux/mfd/madera/registers.h>
 
+/*
+ * Each GPIO has a pair of control registers so pins that are close together
+ * are cheaper to read in one run than in separate transactions
+ */
+#define MADERA_GPIO_MAX_GAP		4
+#define MADERA_GPIO_MAX_REGS		(2 * CS47L85_NUM_GPIOS)
+
 struct madera_gpio {
 	struct madera *madera;
 	struct gpio_chip gpio_chip;
+
+	/* Serialises the read-modify-write of a run of control registers */
+	struct mutex lock;
+	u16 regs[MADERA_GPIO_MAX_REGS];
 };
 
 static int madera_gpio_get_direction(struct gpio_chip *chip,
@@ -43,10 +55,15 @@ static int madera_gpio_direction_in(struct gpio_chip *chip, unsigned int offset)
 {
 	struct madera_gpio *madera_gpio = gpiochip_get_data(chip);
 	struct madera *madera = madera_gpio->madera;
+	int ret;
+
+	mutex_lock(&madera_gpio->lock);
+	ret = regmap_update_bits(madera->regmap,
+				 MADERA_GPIO1_CTRL_2 + (2 * offset),
+				 MADERA_GP1_DIR_MASK, MADERA_GP1_DIR);
+	mutex_unlock(&madera_gpio->lock);
 
-	return regmap_update_bits(madera->regmap,
-				  MADERA_GPIO1_CTRL_2 + (2 * offset),
-				  MADERA_GP1_DIR_MASK, MADERA_GP1_DIR);
+	return ret;
 }
 
 static int madera_gpio_get(struct gpio_chip *chip, unsigned int offset)
@@ -69,23 +86,30 @@ static int madera_gpio_direction_out(struct gpio_chip *chip,
 {
 	struct madera_gpio *madera_gpio = gpiochip_get_data(chip);
 	struct madera *madera = madera_gpio->madera;
-	unsigned int regval;
+	unsigned int reg = MADERA_GPIO1_CTRL_1 + (2 * offset);
 	int ret;
 
+	mutex_lock(&madera_gpio->lock);
+
+	/* Both registers are cached so this read doesn't touch the bus */
+	ret = regmap_bulk_read(madera->regmap, reg, madera_gpio->regs, 2);
+	if (ret < 0)
+		goto out;
+
 	if (value)
-		regval = MADERA_GP1_LVL;
+		madera_gpio->regs[0] |= MADERA_GP1_LVL;
 	else
-		regval = 0;
+		madera_gpio->regs[0] &= ~MADERA_GP1_LVL_MASK;
 
-	ret = regmap_update_bits(madera->regmap,
-				 MADERA_GPIO1_CTRL_2 + (2 * offset),
-				 MADERA_GP1_DIR_MASK, 0);
-	if (ret < 0)
-		return ret;
+	madera_gpio->regs[1] &= ~MADERA_GP1_DIR_MASK;
+
+	/* Level and direction in one write, level lands first */
+	ret = regmap_bulk_write(madera->regmap, reg, madera_gpio->regs, 2);
+
+out:
+	mutex_unlock(&madera_gpio->lock);
 
-	return regmap_update_bits(madera->regmap,
-				  MADERA_GPIO1_CTRL_1 + (2 * offset),
-				  MADERA_GP1_LVL_MASK, regval);
+	return ret;
 }
 
 static void madera_gpio_set(struct gpio_chip *chip, unsigned int offset,
@@ -101,22 +125,150 @@ static void madera_gpio_set(struct gpio_chip *chip, unsigned int offset,
 	else
 		regval = 0;
 
+	mutex_lock(&madera_gpio->lock);
 	ret = regmap_update_bits(madera->regmap,
 				 MADERA_GPIO1_CTRL_1 + (2 * offset),
 				 MADERA_GP1_LVL_MASK, regval);
+	mutex_unlock(&madera_gpio->lock);
 	if (ret)
 		dev_warn(madera->dev, "Failed to write to 0x%x (%d)\n",
 			 MADERA_GPIO1_CTRL_1 + (2 * offset), ret);
 }
 
+/*
+ * Find the next run of pins in mask that can be handled in one transfer,
+ * allowing up to max_gap - 1 pins that are not in mask between them
+ */
+static bool madera_gpio_next_run(struct gpio_chip *chip, unsigned long *mask,
+				 unsigned int max_gap, unsigned int *start,
+				 unsigned int *first, unsigned int *last)
+{
+	unsigned int i;
+
+	*first = find_next_bit(mask, chip->ngpio, *start);
+	if (*first >= chip->ngpio)
+		return false;
+
+	*last = *first;
+	for (i = *first + 1; i < chip->ngpio; i++) {
+		if (i - *last > max_gap)
+			break;
+
+		if (test_bit(i, mask))
+			*last = i;
+	}
+
+	*start = *last + 1;
+
+	return true;
+}
+
+static int madera_gpio_get_multiple(struct gpio_chip *chip,
+				    unsigned long *mask, unsigned long *bits)
+{
+	struct madera_gpio *madera_gpio = gpiochip_get_data(chip);
+	struct madera *madera = madera_gpio->madera;
+	unsigned int start = 0, first, last, i;
+	int ret = 0;
+
+	mutex_lock(&madera_gpio->lock);
+
+	while (madera_gpio_next_run(chip, mask, MADERA_GPIO_MAX_GAP,
+				    &start, &first, &last)) {
+		ret = regmap_bulk_read(madera->regmap,
+				       MADERA_GPIO1_CTRL_1 + (2 * first),
+				       madera_gpio->regs,
+				       2 * (last - first + 1));
+		if (ret < 0)
+			break;
+
+		for (i = first; i <= last; i++) {
+			if (!test_bit(i, mask))
+				continue;
+
+			if (madera_gpio->regs[2 * (i - first)] &
+			    MADERA_GP1_LVL_MASK)
+				set_bit(i, bits);
+			else
+				clear_bit(i, bits);
+		}
+	}
+
+	mutex_unlock(&madera_gpio->lock);
+
+	return ret;
+}
+
+/*
+ * Update the levels of a run of adjacent pins with a single bulk write so
+ * that they all change together. The control registers are cached so the
+ * read back of the run doesn't touch the bus. Only runs made up entirely of
+ * requested pins are written this way, so no other pin's registers are
+ * rewritten, and lone pins only have their level bit updated.
+ */
+static void madera_gpio_set_multiple(struct gpio_chip *chip,
+				     unsigned long *mask, unsigned long *bits)
+{
+	struct madera_gpio *madera_gpio = gpiochip_get_data(chip);
+	struct madera *madera = madera_gpio->madera;
+	unsigned int start = 0, first, last, i, reg;
+	u16 *regval;
+	int ret;
+
+	mutex_lock(&madera_gpio->lock);
+
+	while (madera_gpio_next_run(chip, mask, 1, &start, &first, &last)) {
+		reg = MADERA_GPIO1_CTRL_1 + (2 * first);
+
+		if (first == last) {
+			ret = regmap_update_bits(madera->regmap, reg,
+						 MADERA_GP1_LVL_MASK,
+						 test_bit(first, bits) ?
+						 MADERA_GP1_LVL : 0);
+			if (ret < 0)
+				goto err;
+			continue;
+		}
+
+		ret = regmap_bulk_read(madera->regmap, reg, madera_gpio->regs,
+				       2 * (last - first + 1));
+		if (ret < 0)
+			goto err;
+
+		for (i = first; i <= last; i++) {
+			regval = &madera_gpio->regs[2 * (i - first)];
+			if (test_bit(i, bits))
+				*regval |= MADERA_GP1_LVL;
+			else
+				*regval &= ~MADERA_GP1_LVL_MASK;
+		}
+
+		/* The last CTRL_2 of the run doesn't need rewriting */
+		ret = regmap_bulk_write(madera->regmap, reg, madera_gpio->regs,
+					(2 * (last - first)) + 1);
+		if (ret < 0)
+			goto err;
+	}
+
+	mutex_unlock(&madera_gpio->lock);
+
+	return;
+
+err:
+	mutex_unlock(&madera_gpio->lock);
+	dev_warn(madera->dev, "Failed to write to 0x%x (%d)\n", reg, ret);
+}
+
 static struct gpio_chip template_chip = {
 	.label			= "madera",
 	.owner			= THIS_MODULE,
 	.get_direction		= madera_gpio_get_direction,
 	.direction_input	= madera_gpio_direction_in,
 	.get			= madera_gpio_get,
+	.get_multiple		= madera_gpio_get_multiple,
 	.direction_output	= madera_gpio_direction_out,
 	.set			= madera_gpio_set,
+	.set_multiple		= madera_gpio_set_multiple,
 	.can_sleep		= true,
 };
 
@@ -133,6 +285,7 @@ static int madera_gpio_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	madera_gpio->madera = madera;
+	mutex_init(&madera_gpio->lock);
 	madera_gpio->gpio_chip = template_chip;
 	madera_gpio->gpio_chip.parent = &pdev->dev;
 
@@ -156,6 +309,9 @@ static int madera_gpio_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
+	if (WARN_ON(2 * madera_gpio->gpio_chip.ngpio > MADERA_GPIO_MAX_REGS))
+		return -EINVAL;
+
 	if (pdata && pdata->gpio_base)
 		madera_gpio->gpio_chip.base = pdata->gpio_base;
 	else
@@ -9,11 +9,17 @@
  */
 
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/gpio.h>
 #include <linux/interrupt.h>
 #include <linux/irq.h>
 #include <linux/irqdomain.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
 #include <linux/pm_runtime.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 #include <linux/regmap.h>
 #include <linux/slab.h>
 #include <linux/of.h>
@@ -28,6 +34,16 @@
 
 #include "irq-madera.h"
 
+#define MADERA_IRQ_MAX_REGS		33
+#define MADERA_IRQ_NUM_BUCKETS		16
+
+struct madera_irq_stats {
+	unsigned int count;
+	unsigned int max_us;
+	u64 total_us;
+	unsigned int bucket[MADERA_IRQ_NUM_BUCKETS];
+};
+
 struct madera_irq_priv {
 	struct device *dev;
 	unsigned int irq_sem;
@@ -37,6 +53,30 @@ struct madera_irq_priv {
 	struct regmap_irq_chip_data *irq_data;
 	struct irq_domain *domain;
 	struct madera *madera;
+	const struct regmap_irq_chip *chip;
+
+	/* Batched dispatch, snapshot is only valid for dispatch_task */
+	bool batched;
+	struct task_struct *dispatch_task;
+	u16 status[MADERA_IRQ_MAX_REGS];
+	u16 raw_status[MADERA_IRQ_MAX_REGS];
+	u16 mask[MADERA_IRQ_MAX_REGS];
+
+	/* Light wake, service always-on sources without a full resume */
+	bool light_wake;
+	DECLARE_BITMAP(light_irqs, MADERA_NUM_IRQ);
+	ktime_t irq_time;
+
+	struct mutex stats_lock;
+	unsigned int thread_loops;
+	unsigned int light_wakes;
+	unsigned int light_promotions;
+	unsigned int handler_resumes;
+	unsigned int resumes_avoided;
+	struct madera_irq_stats thread_stats;
+	struct madera_irq_stats wake_stats[2];
+	struct madera_irq_stats stats[MADERA_NUM_IRQ];
+	struct dentry *debugfs_root;
 };
 
 int madera_request_irq(struct madera *madera, int irq, const char *name,
@@ -90,14 +130,303 @@ int madera_set_irq_wake(struct madera *madera, int irq, int on)
 }
 EXPORT_SYMBOL_GPL(madera_set_irq_wake);
 
+/*
+ * Mark an IRQ as serviceable while the codec is runtime suspended. Its
+ * handler must only use madera_irq_read_status() and take its own runtime
+ * PM reference before touching anything else on the chip.
+ */
+int madera_set_irq_light_wake(struct madera *madera, int irq, int on)
+{
+	struct madera_irq_priv *priv;
+
+	if (irq < 0)
+		return irq;
+
+	if (irq >= MADERA_NUM_IRQ || !madera->irq_dev)
+		return -EINVAL;
+
+	priv = dev_get_drvdata(madera->irq_dev);
+
+	if (on)
+		set_bit(irq, priv->light_irqs);
+	else
+		clear_bit(irq, priv->light_irqs);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_set_irq_light_wake);
+
+/*
+ * Read an IRQ1 status or raw status register. When called from a nested
+ * handler during batched dispatch the value comes from the snapshot taken
+ * for that dispatch instead of going back to the bus.
+ */
+int madera_irq_read_status(struct madera *madera, unsigned int reg,
+			   unsigned int *val)
+{
+	struct madera_irq_priv *priv = NULL;
+	unsigned int num_regs;
+
+	if (madera->irq_dev)
+		priv = dev_get_drvdata(madera->irq_dev);
+
+	if (priv && READ_ONCE(priv->dispatch_task) == current) {
+		num_regs = priv->chip->num_regs;
+
+		if (reg >= priv->chip->status_base &&
+		    reg < priv->chip->status_base + num_regs) {
+			*val = priv->status[reg - priv->chip->status_base];
+			return 0;
+		}
+
+		if (reg >= MADERA_IRQ1_RAW_STATUS_1 &&
+		    reg < MADERA_IRQ1_RAW_STATUS_1 + num_regs) {
+			*val = priv->raw_status[reg - MADERA_IRQ1_RAW_STATUS_1];
+			return 0;
+		}
+	}
+
+	return regmap_read(madera->regmap, reg, val);
+}
+EXPORT_SYMBOL_GPL(madera_irq_read_status);
+
+static void madera_irq_stats_record(struct madera_irq_priv *priv,
+				    struct madera_irq_stats *stats,
+				    ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket;
+
+	if (us < 0)
+		us = 0;
+
+	bucket = fls((unsigned int)us);
+	if (bucket >= MADERA_IRQ_NUM_BUCKETS)
+		bucket = MADERA_IRQ_NUM_BUCKETS - 1;
+
+	mutex_lock(&priv->stats_lock);
+	stats->count++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+	stats->bucket[bucket]++;
+	mutex_unlock(&priv->stats_lock);
+}
+
+/*
+ * Read every status bank in one transfer and ack the pending, unmasked bits
+ * in another. The masks always come from the main register map's cache so
+ * reading them doesn't touch the bus. Returns true if there is anything to
+ * dispatch.
+ */
+static bool madera_irq_read_snapshot(struct madera_irq_priv *priv,
+				     struct regmap *regmap, u16 *ack)
+{
+	const struct regmap_irq_chip *chip = priv->chip;
+	unsigned int num_regs = chip->num_regs;
+	int first = -1, last = -1;
+	int i, ret;
+
+	ret = regmap_bulk_read(regmap, chip->status_base, priv->status,
+			       num_regs);
+	if (ret) {
+		dev_err(priv->dev, "Failed to read IRQ status: %d\n", ret);
+		return false;
+	}
+
+	ret = regmap_bulk_read(priv->madera->regmap, chip->mask_base,
+			       priv->mask, num_regs);
+	if (ret) {
+		dev_err(priv->dev, "Failed to read IRQ masks: %d\n", ret);
+		return false;
+	}
+
+	ret = regmap_bulk_read(regmap, MADERA_IRQ1_RAW_STATUS_1,
+			       priv->raw_status, num_regs);
+	if (ret) {
+		dev_err(priv->dev, "Failed to read IRQ raw status: %d\n", ret);
+		return false;
+	}
+
+	for (i = 0; i < num_regs; i++) {
+		ack[i] = priv->status[i] & ~priv->mask[i];
+		if (ack[i]) {
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+
+	if (first < 0)
+		return false;
+
+	ret = regmap_bulk_write(regmap, chip->ack_base + first, &ack[first],
+				last - first + 1);
+	if (ret)
+		dev_err(priv->dev, "Failed to ack IRQ status: %d\n", ret);
+
+	return true;
+}
+
+static inline bool madera_irq_snapshot_pending(struct madera_irq_priv *priv,
+					       const u16 *ack, int irq)
+{
+	const struct regmap_irq *src = &priv->chip->irqs[irq];
+
+	return src->mask && (ack[src->reg_offset] & src->mask);
+}
+
+static void madera_irq_dispatch_snapshot(struct madera_irq_priv *priv,
+					 const u16 *ack)
+{
+	ktime_t start;
+	int i;
+
+	WRITE_ONCE(priv->dispatch_task, current);
+
+	for (i = 0; i < priv->chip->num_irqs && i < MADERA_NUM_IRQ; i++) {
+		if (!madera_irq_snapshot_pending(priv, ack, i))
+			continue;
+
+		start = ktime_get();
+		handle_nested_irq(regmap_irq_get_virq(priv->irq_data, i));
+		madera_irq_stats_record(priv, &priv->stats[i], start);
+	}
+
+	WRITE_ONCE(priv->dispatch_task, NULL);
+}
+
+/*
+ * Dispatch the pending sources directly instead of letting regmap-irq read
+ * and ack the status one register at a time.
+ */
+static void madera_irq_dispatch_batched(struct madera_irq_priv *priv)
+{
+	u16 ack[MADERA_IRQ_MAX_REGS];
+
+	if (madera_irq_read_snapshot(priv, priv->madera->regmap, ack))
+		madera_irq_dispatch_snapshot(priv, ack);
+}
+
+static bool madera_irq_snapshot_is_light(struct madera_irq_priv *priv,
+					 const u16 *ack)
+{
+	int i;
+
+	for (i = 0; i < priv->chip->num_irqs && i < MADERA_NUM_IRQ; i++) {
+		if (madera_irq_snapshot_pending(priv, ack, i) &&
+		    !test_bit(i, priv->light_irqs))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Service the IRQ without resuming the codec, only the always-on status
+ * registers are touched. If any pending source hasn't been marked as light
+ * the codec is fully resumed before dispatching. Returns false if the codec
+ * wasn't suspended so the normal path must be used.
+ */
+static bool madera_irq_light_wake(struct madera_irq_priv *priv)
+{
+	struct madera *madera = priv->madera;
+	u16 ack[MADERA_IRQ_MAX_REGS];
+	bool pending;
+	int ret;
+
+	if (madera_light_wake_begin(madera))
+		return false;
+
+	pending = madera_irq_read_snapshot(priv, madera->regmap_light_wake,
+					   ack);
+
+	madera_light_wake_end(madera);
+
+	priv->light_wakes++;
+
+	if (!pending)
+		goto avoided;
+
+	if (madera_irq_snapshot_is_light(priv, ack)) {
+		madera_irq_dispatch_snapshot(priv, ack);
+
+		/* A handler may have needed the rest of the chip after all */
+		if (!pm_runtime_status_suspended(madera->dev)) {
+			priv->handler_resumes++;
+			return true;
+		}
+
+		goto avoided;
+	}
+
+	priv->light_promotions++;
+
+	ret = pm_runtime_get_sync(madera->dev);
+	if (ret < 0) {
+		dev_err(priv->dev, "Failed to resume device: %d\n", ret);
+		pm_runtime_put_noidle(madera->dev);
+		return true;
+	}
+
+	madera_irq_dispatch_snapshot(priv, ack);
+
+	pm_runtime_mark_last_busy(madera->dev);
+	pm_runtime_put_autosuspend(madera->dev);
+
+	return true;
+
+avoided:
+	priv->resumes_avoided++;
+	return true;
+}
+
+/*
+ * Poll the IRQ pin status to see if we're really done
+ * if the interrupt controller can't do it for us.
+ */
+static bool madera_irq_still_asserted(struct madera_irq_priv *priv)
+{
+	if (!gpio_is_valid(priv->irq_gpio))
+		return false;
+
+	if (priv->irq_flags & IRQF_TRIGGER_RISING &&
+	    gpio_get_value_cansleep(priv->irq_gpio))
+		return true;
+
+	if (priv->irq_flags & IRQF_TRIGGER_FALLING &&
+	    !gpio_get_value_cansleep(priv->irq_gpio))
+		return true;
+
+	return false;
+}
+
+static irqreturn_t madera_irq_hardirq(int irq, void *data)
+{
+	struct madera_irq_priv *priv = data;
+
+	priv->irq_time = ktime_get();
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t madera_irq_thread(int irq, void *data)
 {
 	struct madera_irq_priv *priv = data;
-	bool poll;
+	ktime_t start = ktime_get();
+	bool light = false;
 	int ret;
 
 	dev_dbg(priv->dev, "irq_thread handler\n");
 
+	if (priv->light_wake && madera_irq_light_wake(priv)) {
+		priv->thread_loops++;
+		light = true;
+
+		if (!madera_irq_still_asserted(priv))
+			goto out;
+	}
+
 	/* The codec can generate IRQs while it is in low-power mode so
 	 * we must do a runtime get before dispatching the IRQ
 	 */
@@ -108,31 +437,145 @@ static irqreturn_t madera_irq_thread(int irq, void *data)
 	}
 
 	do {
-		poll = false;
+		priv->thread_loops++;
 
-		handle_nested_irq(irq_find_mapping(priv->domain, 0));
-
-		/*
-		 * Poll the IRQ pin status to see if we're really done
-		 * if the interrupt controller can't do it for us.
-		 */
-		if (!gpio_is_valid(priv->irq_gpio)) {
-			break;
-		} else if (priv->irq_flags & IRQF_TRIGGER_RISING &&
-			   gpio_get_value_cansleep(priv->irq_gpio)) {
-			poll = true;
-		} else if (priv->irq_flags & IRQF_TRIGGER_FALLING &&
-			   !gpio_get_value_cansleep(priv->irq_gpio)) {
-			poll = true;
-		}
-	} while (poll);
+		if (priv->batched)
+			madera_irq_dispatch_batched(priv);
+		else
+			handle_nested_irq(irq_find_mapping(priv->domain, 0));
+	} while (madera_irq_still_asserted(priv));
 
 	pm_runtime_mark_last_busy(priv->madera->dev);
 	pm_runtime_put_autosuspend(priv->madera->dev);
 
+out:
+	madera_irq_stats_record(priv, &priv->thread_stats, start);
+	madera_irq_stats_record(priv, &priv->wake_stats[light],
+				priv->irq_time);
+
 	return IRQ_HANDLED;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static void madera_irq_stats_show_one(struct seq_file *s, const char *name,
+				      const struct madera_irq_stats *stats)
+{
+	int i;
+
+	seq_printf(s, "%s: count=%u avg_us=%llu max_us=%u\n", name,
+		   stats->count,
+		   stats->count ? div_u64(stats->total_us, stats->count) : 0,
+		   stats->max_us);
+
+	for (i = 0; i < MADERA_IRQ_NUM_BUCKETS; i++) {
+		if (!stats->bucket[i])
+			continue;
+
+		seq_printf(s, "  >=%uus: %u\n",
+			   i ? 1 << (i - 1) : 0, stats->bucket[i]);
+	}
+}
+
+static int madera_irq_stats_show(struct seq_file *s, void *data)
+{
+	struct madera_irq_priv *priv = s->private;
+	char name[16];
+	int i;
+
+	mutex_lock(&priv->stats_lock);
+
+	seq_printf(s, "batched=%d loops=%u\n", priv->batched,
+		   priv->thread_loops);
+	seq_printf(s, "light_wake=%d wakes=%u promotions=%u\n",
+		   priv->light_wake, priv->light_wakes, priv->light_promotions);
+	seq_printf(s, "handler_resumes=%u resumes_avoided=%u\n",
+		   priv->handler_resumes, priv->resumes_avoided);
+	madera_irq_stats_show_one(s, "thread", &priv->thread_stats);
+	madera_irq_stats_show_one(s, "wake_full", &priv->wake_stats[0]);
+	madera_irq_stats_show_one(s, "wake_light", &priv->wake_stats[1]);
+
+	for (i = 0; i < MADERA_NUM_IRQ; i++) {
+		if (!priv->stats[i].count)
+			continue;
+
+		snprintf(name, sizeof(name), "irq%d", i);
+		madera_irq_stats_show_one(s, name, &priv->stats[i]);
+	}
+
+	mutex_unlock(&priv->stats_lock);
+
+	return 0;
+}
+
+static int madera_irq_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, madera_irq_stats_show, inode->i_private);
+}
+
+/* Any write clears the statistics */
+static ssize_t madera_irq_stats_write(struct file *file,
+				      const char __user *user_buf,
+				      size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct madera_irq_priv *priv = s->private;
+
+	mutex_lock(&priv->stats_lock);
+	priv->thread_loops = 0;
+	priv->light_wakes = 0;
+	priv->light_promotions = 0;
+	priv->handler_resumes = 0;
+	priv->resumes_avoided = 0;
+	memset(&priv->thread_stats, 0, sizeof(priv->thread_stats));
+	memset(priv->wake_stats, 0, sizeof(priv->wake_stats));
+	memset(priv->stats, 0, sizeof(priv->stats));
+	mutex_unlock(&priv->stats_lock);
+
+	return count;
+}
+
+static const struct file_operations madera_irq_stats_fops = {
+	.open = madera_irq_stats_open,
+	.read = seq_read,
+	.write = madera_irq_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void madera_irq_init_debugfs(struct madera_irq_priv *priv)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir(dev_name(priv->dev), NULL);
+	if (IS_ERR_OR_NULL(root))
+		goto err;
+
+	if (!debugfs_create_file("irq_stats", 0644, root, priv,
+				 &madera_irq_stats_fops))
+		goto err;
+
+	priv->debugfs_root = root;
+	return;
+
+err:
+	debugfs_remove_recursive(root);
+	dev_warn(priv->dev, "Failed to create debugfs\n");
+}
+
+static void madera_irq_cleanup_debugfs(struct madera_irq_priv *priv)
+{
+	debugfs_remove_recursive(priv->debugfs_root);
+}
+#else
+static inline void madera_irq_init_debugfs(struct madera_irq_priv *priv)
+{
+}
+
+static inline void madera_irq_cleanup_debugfs(struct madera_irq_priv *priv)
+{
+}
+#endif
+
 static void madera_irq_dummy(struct irq_data *data)
 {
 }
@@ -254,6 +697,9 @@ static int madera_irq_of_get(struct madera_irq_priv *priv)
 
 	priv->irq_gpio = of_get_named_gpio(np, "cirrus,irq-gpios", 0);
 
+	priv->batched = of_property_read_bool(np, "cirrus,irq-batched");
+	priv->light_wake = of_property_read_bool(np, "cirrus,irq-light-wake");
+
 	return 0;
 }
 
@@ -274,6 +720,7 @@ int madera_irq_probe(struct platform_device *pdev)
 
 	priv->dev = &pdev->dev;
 	priv->madera = madera;
+	mutex_init(&priv->stats_lock);
 
 	switch (madera->type) {
 	case CS47L35:
@@ -302,6 +749,14 @@ int madera_irq_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
+	if (irq->num_regs > MADERA_IRQ_MAX_REGS) {
+		dev_err(madera->dev, "Too many IRQ registers: %d\n",
+			irq->num_regs);
+		return -EINVAL;
+	}
+
+	priv->chip = irq;
+
 	if (IS_ENABLED(CONFIG_OF)) {
 		if (!dev_get_platdata(priv->dev)) {
 			ret = madera_irq_of_get(priv);
@@ -311,6 +766,8 @@ int madera_irq_probe(struct platform_device *pdev)
 			priv->irq = madera->irq;
 			priv->irq_flags = madera->pdata.irqchip.irq_flags;
 			priv->irq_gpio = madera->pdata.irqchip.irq_gpio;
+			priv->batched = madera->pdata.irqchip.batched;
+			priv->light_wake = madera->pdata.irqchip.light_wake;
 
 			/* pdata uses 0 to mean undefined, convert to an
 			 * invalid GPIO number
@@ -397,8 +854,8 @@ int madera_irq_probe(struct platform_device *pdev)
 		return ret;
 	}
 
-	ret = request_threaded_irq(priv->irq, NULL, madera_irq_thread,
-				   flags, "madera", priv);
+	ret = request_threaded_irq(priv->irq, madera_irq_hardirq,
+				   madera_irq_thread, flags, "madera", priv);
 	if (ret) {
 		dev_err(priv->dev,
 			"Failed to request threaded irq %d: %d\n",
@@ -410,6 +867,8 @@ int madera_irq_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, priv);
 	madera->irq_dev = priv->dev;
 
+	madera_irq_init_debugfs(priv);
+
 	return 0;
 }
 
@@ -417,6 +876,8 @@ int madera_irq_remove(struct platform_device *pdev)
 {
 	struct madera_irq_priv *priv = platform_get_drvdata(pdev);
 
+	madera_irq_cleanup_debugfs(priv);
+
 	priv->madera->irq_dev = NULL;
 
 	regmap_del_irq_chip(priv->irq, priv->irq_data);
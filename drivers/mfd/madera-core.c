@@ -260,6 +260,8 @@ static int madera_runtime_resume(struct device *dev)
 
 	dev_dbg(madera->dev, "Leaving sleep mode\n");
 
+	mutex_lock(&madera->light_wake_lock);
+
 	/* If DCVDD didn't power off we must force a reset so that the
 	 * cache syncs correctly. If we have a hardware reset this must
 	 * be done before powering up DCVDD. If not, we'll use a software
@@ -274,6 +276,7 @@ static int madera_runtime_resume(struct device *dev)
 	ret = regulator_enable(madera->dcvdd);
 	if (ret) {
 		dev_err(madera->dev, "Failed to enable DCVDD: %d\n", ret);
+		mutex_unlock(&madera->light_wake_lock);
 		return ret;
 	}
 
@@ -308,6 +311,8 @@ static int madera_runtime_resume(struct device *dev)
 		goto err;
 	}
 
+	mutex_unlock(&madera->light_wake_lock);
+
 	return 0;
 
 err:
@@ -315,6 +320,7 @@ err:
 	regcache_cache_only(madera->regmap, true);
 	madera->dcvdd_powered_off = false;
 	regulator_disable(madera->dcvdd);
+	mutex_unlock(&madera->light_wake_lock);
 	return ret;
 }
 
@@ -324,6 +330,8 @@ static int madera_runtime_suspend(struct device *dev)
 
 	dev_dbg(madera->dev, "Entering sleep mode\n");
 
+	mutex_lock(&madera->light_wake_lock);
+
 	regcache_cache_only(madera->regmap, true);
 	regcache_mark_dirty(madera->regmap);
 	regcache_cache_only(madera->regmap_32bit, true);
@@ -332,10 +340,80 @@ static int madera_runtime_suspend(struct device *dev)
 	madera->dcvdd_powered_off = false;
 	regulator_disable(madera->dcvdd);
 
+	mutex_unlock(&madera->light_wake_lock);
+
+	madera_call_notifiers(madera, MADERA_NOTIFY_POWER_OFF, NULL);
+
+	return 0;
+}
+
+/*
+ * Hold the device in runtime suspend so the always-on IRQ registers can be
+ * accessed through regmap_light_wake, without the full resume and cache
+ * sync. The main register maps stay cache-only throughout so no other user
+ * can reach the powered down registers. Returns -EBUSY if the device is not
+ * suspended, in which case the caller should use the normal runtime PM
+ * path. On success the caller must call madera_light_wake_end().
+ */
+int madera_light_wake_begin(struct madera *madera)
+{
+	if (!madera->regmap_light_wake)
+		return -EBUSY;
+
+	mutex_lock(&madera->light_wake_lock);
+
+	if (!pm_runtime_status_suspended(madera->dev)) {
+		mutex_unlock(&madera->light_wake_lock);
+		return -EBUSY;
+	}
+
 	return 0;
 }
+EXPORT_SYMBOL_GPL(madera_light_wake_begin);
+
+void madera_light_wake_end(struct madera *madera)
+{
+	mutex_unlock(&madera->light_wake_lock);
+}
+EXPORT_SYMBOL_GPL(madera_light_wake_end);
 #endif
 
+static bool madera_light_wake_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case MADERA_IRQ1_STATUS_1 ... MADERA_IRQ1_STATUS_33:
+	case MADERA_IRQ1_MASK_1 ... MADERA_IRQ1_MASK_33:
+	case MADERA_IRQ1_RAW_STATUS_1 ... MADERA_IRQ1_RAW_STATUS_33:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Turn a copy of a bus driver's 16-bit register map config into an uncached
+ * map that can only reach the always-on IRQ registers, for servicing IRQs
+ * while the device is runtime suspended.
+ */
+void madera_light_wake_regmap_config(struct regmap_config *config)
+{
+	config->name = "light_wake";
+	config->readable_reg = madera_light_wake_reg;
+	config->writeable_reg = madera_light_wake_reg;
+	config->volatile_reg = madera_light_wake_reg;
+	config->precious_reg = NULL;
+	config->rd_table = NULL;
+	config->wr_table = NULL;
+	config->volatile_table = NULL;
+	config->precious_table = NULL;
+	config->reg_defaults = NULL;
+	config->num_reg_defaults = 0;
+	config->reg_defaults_raw = NULL;
+	config->num_reg_defaults_raw = 0;
+	config->cache_type = REGCACHE_NONE;
+}
+EXPORT_SYMBOL_GPL(madera_light_wake_regmap_config);
+
 const struct dev_pm_ops madera_pm_ops = {
 	SET_RUNTIME_PM_OPS(madera_runtime_suspend,
 			   madera_runtime_resume,
@@ -670,6 +748,7 @@ int madera_dev_init(struct madera *madera)
 
 	dev_set_drvdata(madera->dev, madera);
 	mutex_init(&madera->reg_setting_lock);
+	mutex_init(&madera->light_wake_lock);
 	BLOCKING_INIT_NOTIFIER_HEAD(&madera->notifier);
 
 	/* default headphone impedance in case the extcon driver is not used */
@@ -25,6 +25,7 @@ static int madera_spi_probe(struct spi_device *spi)
 	struct madera *madera;
 	const struct regmap_config *regmap_16bit_config = NULL;
 	const struct regmap_config *regmap_32bit_config = NULL;
+	struct regmap_config light_wake_config;
 	unsigned long type;
 	int ret;
 
@@ -88,6 +89,19 @@ static int madera_spi_probe(struct spi_device *spi)
 		return ret;
 	}
 
+	light_wake_config = *regmap_16bit_config;
+	madera_light_wake_regmap_config(&light_wake_config);
+
+	madera->regmap_light_wake = devm_regmap_init_spi(spi,
+							 &light_wake_config);
+	if (IS_ERR(madera->regmap_light_wake)) {
+		ret = PTR_ERR(madera->regmap_light_wake);
+		dev_err(&spi->dev,
+			"Failed to allocate light wake register map: %d\n",
+			ret);
+		return ret;
+	}
+
 	madera->type = type;
 	madera->dev = &spi->dev;
 	madera->irq = spi->irq;
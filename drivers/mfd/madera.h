@@ -15,6 +15,7 @@
 #include <linux/of.h>
 
 struct madera;
+struct regmap_config;
 
 extern const struct dev_pm_ops madera_pm_ops;
 extern const struct of_device_id madera_of_match[];
@@ -23,6 +24,7 @@ int madera_dev_init(struct madera *madera);
 int madera_dev_exit(struct madera *madera);
 int madera_irq_init(struct madera *madera);
 int madera_irq_exit(struct madera *madera);
+void madera_light_wake_regmap_config(struct regmap_config *config);
 
 #ifdef CONFIG_OF
 unsigned long madera_of_get_type(struct device *dev);
@@ -101,6 +101,15 @@ struct madera_accdet_pdata {
 	/** Extra software debounces during button detection */
 	u32 micd_manual_debounce;
 
+	/**
+	 * If non-zero, sample buttons from a high priority thread every this
+	 * many microseconds instead of through the workqueue
+	 */
+	u32 micd_button_sample_us;
+
+	/** Number of consecutive matching samples to report a button */
+	u32 micd_button_samples;
+
 	/** GPIO for mic detection polarity */
 	int micd_pol_gpio;
 
@@ -118,6 +127,13 @@ struct madera_accdet_pdata {
 	/** Mic detect timeout (milliseconds) */
 	u32 micd_timeout_ms;
 
+	/**
+	 * If non-zero, a jack re-inserted within this many milliseconds of
+	 * being removed is first checked against the previous accessory
+	 * instead of being fully characterised
+	 */
+	u32 fast_reinsert_ms;
+
 	/** Mic detect clamp function */
 	u32 micd_clamp_mode;
 
@@ -130,6 +146,12 @@ struct madera_accdet_pdata {
 	/** Use software comparison to determine mic presence */
 	bool micd_software_compare;
 
+	/**
+	 * Measure every micd_config once and choose the polarity and
+	 * accessory type from the set of readings. Implies software compare
+	 */
+	bool micd_classify;
+
 	/** Mic detect level parameters */
 	const struct madera_micd_range *micd_ranges;
 	int num_micd_ranges;
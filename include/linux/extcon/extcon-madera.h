@@ -11,6 +11,9 @@
 #ifndef EXTCON_MADERA_H
 #define EXTCON_MADERA_H
 
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/mfd/madera/registers.h>
 
 /* Conversion between ohms and hundredths of an ohm. */
@@ -62,6 +65,38 @@ struct madera_hpdet_trims {
 	int grad_x4;
 };
 
+/* Phases of jack insertion tracked by the latency histograms */
+enum madera_jack_lat_phase {
+	MADERA_JACK_LAT_DEBOUNCE,	/* jack IRQ to start of detection */
+	MADERA_JACK_LAT_MICD,		/* microphone detection */
+	MADERA_JACK_LAT_HPDET_STEP,	/* a single HPDET range step */
+	MADERA_JACK_LAT_HPDET,		/* complete HP impedance measurement */
+	MADERA_JACK_LAT_TUNING,		/* applying the HP tuning patch */
+	MADERA_JACK_LAT_TOTAL,		/* jack IRQ to final accessory report */
+	MADERA_JACK_LAT_BUTTON,		/* button IRQ to input event */
+	MADERA_JACK_LAT_NUM_PHASES,
+};
+
+/* Bucket n counts samples of [2^(n-1), 2^n) ms, bucket 0 is < 1ms */
+#define MADERA_JACK_LAT_NUM_BUCKETS	16
+
+struct madera_jack_lat_hist {
+	unsigned int count;
+	unsigned int max_us;
+	u64 total_us;
+	unsigned int bucket[MADERA_JACK_LAT_NUM_BUCKETS];
+};
+
+/* Characterisation of the last accessory, for fast re-insertion */
+struct madera_extcon_accessory {
+	bool valid;
+	ktime_t removed;
+	bool have_mic;
+	int micd_mode;
+	unsigned int hpdet_range;
+	int hp_imp_x100;
+};
+
 struct madera_extcon {
 	struct device *dev;
 	struct madera *madera;
@@ -96,10 +131,32 @@ struct madera_extcon {
 
 	struct delayed_work micd_detect_work;
 
+	struct hrtimer button_timer;
+	struct kthread_worker *button_worker;
+	struct kthread_work button_work;
+	ktime_t button_irq_time;
+	int button_sample;
+	int button_count;
+	int button_total;
+	bool button_stopping;
+
 	bool have_mic;
 	bool detecting;
 	int jack_flips;
 
+	unsigned int *micd_class_ohms;
+	int micd_class_count;
+	u32 micd_class_runs;
+	u32 micd_class_measurements;
+	u32 micd_class_max;
+
+	unsigned int hpdet_range;
+	bool fast_reinsert;
+	bool fast_reinsert_confirm;
+	struct madera_extcon_accessory last_acc;
+	u32 fast_reinsert_hits;
+	u32 fast_reinsert_misses;
+
 	const struct madera_jd_state *state;
 	const struct madera_jd_state *old_state;
 	struct delayed_work state_timeout_work;
@@ -109,6 +166,12 @@ struct madera_extcon {
 	bool usbc_connected;
 	struct notifier_block psy_nb;
 	struct power_supply *usb_psy;
+
+	ktime_t lat_insert;
+	ktime_t lat_phase;
+	ktime_t lat_hpdet_step;
+	struct madera_jack_lat_hist lat_hist[MADERA_JACK_LAT_NUM_PHASES];
+	struct dentry *debugfs_root;
 };
 
 enum madera_accdet_mode {
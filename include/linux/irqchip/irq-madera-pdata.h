@@ -20,6 +20,12 @@ struct madera_irqchip_pdata {
 	 *  input on the host interrupt controller
 	 */
 	int irq_gpio;
+
+	/** Read all status banks in one transfer and dispatch directly */
+	bool batched;
+
+	/** Service light IRQs from the always-on domain without a resume */
+	bool light_wake;
 };
 
 #endif
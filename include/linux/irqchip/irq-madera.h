@@ -94,5 +94,8 @@ extern int madera_request_irq(struct madera *madera, int irq, const char *name,
 			      irq_handler_t handler, void *data);
 extern void madera_free_irq(struct madera *madera, int irq, void *data);
 extern int madera_set_irq_wake(struct madera *madera, int irq, int on);
+extern int madera_set_irq_light_wake(struct madera *madera, int irq, int on);
+extern int madera_irq_read_status(struct madera *madera, unsigned int reg,
+				  unsigned int *val);
 
 #endif
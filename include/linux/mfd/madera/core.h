@@ -32,6 +32,7 @@ enum madera_type {
 #define MADERA_NOTIFY_VOICE_TRIGGER	0x1
 #define MADERA_NOTIFY_HPDET		0x2
 #define MADERA_NOTIFY_MICDET		0x4
+#define MADERA_NOTIFY_POWER_OFF		0x8
 
 struct snd_soc_dapm_context;
 struct madera_extcon_info;
@@ -39,6 +40,7 @@ struct madera_extcon_info;
 struct madera {
 	struct regmap *regmap;
 	struct regmap *regmap_32bit;
+	struct regmap *regmap_light_wake;
 
 	struct device *dev;
 
@@ -70,6 +72,7 @@ struct madera {
 	struct snd_soc_dapm_context *dapm;
 
 	struct mutex reg_setting_lock;
+	struct mutex light_wake_lock;
 
 	struct blocking_notifier_head notifier;
 };
@@ -87,6 +90,20 @@ extern int madera_get_num_micbias(struct madera *madera,
 
 extern const char *madera_name_from_type(enum madera_type type);
 
+#ifdef CONFIG_PM
+extern int madera_light_wake_begin(struct madera *madera);
+extern void madera_light_wake_end(struct madera *madera);
+#else
+static inline int madera_light_wake_begin(struct madera *madera)
+{
+	return -EBUSY;
+}
+
+static inline void madera_light_wake_end(struct madera *madera)
+{
+}
+#endif
+
 static inline int madera_of_read_int(struct madera *madera, const char *prop,
 				     bool mandatory, int *data)
 {
@@ -20,6 +20,30 @@
 #define MADERA_MAX_AIF			4
 #define MADERA_MAX_PDM_SPK		2
 #define MADERA_MAX_DSP			7
+#define MADERA_MAX_DSP_CLK_LEVELS	4
+
+/** DSP clock governor, disabled unless n_levels is non-zero */
+struct madera_dsp_clk_gov_pdata {
+	/** Algorithm ID and XM word offset of the firmware load figure */
+	unsigned int load_alg;
+	unsigned int load_offset;
+
+	/** Load figure above which the clock steps up a level */
+	unsigned int up_threshold;
+
+	/** Load figure below which the clock steps down a level */
+	unsigned int down_threshold;
+
+	/** Interval between load samples in milliseconds */
+	unsigned int period_ms;
+
+	/** Reduced DSP clock settings in ascending order, in the format of
+	 * the codec's DSP clock field. The clock supplied when the DSP is
+	 * powered up is always the top level.
+	 */
+	unsigned int levels[MADERA_MAX_DSP_CLK_LEVELS];
+	int n_levels;
+};
 
 struct madera_codec_pdata {
 	/**
@@ -69,6 +93,9 @@ struct madera_codec_pdata {
 	/** Override default list of firmwares */
 	struct wm_adsp_fw_defs *fw_defs[MADERA_MAX_DSP];
 	int num_fw_defs[MADERA_MAX_DSP];
+
+	/** Load driven DSP clock scaling */
+	struct madera_dsp_clk_gov_pdata dsp_clk_gov[MADERA_MAX_DSP];
 };
 
 #endif
@@ -0,0 +1,150 @@
+/*
+ * extcon_madera.h - Tracepoints for the Madera extcon driver
+ *
+ * Copyright 2017 Cirrus Logic
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM extcon_madera
+
+#if !defined(_TRACE_EXTCON_MADERA_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_EXTCON_MADERA_H
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(madera_extcon_val,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val),
+
+	TP_STRUCT__entry(
+		__string(	name,		dev_name(dev)	)
+		__field(	int,		val		)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->val = val;
+	),
+
+	TP_printk("%s val=%d", __get_str(name), __entry->val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_jackdet,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_micd_reading,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_micd_mode,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_hpdet_range,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_hpdet_reading,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+DEFINE_EVENT(madera_extcon_val, madera_hp_tuning,
+
+	TP_PROTO(struct device *dev, int val),
+
+	TP_ARGS(dev, val)
+);
+
+TRACE_EVENT(madera_jds_state,
+
+	TP_PROTO(struct device *dev, int old_mode, int new_mode),
+
+	TP_ARGS(dev, old_mode, new_mode),
+
+	TP_STRUCT__entry(
+		__string(	name,		dev_name(dev)	)
+		__field(	int,		old_mode	)
+		__field(	int,		new_mode	)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->old_mode = old_mode;
+		__entry->new_mode = new_mode;
+	),
+
+	TP_printk("%s mode %d->%d", __get_str(name),
+		  __entry->old_mode, __entry->new_mode)
+);
+
+TRACE_EVENT(madera_jack_report,
+
+	TP_PROTO(struct device *dev, int which, bool attached),
+
+	TP_ARGS(dev, which, attached),
+
+	TP_STRUCT__entry(
+		__string(	name,		dev_name(dev)	)
+		__field(	int,		which		)
+		__field(	bool,		attached	)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->which = which;
+		__entry->attached = attached;
+	),
+
+	TP_printk("%s cable=%d attached=%d", __get_str(name),
+		  __entry->which, __entry->attached)
+);
+
+TRACE_EVENT(madera_jack_latency,
+
+	TP_PROTO(struct device *dev, const char *phase, s64 us),
+
+	TP_ARGS(dev, phase, us),
+
+	TP_STRUCT__entry(
+		__string(	name,		dev_name(dev)	)
+		__string(	phase,		phase		)
+		__field(	s64,		us		)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__assign_str(phase, phase);
+		__entry->us = us;
+	),
+
+	TP_printk("%s %s %lld us", __get_str(name), __get_str(phase),
+		  __entry->us)
+);
+
+#endif /* _TRACE_EXTCON_MADERA_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
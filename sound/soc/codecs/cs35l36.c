@@ -46,6 +46,9 @@
  */
 #define CS35L36_VALID_PDATA 0x80000000
 
+/* Time allowed for the PAC to signal MCU_CONFIG before polling */
+#define CS35L36_PAC_TIMEOUT_MS	20
+
 
 static const char * const cs35l36_supplies[] = {
 	"VA",
@@ -69,6 +72,7 @@ struct  cs35l36_private {
 	struct gpio_desc *reset_gpio;
 	struct completion global_pup_done;
 	struct completion global_pdn_done;
+	struct completion pac_done;
 };
 
 struct cs35l36_pll_sysclk_config {
@@ -1088,6 +1092,15 @@ static irqreturn_t cs35l36_irq(int irq, void *data)
 		return IRQ_NONE;
 	}
 
+	/* PAC patch has been applied, let cs35l36_pac() continue */
+	if (status[3] & ~masks[3] & CS35L36_MCU_CONFIG_CLR) {
+		regmap_write(cs35l36->regmap, CS35L36_INT4_MASK,
+				CS35L36_MCU_CONFIG_MASK);
+		regmap_write(cs35l36->regmap, CS35L36_INT4_STATUS,
+				CS35L36_MCU_CONFIG_CLR);
+		complete(&cs35l36->pac_done);
+	}
+
 	/*
 	 * The following interrupts require a
 	 * protection release cycle to get the
@@ -1363,10 +1376,68 @@ static int cs35l36_handle_of_data(struct i2c_client *i2c_client,
 	return 0;
 }
 
-static int cs35l36_pac(struct cs35l36_private *cs35l36)
+/* Upload an image into PAC program memory in a single transfer */
+static int cs35l36_pac_load(struct cs35l36_private *cs35l36,
+			    const unsigned int *image, unsigned int len)
+{
+	int ret;
+
+	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3, CS35L36_PAC_MEM_ACCESS);
+
+	ret = regmap_bulk_write(cs35l36->regmap, CS35L36_PAC_PMEM_WORD0,
+				image, len);
+
+	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3,
+			CS35L36_PAC_MEM_ACCESS_CLR);
+
+	if (ret < 0) {
+		dev_err(cs35l36->dev, "Failed to load PAC image %d\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int cs35l36_pac_wait(struct cs35l36_private *cs35l36)
 {
 	int ret, count;
 	unsigned int val;
+
+	if (wait_for_completion_timeout(&cs35l36->pac_done,
+				msecs_to_jiffies(CS35L36_PAC_TIMEOUT_MS)))
+		return 0;
+
+	dev_dbg(cs35l36->dev, "No MCU_CONFIG IRQ, polling\n");
+
+	for (count = 0; count < 100; count++) {
+		/* The IRQ handler clears the status if it arrives late */
+		if (completion_done(&cs35l36->pac_done))
+			return 0;
+
+		ret = regmap_read(cs35l36->regmap, CS35L36_INT4_STATUS, &val);
+		if (ret < 0) {
+			dev_err(cs35l36->dev, "Failed to read int4_status %d\n",
+				ret);
+			return ret;
+		}
+
+		if (val & CS35L36_MCU_CONFIG_CLR)
+			return 0;
+
+		usleep_range(100, 200);
+	}
+
+	return -ETIMEDOUT;
+}
+
+static const unsigned int cs35l36_b0_pac_patch[] = {
+	CS35L36_B0_PAC_PATCH,
+};
+
+static int cs35l36_pac(struct cs35l36_private *cs35l36)
+{
+	int ret;
+
 	if (cs35l36->rev_id == CS35L36_REV_B0) {
 		/*
 		 * Magic code for internal PAC
@@ -1378,46 +1449,25 @@ static int cs35l36_pac(struct cs35l36_private *cs35l36)
 
 		usleep_range(9500, 10500);
 
+		reinit_completion(&cs35l36->pac_done);
+
 		regmap_write(cs35l36->regmap, CS35L36_INT4_MASK,
 				CS35L36_MCU_CONFIG_UNMASK);
 
 		regmap_write(cs35l36->regmap, CS35L36_PAC_CTL1,
 				CS35L36_PAC_RESET);
-		regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3,
-				CS35L36_PAC_MEM_ACCESS);
-		regmap_write(cs35l36->regmap, CS35L36_PAC_PMEM_WORD0,
-				CS35L36_B0_PAC_PATCH);
 
-		regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3,
-				CS35L36_PAC_MEM_ACCESS_CLR);
+		ret = cs35l36_pac_load(cs35l36, cs35l36_b0_pac_patch,
+				       ARRAY_SIZE(cs35l36_b0_pac_patch));
+		if (ret < 0)
+			return ret;
+
 		regmap_write(cs35l36->regmap, CS35L36_PAC_CTL1,
 				CS35L36_PAC_ENABLE_MASK);
 
-		usleep_range(9500, 10500);
-
-		ret = regmap_read(cs35l36->regmap, CS35L36_INT4_STATUS, &val);
-		if (ret < 0) {
-			dev_err(cs35l36->dev, "Failed to read int4_status %d\n",
-				ret);
+		ret = cs35l36_pac_wait(cs35l36);
+		if (ret < 0)
 			return ret;
-		}
-
-		count = 0;
-		while (!(val & CS35L36_MCU_CONFIG_CLR)) {
-			usleep_range(100, 200);
-			count++;
-
-			ret = regmap_read(cs35l36->regmap, CS35L36_INT4_STATUS,
-					  &val);
-			if (ret < 0) {
-				dev_err(cs35l36->dev, "Failed to read int4_status %d\n",
-					ret);
-				return ret;
-			}
-
-			if (count >= 100)
-				return -EINVAL;
-		}
 
 		regmap_write(cs35l36->regmap, CS35L36_INT4_MASK,
 				CS35L36_MCU_CONFIG_MASK);
@@ -1532,22 +1582,24 @@ static const struct reg_sequence cs35l36_revb0_errata_patch[] = {
 	{ CS35L36_TESTKEY_CTRL, CS35L36_TEST_LOCK2 },
 };
 
-static void cs35l36_aou_low_power(struct cs35l36_private *cs35l36)
+static int cs35l36_aou_low_power(struct cs35l36_private *cs35l36)
 {
+	int ret;
+
 	/* Reset PAC */
 	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL1, CS35L36_PAC_RESET_MASK);
 	usleep_range(200, 250);
 	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL1, 0);
 
-	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3, CS35L36_PAC_MEM_ACCESS);
-
-	regmap_bulk_write(cs35l36->regmap, CS35L36_PAC_PMEM_WORD0,
-			cs35l36_aou_low_power_patch,
-			ARRAY_SIZE(cs35l36_aou_low_power_patch));
+	ret = cs35l36_pac_load(cs35l36, cs35l36_aou_low_power_patch,
+			       ARRAY_SIZE(cs35l36_aou_low_power_patch));
+	if (ret < 0)
+		return ret;
 
-	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL3, 0);
 	regmap_write(cs35l36->regmap, CS35L36_PAC_CTL1,
 		CS35L36_PAC_ENABLE_MASK);
+
+	return 0;
 }
 
 static int cs35l36_i2c_probe(struct i2c_client *i2c_client,
@@ -1567,6 +1619,7 @@ static int cs35l36_i2c_probe(struct i2c_client *i2c_client,
 		return -ENOMEM;
 
 	cs35l36->dev = dev;
+	init_completion(&cs35l36->pac_done);
 
 	i2c_set_clientdata(i2c_client, cs35l36);
 	cs35l36->regmap = devm_regmap_init_i2c(i2c_client, &cs35l36_regmap);
@@ -1666,6 +1719,17 @@ static int cs35l36_i2c_probe(struct i2c_client *i2c_client,
 	if (pdata->irq_config.is_present)
 		irq_pol = cs35l36_irq_gpio_config(cs35l36);
 
+	/* The PAC load below signals completion through the IRQ */
+	ret = devm_request_threaded_irq(dev, i2c_client->irq, NULL, cs35l36_irq,
+					IRQF_ONESHOT |
+					irq_pol,
+					"cs35l36", cs35l36);
+
+	if (ret != 0) {
+		dev_err(dev, "Failed to request IRQ: %d\n", ret);
+		goto err;
+	}
+
 	switch (cs35l36->rev_id) {
 	case CS35L36_REV_A0:
 		ret = regmap_register_patch(cs35l36->regmap,
@@ -1700,20 +1764,15 @@ static int cs35l36_i2c_probe(struct i2c_client *i2c_client,
 					ret);
 			goto err;
 		}
-		cs35l36_aou_low_power(cs35l36);
+		ret = cs35l36_aou_low_power(cs35l36);
+		if (ret < 0) {
+			dev_err(dev, "Failed to apply AOU low power patch %d\n",
+				ret);
+			goto err;
+		}
 		break;
 	}
 
-	ret = devm_request_threaded_irq(dev, i2c_client->irq, NULL, cs35l36_irq,
-					IRQF_ONESHOT |
-					irq_pol,
-					"cs35l36", cs35l36);
-
-	if (ret != 0) {
-		dev_err(dev, "Failed to request IRQ: %d\n", ret);
-		goto err;
-	}
-
 	/* Set interrupt masks for critical errors */
 	regmap_write(cs35l36->regmap, CS35L36_INT1_MASK,
 			CS35L36_INT1_MASK_DEFAULT);
@@ -1259,10 +1259,23 @@ static int cs35l41_pcm_hw_params(struct snd_pcm_substream *substream,
 		if (rate == cs35l41_fs_rates[i].rate)
 			break;
 	}
+
+	if (i == ARRAY_SIZE(cs35l41_fs_rates)) {
+		dev_err(cs35l41->dev, "Unsupported rate %d\n", rate);
+		return -EINVAL;
+	}
+
 	regmap_update_bits(cs35l41->regmap, CS35L41_GLOBAL_CLK_CTRL,
 			CS35L41_GLOBAL_FS_MASK,
 			cs35l41_fs_rates[i].fs_cfg << CS35L41_GLOBAL_FS_SHIFT);
 
+	/* The DSP channels all run at the global rate */
+	ret = wm_halo_set_rates(&cs35l41->dsp, cs35l41_fs_rates[i].fs_cfg);
+	if (ret < 0 && ret != -ENODEV) {
+		dev_err(cs35l41->dev, "Failed to set DSP rates %d\n", ret);
+		return ret;
+	}
+
 	asp_wl = params_width(params);
 	asp_width = params_physical_width(params);
 
@@ -1294,7 +1307,7 @@ static int cs35l41_pcm_hw_params(struct snd_pcm_substream *substream,
 				asp_wl << CS35L41_ASP_TX_WL_SHIFT);
 	}
 
-	return ret;
+	return 0;
 }
 
 static int cs35l41_boost_config(struct cs35l41_private *cs35l41,
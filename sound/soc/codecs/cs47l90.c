@@ -344,6 +344,11 @@ static int cs47l90_adsp_power_ev(struct snd_soc_dapm_widget *w,
 		ret = madera_set_adsp_clk(&cs47l90->core.adsp[w->shift], freq);
 		if (ret)
 			return ret;
+
+		madera_start_adsp_clk_gov(&cs47l90->core.adsp[w->shift], freq);
+		break;
+	case SND_SOC_DAPM_PRE_PMD:
+		madera_stop_adsp_clk_gov(&cs47l90->core.adsp[w->shift]);
 		break;
 	default:
 		break;
@@ -632,14 +637,20 @@ MADERA_LHPF_CONTROL("LHPF2 Coefficients", MADERA_HPLPF2_2),
 MADERA_LHPF_CONTROL("LHPF3 Coefficients", MADERA_HPLPF3_2),
 MADERA_LHPF_CONTROL("LHPF4 Coefficients", MADERA_HPLPF4_2),
 
+MADERA_COEFF_PRESET_CONTROLS,
+MADERA_EQ_RAMP_CONTROLS,
+
 SOC_ENUM("LHPF1 Mode", madera_lhpf1_mode),
 SOC_ENUM("LHPF2 Mode", madera_lhpf2_mode),
 SOC_ENUM("LHPF3 Mode", madera_lhpf3_mode),
 SOC_ENUM("LHPF4 Mode", madera_lhpf4_mode),
 
-SOC_ENUM("Sample Rate 2", madera_sample_rate[0]),
-SOC_ENUM("Sample Rate 3", madera_sample_rate[1]),
-SOC_ENUM("ASYNC Sample Rate 2", madera_sample_rate[2]),
+SOC_ENUM_EXT("Sample Rate 2", madera_sample_rate[0],
+	     snd_soc_get_enum_double, madera_sample_rate_put),
+SOC_ENUM_EXT("Sample Rate 3", madera_sample_rate[1],
+	     snd_soc_get_enum_double, madera_sample_rate_put),
+SOC_ENUM_EXT("ASYNC Sample Rate 2", madera_sample_rate[2],
+	     snd_soc_get_enum_double, madera_sample_rate_put),
 
 MADERA_RATE_ENUM("FX Rate", madera_fx_rate),
 
@@ -2818,6 +2829,8 @@ static int cs47l90_codec_probe(struct snd_soc_codec *codec)
 	if (ret)
 		return ret;
 
+	madera_init_debugfs(codec);
+
 	snd_soc_dapm_disable_pin(madera->dapm, "HAPTICS");
 
 	ret = snd_soc_add_codec_controls(codec, madera_adsp_rate_controls,
@@ -43,11 +43,17 @@ static void madera_slim_fixup_prop(struct slim_ch *prop,
 				   u32 samplerate, u32 sampleszbits)
 {
 	prop->prot = SLIM_AUTO_ISO;
-	prop->baser = SLIM_RATE_4000HZ;
 	prop->dataf = SLIM_CH_DATAF_NOT_DEFINED;
 	prop->auxf = SLIM_CH_AUXF_NOT_APPLICABLE;
-	prop->ratem = samplerate / 4000;
 	prop->sampleszbits = sampleszbits;
+
+	if (samplerate % 4000) {
+		prop->baser = SLIM_RATE_11025HZ;
+		prop->ratem = samplerate / 11025;
+	} else {
+		prop->baser = SLIM_RATE_4000HZ;
+		prop->ratem = samplerate / 4000;
+	}
 }
 
 #define TX_STREAM_1 128
@@ -67,8 +73,115 @@ static u16 tx_handles1[] = { TX_STREAM_1, TX_STREAM_1 + 1,
 			     TX_STREAM_1 + 2, TX_STREAM_1 + 3 };
 static u16 tx_handles2[] = { TX_STREAM_2, TX_STREAM_2 + 1 };
 static u16 tx_handles3[] = { TX_STREAM_3 };
-static u16 rx_group1, rx_group2, rx_group3;
-static u16 tx_group1, tx_group2, tx_group3;
+/*
+ * A channel group stays defined and its ports connected across power
+ * cycles. It is only torn down and redefined when the stream format or
+ * the channel map changes, so a route switch just has to activate it.
+ */
+struct madera_slim_group {
+	u16 handle;
+	bool defined;
+	bool stale;
+	int chcnt;
+	u32 samplerate;
+	u32 sampleszbits;
+};
+
+static struct madera_slim_group rx_group1, rx_group2, rx_group3;
+static struct madera_slim_group tx_group1, tx_group2, tx_group3;
+
+static int madera_slim_group_start(struct madera *madera,
+				   struct madera_slim_group *group,
+				   u32 *porth, u16 *handles, int chcnt,
+				   u32 samplerate, u32 sampleszbits, bool src)
+{
+	struct slim_ch prop;
+	int ret, i;
+
+	/* Nothing has been configured by hw_params, use the old default */
+	if (!samplerate || !sampleszbits) {
+		samplerate = 48000;
+		sampleszbits = 16;
+	}
+
+	if (group->defined && !group->stale && group->chcnt == chcnt &&
+	    group->samplerate == samplerate &&
+	    group->sampleszbits == sampleszbits) {
+		dev_dbg(madera->dev, "Reusing slimbus group %u\n",
+			group->handle);
+		goto activate;
+	}
+
+	if (group->defined) {
+		ret = slim_control_ch(stashed_slim_dev, group->handle,
+				      SLIM_CH_REMOVE, true);
+		if (ret != 0)
+			dev_warn(madera->dev, "Failed to remove group: %d\n",
+				 ret);
+		group->defined = false;
+	}
+
+	dev_dbg(madera->dev, "Defining slimbus group, rate=%d, bit=%d\n",
+		samplerate, sampleszbits);
+
+	madera_slim_fixup_prop(&prop, samplerate, sampleszbits);
+
+	ret = slim_define_ch(stashed_slim_dev, &prop, handles, chcnt, true,
+			     &group->handle);
+	if (ret != 0) {
+		dev_err(madera->dev, "slim_define_ch() failed: %d\n", ret);
+		return ret;
+	}
+
+	for (i = 0; i < chcnt; i++) {
+		if (src)
+			ret = slim_connect_src(stashed_slim_dev, porth[i],
+					       handles[i]);
+		else
+			ret = slim_connect_sink(stashed_slim_dev, &porth[i], 1,
+						handles[i]);
+		if (ret != 0) {
+			dev_err(madera->dev, "%s connect fail %d:%d\n",
+				src ? "src" : "snk", i, ret);
+			return ret;
+		}
+	}
+
+	group->defined = true;
+	group->stale = false;
+	group->chcnt = chcnt;
+	group->samplerate = samplerate;
+	group->sampleszbits = sampleszbits;
+
+activate:
+	ret = slim_control_ch(stashed_slim_dev, group->handle,
+			      SLIM_CH_ACTIVATE, true);
+	if (ret != 0) {
+		dev_err(madera->dev, "Failed to activate: %d\n", ret);
+		group->stale = true;
+	}
+
+	return ret;
+}
+
+/* Suspend rather than remove so the definition can be reused */
+static int madera_slim_group_stop(struct madera *madera,
+				  struct madera_slim_group *group)
+{
+	int ret;
+
+	if (!group->defined)
+		return 0;
+
+	ret = slim_control_ch(stashed_slim_dev, group->handle,
+			      SLIM_CH_SUSPEND, true);
+	if (ret != 0) {
+		dev_err(madera->dev, "Failed to suspend group: %d\n", ret);
+		group->stale = true;
+	}
+
+	return ret;
+}
 
 int madera_slim_tx_ev(struct snd_soc_dapm_widget *w,
 		      struct snd_kcontrol *kcontrol,
@@ -77,11 +190,12 @@ int madera_slim_tx_ev(struct snd_soc_dapm_widget *w,
 	struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
 	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
 	struct madera *madera = priv->madera;
-	struct slim_ch prop;
-	int ret = 0, i;
+	struct madera_slim_group *group;
+	int ret = 0;
 	u32 *porth;
-	u16 *handles, *group;
+	u16 *handles;
 	int chcnt;
+	u32 tx_sampleszbits = 16, tx_samplerate = 48000;
 
 	if (stashed_slim_dev == NULL) {
 		dev_err(madera->dev, "slim device undefined.\n");
@@ -100,6 +214,8 @@ int madera_slim_tx_ev(struct snd_soc_dapm_widget *w,
 		porth = tx_porth1;
 		handles = tx_handles1;
 		group = &tx_group1;
+		tx_sampleszbits = priv->tx1_sampleszbits;
+		tx_samplerate = priv->tx1_samplerate;
 		break;
 	case MADERA_SLIMTX5_ENA_SHIFT:
 		dev_dbg(madera->dev, "TX2\n");
@@ -112,6 +228,8 @@ int madera_slim_tx_ev(struct snd_soc_dapm_widget *w,
 		porth = tx_porth2;
 		handles = tx_handles2;
 		group = &tx_group2;
+		tx_sampleszbits = priv->tx2_sampleszbits;
+		tx_samplerate = priv->tx2_samplerate;
 		break;
 	case MADERA_SLIMTX4_ENA_SHIFT:
 		dev_dbg(codec->dev, "TX3\n");
@@ -128,46 +246,20 @@ int madera_slim_tx_ev(struct snd_soc_dapm_widget *w,
 	default:
 		goto exit;
 	}
-	madera_slim_fixup_prop(&prop, 48000, 16);
 
 	switch (event) {
 	case SND_SOC_DAPM_PRE_PMU:
 	case SND_SOC_DAPM_POST_PMU:
 		dev_dbg(madera->dev, "Start slimbus TX\n");
-		ret = slim_define_ch(stashed_slim_dev, &prop,
-				     handles, chcnt, true, group);
-		if (ret != 0) {
-			dev_err(madera->dev, "slim_define_ch() failed: %d\n",
-				ret);
-			goto exit;
-		}
-
-		for (i = 0; i < chcnt; i++) {
-			ret = slim_connect_src(stashed_slim_dev,
-						porth[i], handles[i]);
-			if (ret != 0) {
-				dev_err(madera->dev, "src connect fail %d:%d\n",
-					i, ret);
-				goto exit;
-			}
-		}
-
-		ret = slim_control_ch(stashed_slim_dev, *group,
-					SLIM_CH_ACTIVATE, true);
-		if (ret != 0) {
-			dev_err(madera->dev, "Failed to activate: %d\n", ret);
-			goto exit;
-		}
+		ret = madera_slim_group_start(madera, group, porth, handles,
+					      chcnt, tx_samplerate,
+					      tx_sampleszbits, true);
 		break;
 
 	case SND_SOC_DAPM_POST_PMD:
 	case SND_SOC_DAPM_PRE_PMD:
 		dev_dbg(madera->dev, "Stop slimbus Tx\n");
-		ret = slim_control_ch(stashed_slim_dev, *group,
-					SLIM_CH_REMOVE, true);
-		if (ret != 0)
-			dev_err(madera->dev, "Failed to remove tx: %d\n", ret);
-
+		ret = madera_slim_group_stop(madera, group);
 		break;
 	default:
 		break;
@@ -186,10 +278,10 @@ int madera_slim_rx_ev(struct snd_soc_dapm_widget *w,
 	struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
 	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
 	struct madera *madera = priv->madera;
-	struct slim_ch prop;
-	int ret = 0, i;
+	struct madera_slim_group *group;
+	int ret = 0;
 	u32 *porth;
-	u16 *handles, *group;
+	u16 *handles;
 	int chcnt;
 	u32 rx_sampleszbits = 16, rx_samplerate = 48000;
 
@@ -242,47 +334,21 @@ int madera_slim_rx_ev(struct snd_soc_dapm_widget *w,
 	default:
 		goto exit;
 	}
-	madera_slim_fixup_prop(&prop, rx_samplerate, rx_sampleszbits);
 
 	switch (event) {
 	case SND_SOC_DAPM_PRE_PMU:
 	case SND_SOC_DAPM_POST_PMU:
 		dev_dbg(madera->dev, "Start slimbus RX, rate=%d, bit=%d\n",
 			rx_samplerate, rx_sampleszbits);
-		ret = slim_define_ch(stashed_slim_dev, &prop,
-				     handles, chcnt, true, group);
-		if (ret != 0) {
-			dev_err(madera->dev, "slim_define_ch() failed: %d\n",
-				ret);
-			return ret;
-		}
-
-		for (i = 0; i < chcnt; i++) {
-			ret = slim_connect_sink(stashed_slim_dev, &porth[i], 1,
-						handles[i]);
-			if (ret != 0) {
-				dev_err(madera->dev, "snk connect fail %d:%d\n",
-					i, ret);
-				goto exit;
-			}
-		}
-
-		ret = slim_control_ch(stashed_slim_dev, *group,
-					SLIM_CH_ACTIVATE, true);
-		if (ret != 0) {
-			dev_err(madera->dev, "Failed to activate: %d\n", ret);
-			goto exit;
-		}
+		ret = madera_slim_group_start(madera, group, porth, handles,
+					      chcnt, rx_samplerate,
+					      rx_sampleszbits, false);
 		break;
 
 	case SND_SOC_DAPM_POST_PMD:
 	case SND_SOC_DAPM_PRE_PMD:
 		dev_dbg(madera->dev, "Stop slimbus Rx\n");
-		ret = slim_control_ch(stashed_slim_dev, *group,
-					SLIM_CH_REMOVE, true);
-		if (ret != 0)
-			dev_err(madera->dev, "Failed to remove rx: %d\n", ret);
-
+		ret = madera_slim_group_stop(madera, group);
 		break;
 	default:
 		break;
@@ -309,6 +375,7 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 	int tx_stream_idx, rx_stream_idx;
 	int *tx_priv_counter, *rx_priv_counter;
 	u16 *tx_chan_map_slot, *rx_chan_map_slot;
+	struct madera_slim_group *tx_group, *rx_group;
 
 	if (stashed_slim_dev == NULL) {
 		dev_err(madera->dev, "%s No slim device available\n",
@@ -341,6 +408,7 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 		tx_stream_idx = TX_STREAM_1;
 		tx_priv_counter = &priv->tx_chan_map_num[0];
 		tx_chan_map_slot = priv->tx_chan_map_slot[0];
+		tx_group = &tx_group1;
 
 		rx_porth = rx_porth1;
 		rx_handles = rx_handles1;
@@ -349,6 +417,7 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 		rx_stream_idx = RX_STREAM_1;
 		rx_priv_counter = &priv->rx_chan_map_num[0];
 		rx_chan_map_slot = priv->rx_chan_map_slot[0];
+		rx_group = &rx_group1;
 		break;
 	case 5: /* cs47l35-slim2 */
 		tx_porth = tx_porth2;
@@ -358,6 +427,7 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 		tx_stream_idx = TX_STREAM_2;
 		tx_priv_counter = &priv->tx_chan_map_num[1];
 		tx_chan_map_slot = priv->tx_chan_map_slot[1];
+		tx_group = &tx_group2;
 
 		rx_porth = rx_porth2;
 		rx_handles = rx_handles2;
@@ -366,6 +436,7 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 		rx_stream_idx = RX_STREAM_2;
 		rx_priv_counter = &priv->rx_chan_map_num[1];
 		rx_chan_map_slot = priv->rx_chan_map_slot[1];
+		rx_group = &rx_group2;
 		break;
 	default:
 		dev_err(madera->dev, "set_channel_map unknown dai->id %d\n",
@@ -383,6 +454,17 @@ int madera_set_channel_map(struct snd_soc_dai *dai,
 	if (tx_num > 0)
 		*tx_priv_counter = tx_num;
 
+	/* The ports and channels may change, redefine the groups on next use */
+	mutex_lock(&slim_rx_lock);
+	if (rx_num > 0)
+		rx_group->stale = true;
+	mutex_unlock(&slim_rx_lock);
+
+	mutex_lock(&slim_tx_lock);
+	if (tx_num > 0)
+		tx_group->stale = true;
+	mutex_unlock(&slim_tx_lock);
+
 	/* This actually allocates the channel or refcounts it if there... */
 	for (i = 0; i < rx_num; i++) {
 		slim_get_slaveport(laddr, i + rx_idx_step, &rx_porth[i],
@@ -501,6 +583,19 @@ static int madera_slim_device_down(struct slim_device *slim)
 	if (slim == NULL)
 		return -EINVAL;
 
+	/* The bus has dropped all channel definitions */
+	mutex_lock(&slim_rx_lock);
+	rx_group1.defined = false;
+	rx_group2.defined = false;
+	rx_group3.defined = false;
+	mutex_unlock(&slim_rx_lock);
+
+	mutex_lock(&slim_tx_lock);
+	tx_group1.defined = false;
+	tx_group2.defined = false;
+	tx_group3.defined = false;
+	mutex_unlock(&slim_tx_lock);
+
 	codec = slim_get_devicedata(slim);
 	if (codec != NULL) {
 		dev_info(&slim->dev, "%s handle SLIM DOWN\n", __func__);
@@ -8,10 +8,12 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gcd.h>
 #include <linux/module.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
@@ -373,7 +375,7 @@ static int madera_check_speaker_overheat(struct madera *madera,
 	unsigned int val;
 	int ret;
 
-	ret = regmap_read(madera->regmap, MADERA_IRQ1_RAW_STATUS_15, &val);
+	ret = madera_irq_read_status(madera, MADERA_IRQ1_RAW_STATUS_15, &val);
 	if (ret) {
 		dev_err(madera->dev, "Failed to read thermal status: %d\n",
 			ret);
@@ -534,6 +536,38 @@ static void madera_get_inmode_from_of(struct madera *madera)
 			 "cirrus,inmode", MADERA_MAX_MUXED_CHANNELS);
 }
 
+static void madera_get_dsp_clk_gov_from_of(struct madera *madera)
+{
+	struct madera_dsp_clk_gov_pdata *gov;
+	unsigned int load[5];
+	char prop[32];
+	int i, ret;
+
+	for (i = 0; i < MADERA_MAX_DSP; i++) {
+		gov = &madera->pdata.codec.dsp_clk_gov[i];
+
+		snprintf(prop, sizeof(prop), "cirrus,dsp%d-clk-levels", i + 1);
+		ret = madera_of_read_uint_array(madera, prop, false,
+						gov->levels, 1,
+						ARRAY_SIZE(gov->levels));
+		if (ret <= 0)
+			continue;
+
+		snprintf(prop, sizeof(prop), "cirrus,dsp%d-clk-load", i + 1);
+		if (madera_of_read_uint_array(madera, prop, true, load,
+					      ARRAY_SIZE(load),
+					      ARRAY_SIZE(load)) < 0)
+			continue;
+
+		gov->load_alg = load[0];
+		gov->load_offset = load[1];
+		gov->down_threshold = load[2];
+		gov->up_threshold = load[3];
+		gov->period_ms = load[4];
+		gov->n_levels = ret;
+	}
+}
+
 static void madera_get_pdata_from_of(struct madera *madera)
 {
 	struct madera_codec_pdata *pdata = &madera->pdata.codec;
@@ -571,10 +605,202 @@ static void madera_get_pdata_from_of(struct madera *madera)
 	madera_of_read_uint_array(madera, "cirrus,dmic-clksrc", false,
 				pdata->dmic_clksrc,
 				0, ARRAY_SIZE(pdata->dmic_clksrc));
+
+	madera_get_dsp_clk_gov_from_of(madera);
+}
+
+static const unsigned int madera_eq_base[MADERA_NUM_EQ] = {
+	MADERA_EQ1_2, MADERA_EQ2_2, MADERA_EQ3_2, MADERA_EQ4_2,
+};
+
+static bool madera_eq_filter_unstable(bool mode, __be16 _a, __be16 _b)
+{
+	s16 a = be16_to_cpu(_a);
+	s16 b = be16_to_cpu(_b);
+
+	if (!mode) {
+		return abs(a) >= 4096;
+	} else {
+		if (abs(b) >= 4096)
+			return true;
+
+		return (abs((a << 16) / (4096 - b)) >= 4096 << 4);
+	}
+}
+
+static bool madera_eq_coeffs_unstable(bool mode, const __be16 *data)
+{
+	return madera_eq_filter_unstable(mode, data[1], data[2]) ||
+	       madera_eq_filter_unstable(true, data[4], data[5]) ||
+	       madera_eq_filter_unstable(true, data[8], data[9]) ||
+	       madera_eq_filter_unstable(true, data[12], data[13]) ||
+	       madera_eq_filter_unstable(false, data[16], data[17]);
+}
+
+static void madera_eq_ramp_work(struct work_struct *work)
+{
+	struct madera_eq_ramp *ramp =
+		container_of(work, struct madera_eq_ramp, work);
+	struct madera_priv *priv = ramp->priv;
+	struct madera *madera = priv->madera;
+	int i, ret;
+	s16 val;
+
+	mutex_lock(&priv->eq_ramp_lock);
+
+	if (ramp->step >= ramp->steps)
+		goto out;
+
+	ramp->step++;
+
+	for (i = 1; i < MADERA_EQ_NUM_REGS; i++) {
+		val = ramp->from[i] + ((ramp->to[i] - ramp->from[i]) *
+				       ramp->step) / ramp->steps;
+		ramp->buf[i] = cpu_to_be16(val);
+	}
+
+	/*
+	 * The end points have already been checked, if an intermediate set
+	 * would be unstable just hold the previous one for this step.
+	 */
+	if (ramp->step < ramp->steps &&
+	    madera_eq_coeffs_unstable(ramp->mode, ramp->buf)) {
+		dev_dbg(madera->dev, "Skipping unstable EQ ramp step %d/%d\n",
+			ramp->step, ramp->steps);
+	} else {
+		/* Mode is unchanged so the first register is left alone */
+		ret = regmap_raw_write(madera->regmap, ramp->base + 1,
+				       &ramp->buf[1],
+				       (MADERA_EQ_NUM_REGS - 1) *
+				       sizeof(ramp->buf[0]));
+		if (ret) {
+			dev_err(madera->dev, "Failed to write EQ ramp: %d\n",
+				ret);
+			ramp->step = ramp->steps = 0;
+			goto out;
+		}
+	}
+
+	if (ramp->step < ramp->steps)
+		hrtimer_start(&ramp->timer,
+			      us_to_ktime(priv->eq_ramp_step_us),
+			      HRTIMER_MODE_REL);
+
+out:
+	mutex_unlock(&priv->eq_ramp_lock);
+}
+
+static enum hrtimer_restart madera_eq_ramp_timer(struct hrtimer *timer)
+{
+	struct madera_eq_ramp *ramp =
+		container_of(timer, struct madera_eq_ramp, timer);
+
+	queue_work(system_highpri_wq, &ramp->work);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Consecutive low load samples required before stepping the clock down */
+#define MADERA_DSP_GOV_DOWN_SAMPLES	4
+
+/* Called with dsp_gov_lock held */
+static void madera_dsp_gov_account(struct madera_dsp_gov *gov)
+{
+	ktime_t now = ktime_get();
+
+	gov->time_in_state_us[gov->level] += ktime_us_delta(now, gov->stamp);
+	gov->stamp = now;
+}
+
+static void madera_dsp_gov_work(struct work_struct *work)
+{
+	struct madera_dsp_gov *gov = container_of(to_delayed_work(work),
+						  struct madera_dsp_gov, work);
+	struct madera_priv *priv = gov->priv;
+	const struct madera_dsp_clk_gov_pdata *pdata =
+		&priv->madera->pdata.codec.dsp_clk_gov[gov->num];
+	struct wm_adsp *dsp = &priv->adsp[gov->num];
+	int level, ret;
+	u32 load;
+
+	ret = wm_adsp_read_alg_xm(dsp, pdata->load_alg, pdata->load_offset,
+				  &load);
+
+	mutex_lock(&priv->dsp_gov_lock);
+
+	if (!gov->active)
+		goto out;
+
+	/* -EBUSY just means the firmware isn't running yet */
+	if (ret) {
+		if (ret != -EBUSY)
+			dev_dbg(priv->madera->dev,
+				"DSP%d: failed to sample load: %d\n",
+				dsp->num, ret);
+		goto resched;
+	}
+
+	level = gov->level;
+
+	if (load > pdata->up_threshold) {
+		gov->low_samples = 0;
+		if (level < gov->n_levels - 1)
+			level++;
+	} else if (load < pdata->down_threshold) {
+		if (++gov->low_samples >= MADERA_DSP_GOV_DOWN_SAMPLES &&
+		    level > 0) {
+			gov->low_samples = 0;
+			level--;
+		}
+	} else {
+		gov->low_samples = 0;
+	}
+
+	if (level == gov->level)
+		goto resched;
+
+	ret = madera_set_adsp_clk(dsp, gov->levels[level]);
+	if (ret) {
+		dev_warn(priv->madera->dev,
+			 "DSP%d: failed to set clock level %d: %d\n",
+			 dsp->num, level, ret);
+		goto resched;
+	}
+
+	dev_dbg(priv->madera->dev, "DSP%d: load %u, clock level %d->%d\n",
+		dsp->num, load, gov->level, level);
+
+	madera_dsp_gov_account(gov);
+	gov->level = level;
+	gov->transitions++;
+
+resched:
+	schedule_delayed_work(&gov->work, msecs_to_jiffies(pdata->period_ms));
+out:
+	mutex_unlock(&priv->dsp_gov_lock);
+}
+
+static int madera_power_notify(struct notifier_block *nb,
+			       unsigned long event, void *data)
+{
+	struct madera_priv *priv = container_of(nb, struct madera_priv,
+						power_nb);
+	int i;
+
+	if (event != MADERA_NOTIFY_POWER_OFF)
+		return NOTIFY_DONE;
+
+	/* DSP memory doesn't survive DCVDD being removed */
+	for (i = 0; i < ARRAY_SIZE(priv->adsp); i++)
+		wm_adsp_power_lost(&priv->adsp[i]);
+
+	return NOTIFY_OK;
 }
 
 int madera_core_init(struct madera_priv *priv)
 {
+	int i;
+
 	BUILD_BUG_ON(ARRAY_SIZE(madera_mixer_texts) != MADERA_NUM_MIXER_INPUTS);
 	BUILD_BUG_ON(ARRAY_SIZE(madera_mixer_values) !=
 		MADERA_NUM_MIXER_INPUTS);
@@ -592,6 +818,30 @@ int madera_core_init(struct madera_priv *priv)
 	mutex_init(&priv->adsp_rate_lock);
 	mutex_init(&priv->rate_lock);
 	mutex_init(&priv->adsp_fw_lock);
+	mutex_init(&priv->preset_lock);
+	mutex_init(&priv->eq_ramp_lock);
+	mutex_init(&priv->dsp_gov_lock);
+
+	priv->eq_ramp_step_us = MADERA_EQ_RAMP_DEFAULT_STEP_US;
+
+	for (i = 0; i < ARRAY_SIZE(priv->dsp_gov); i++) {
+		priv->dsp_gov[i].priv = priv;
+		priv->dsp_gov[i].num = i;
+		INIT_DELAYED_WORK(&priv->dsp_gov[i].work, madera_dsp_gov_work);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(priv->eq_ramp); i++) {
+		priv->eq_ramp[i].priv = priv;
+		priv->eq_ramp[i].base = madera_eq_base[i];
+		INIT_WORK(&priv->eq_ramp[i].work, madera_eq_ramp_work);
+		hrtimer_init(&priv->eq_ramp[i].timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		priv->eq_ramp[i].timer.function = madera_eq_ramp_timer;
+	}
+
+	priv->power_nb.notifier_call = madera_power_notify;
+	blocking_notifier_chain_register(&priv->madera->notifier,
+					 &priv->power_nb);
 
 	return 0;
 }
@@ -599,9 +849,29 @@ EXPORT_SYMBOL_GPL(madera_core_init);
 
 int madera_core_destroy(struct madera_priv *priv)
 {
+	int i;
+
+	blocking_notifier_chain_unregister(&priv->madera->notifier,
+					   &priv->power_nb);
+
+	for (i = 0; i < ARRAY_SIZE(priv->eq_ramp); i++) {
+		mutex_lock(&priv->eq_ramp_lock);
+		priv->eq_ramp[i].steps = 0;
+		mutex_unlock(&priv->eq_ramp_lock);
+
+		hrtimer_cancel(&priv->eq_ramp[i].timer);
+		cancel_work_sync(&priv->eq_ramp[i].work);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(priv->dsp_gov); i++)
+		cancel_delayed_work_sync(&priv->dsp_gov[i].work);
+
 	mutex_destroy(&priv->adsp_rate_lock);
 	mutex_destroy(&priv->rate_lock);
 	mutex_destroy(&priv->adsp_fw_lock);
+	mutex_destroy(&priv->preset_lock);
+	mutex_destroy(&priv->eq_ramp_lock);
+	mutex_destroy(&priv->dsp_gov_lock);
 
 	return 0;
 }
@@ -1069,6 +1339,57 @@ out:
 }
 EXPORT_SYMBOL_GPL(madera_set_adsp_clk);
 
+/*
+ * Start scaling the DSP clock with the firmware load, the clock supplied
+ * at power up is the top level and the DSP starts there.
+ */
+void madera_start_adsp_clk_gov(struct wm_adsp *dsp, unsigned int freq)
+{
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(dsp->codec);
+	const struct madera_dsp_clk_gov_pdata *pdata =
+		&priv->madera->pdata.codec.dsp_clk_gov[dsp->num - 1];
+	struct madera_dsp_gov *gov = &priv->dsp_gov[dsp->num - 1];
+
+	if (!pdata->n_levels || !pdata->period_ms)
+		return;
+
+	cancel_delayed_work_sync(&gov->work);
+
+	mutex_lock(&priv->dsp_gov_lock);
+
+	memcpy(gov->levels, pdata->levels,
+	       pdata->n_levels * sizeof(*pdata->levels));
+	gov->levels[pdata->n_levels] = freq;
+	gov->n_levels = pdata->n_levels + 1;
+	gov->level = pdata->n_levels;
+	gov->low_samples = 0;
+	gov->stamp = ktime_get();
+	gov->active = true;
+
+	schedule_delayed_work(&gov->work, msecs_to_jiffies(pdata->period_ms));
+
+	mutex_unlock(&priv->dsp_gov_lock);
+}
+EXPORT_SYMBOL_GPL(madera_start_adsp_clk_gov);
+
+void madera_stop_adsp_clk_gov(struct wm_adsp *dsp)
+{
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(dsp->codec);
+	struct madera_dsp_gov *gov = &priv->dsp_gov[dsp->num - 1];
+
+	mutex_lock(&priv->dsp_gov_lock);
+
+	if (gov->active) {
+		madera_dsp_gov_account(gov);
+		gov->active = false;
+	}
+
+	mutex_unlock(&priv->dsp_gov_lock);
+
+	cancel_delayed_work_sync(&gov->work);
+}
+EXPORT_SYMBOL_GPL(madera_stop_adsp_clk_gov);
+
 int madera_rate_put(struct snd_kcontrol *kcontrol,
 		    struct snd_ctl_elem_value *ucontrol)
 {
@@ -1357,6 +1678,120 @@ int madera_init_drc(struct snd_soc_codec *codec)
 }
 EXPORT_SYMBOL_GPL(madera_init_drc);
 
+#ifdef CONFIG_DEBUG_FS
+static int madera_aif_memo_show(struct seq_file *s, void *data)
+{
+	struct snd_soc_codec *codec = s->private;
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	struct madera_dai_priv *dai_priv;
+	struct snd_soc_dai *dai;
+
+	list_for_each_entry(dai, &codec->component.dai_list, list) {
+		if (dai->driver->ops != &madera_dai_ops)
+			continue;
+
+		dai_priv = &priv->dai[dai->id - 1];
+
+		seq_printf(s, "%s: hits=%u misses=%u", dai->name,
+			   dai_priv->memo_hits, dai_priv->memo_misses);
+
+		if (dai_priv->memo.valid)
+			seq_printf(s, " rate=%u bclk=%d lrclk=%d frame=0x%x",
+				   dai_priv->memo.rate, dai_priv->memo.bclk,
+				   dai_priv->memo.lrclk, dai_priv->memo.frame);
+
+		seq_puts(s, "\n");
+	}
+
+	return 0;
+}
+
+static int madera_dsp_clk_gov_show(struct seq_file *s, void *data)
+{
+	struct snd_soc_codec *codec = s->private;
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	struct madera_dsp_gov *gov;
+	u64 us;
+	int i, j;
+
+	mutex_lock(&priv->dsp_gov_lock);
+
+	for (i = 0; i < ARRAY_SIZE(priv->dsp_gov); i++) {
+		gov = &priv->dsp_gov[i];
+		if (!gov->n_levels)
+			continue;
+
+		seq_printf(s, "DSP%d: %s level=%d transitions=%u\n", i + 1,
+			   gov->active ? "active" : "idle", gov->level,
+			   gov->transitions);
+
+		for (j = 0; j < gov->n_levels; j++) {
+			us = gov->time_in_state_us[j];
+			if (gov->active && j == gov->level)
+				us += ktime_us_delta(ktime_get(), gov->stamp);
+
+			seq_printf(s, "  0x%x: %llu us\n", gov->levels[j], us);
+		}
+	}
+
+	mutex_unlock(&priv->dsp_gov_lock);
+
+	return 0;
+}
+
+static int madera_dsp_clk_gov_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, madera_dsp_clk_gov_show, inode->i_private);
+}
+
+static const struct file_operations madera_dsp_clk_gov_fops = {
+	.open = madera_dsp_clk_gov_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int madera_aif_memo_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, madera_aif_memo_show, inode->i_private);
+}
+
+static const struct file_operations madera_aif_memo_fops = {
+	.open = madera_aif_memo_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void madera_init_debugfs(struct snd_soc_codec *codec)
+{
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+
+	if (!codec->component.debugfs_root)
+		return;
+
+	if (!debugfs_create_file("aif_hw_params", 0444,
+				 codec->component.debugfs_root, codec,
+				 &madera_aif_memo_fops))
+		dev_warn(codec->dev, "Failed to create debugfs\n");
+
+	if (!debugfs_create_u32("coeff_preset_apply_us", 0444,
+				codec->component.debugfs_root,
+				&priv->preset_apply_us))
+		dev_warn(codec->dev, "Failed to create debugfs\n");
+
+	if (!debugfs_create_file("dsp_clk_gov", 0444,
+				 codec->component.debugfs_root, codec,
+				 &madera_dsp_clk_gov_fops))
+		dev_warn(codec->dev, "Failed to create debugfs\n");
+}
+#else
+void madera_init_debugfs(struct snd_soc_codec *codec)
+{
+}
+#endif
+EXPORT_SYMBOL_GPL(madera_init_debugfs);
+
 int madera_init_bus_error_irq(struct snd_soc_codec *codec, int dsp_num,
 			      irq_handler_t handler)
 {
@@ -1753,6 +2188,23 @@ const struct soc_enum madera_sample_rate[] = {
 };
 EXPORT_SYMBOL_GPL(madera_sample_rate);
 
+int madera_sample_rate_put(struct snd_kcontrol *kcontrol,
+			   struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	int ret;
+
+	ret = snd_soc_put_enum_double(kcontrol, ucontrol);
+
+	/* Cached AIF clocking decisions may depend on this rate */
+	if (ret > 0)
+		atomic_inc(&priv->aif_memo_gen);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(madera_sample_rate_put);
+
 const char * const madera_rate_text[MADERA_RATE_ENUM_SIZE] = {
 	"SYNCCLK rate 1", "SYNCCLK rate 2", "SYNCCLK rate 3",
 	"ASYNCCLK rate 1", "ASYNCCLK rate 2",
@@ -3016,6 +3468,9 @@ static int madera_set_fmt(struct snd_soc_dai *dai, unsigned int fmt)
 
 	base = dai->driver->base;
 
+	/* The format decides whether hw_params forces stereo clocking */
+	priv->dai[dai->id - 1].memo.valid = false;
+
 	lrclk = 0;
 	bclk = 0;
 
@@ -3218,6 +3673,17 @@ static int madera_startup(struct snd_pcm_substream *substream,
 					  &dai_priv->constraint);
 }
 
+static int madera_sr_val(unsigned int rate)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(madera_sr_vals); i++)
+		if (madera_sr_vals[i] == rate)
+			return i;
+
+	return -EINVAL;
+}
+
 static int madera_hw_params_rate(struct snd_pcm_substream *substream,
 				 struct snd_pcm_hw_params *params,
 				 struct snd_soc_dai *dai)
@@ -3226,39 +3692,46 @@ static int madera_hw_params_rate(struct snd_pcm_substream *substream,
 	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
 	struct madera_dai_priv *dai_priv = &priv->dai[dai->id - 1];
 	int base = dai->driver->base;
-	int ret = 0, err;
-	int i, sr_val, lim = 0;
+	int ret = 0, err, changed = 0;
+	int sr_val, lim = 0;
 	const unsigned int *sources = NULL;
 	unsigned int cur, tar;
 	bool change_rate = false;
-	u32 rx_sampleszbits, rx_samplerate;
+	bool playback = substream->stream == SNDRV_PCM_STREAM_PLAYBACK;
+	u32 sampleszbits, samplerate;
 
-	rx_sampleszbits = snd_pcm_format_width(params_format(params));
-	if (rx_sampleszbits < 16)
-		rx_sampleszbits = 16;
+	sampleszbits = snd_pcm_format_width(params_format(params));
+	if (sampleszbits < 16)
+		sampleszbits = 16;
 
 	/* currently we use a single sample rate for SYSCLK */
-	for (i = 0; i < ARRAY_SIZE(madera_sr_vals); i++)
-		if (madera_sr_vals[i] == params_rate(params)) {
-			rx_samplerate = params_rate(params);
-			break;
-		}
-
-	if (i == ARRAY_SIZE(madera_sr_vals)) {
+	sr_val = madera_sr_val(params_rate(params));
+	if (sr_val < 0) {
 		madera_aif_err(dai, "Unsupported sample rate %dHz\n",
 				params_rate(params));
 		return -EINVAL;
 	}
-	sr_val = i;
+	samplerate = params_rate(params);
 
+	/* Playback is carried on the SLIMbus RX channels, capture on TX */
 	switch (dai->id) {
 	case 4: /* cs47l35-slim1 */
-		priv->rx1_sampleszbits = rx_sampleszbits;
-		priv->rx1_samplerate = rx_samplerate;
+		if (playback) {
+			priv->rx1_sampleszbits = sampleszbits;
+			priv->rx1_samplerate = samplerate;
+		} else {
+			priv->tx1_sampleszbits = sampleszbits;
+			priv->tx1_samplerate = samplerate;
+		}
 		break;
 	case 5: /* cs47l35-slim2 */
-		priv->rx2_sampleszbits = rx_sampleszbits;
-		priv->rx2_samplerate = rx_samplerate;
+		if (playback) {
+			priv->rx2_sampleszbits = sampleszbits;
+			priv->rx2_samplerate = samplerate;
+		} else {
+			priv->tx2_sampleszbits = sampleszbits;
+			priv->tx2_samplerate = samplerate;
+		}
 		break;
 	case 6:
 	default:
@@ -3323,40 +3796,45 @@ static int madera_hw_params_rate(struct snd_pcm_substream *substream,
 
 	switch (dai_priv->clk) {
 	case MADERA_CLK_SYSCLK:
-		snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_1,
-				    MADERA_SAMPLE_RATE_1_MASK, sr_val);
+		changed = snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_1,
+					      MADERA_SAMPLE_RATE_1_MASK,
+					      sr_val);
 		if (base)
 			snd_soc_update_bits(codec, base + MADERA_AIF_RATE_CTRL,
 					    MADERA_AIF1_RATE_MASK,
 					    0 << MADERA_AIF1_RATE_SHIFT);
 		break;
 	case MADERA_CLK_SYSCLK_2:
-		snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_2,
-				    MADERA_SAMPLE_RATE_2_MASK, sr_val);
+		changed = snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_2,
+					      MADERA_SAMPLE_RATE_2_MASK,
+					      sr_val);
 		if (base)
 			snd_soc_update_bits(codec, base + MADERA_AIF_RATE_CTRL,
 					    MADERA_AIF1_RATE_MASK,
 					    1 << MADERA_AIF1_RATE_SHIFT);
 		break;
 	case MADERA_CLK_SYSCLK_3:
-		snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_3,
-				    MADERA_SAMPLE_RATE_3_MASK, sr_val);
+		changed = snd_soc_update_bits(codec, MADERA_SAMPLE_RATE_3,
+					      MADERA_SAMPLE_RATE_3_MASK,
+					      sr_val);
 		if (base)
 			snd_soc_update_bits(codec, base + MADERA_AIF_RATE_CTRL,
 					    MADERA_AIF1_RATE_MASK,
 					    2 << MADERA_AIF1_RATE_SHIFT);
 		break;
 	case MADERA_CLK_ASYNCCLK:
-		snd_soc_update_bits(codec, MADERA_ASYNC_SAMPLE_RATE_1,
-				    MADERA_ASYNC_SAMPLE_RATE_1_MASK, sr_val);
+		changed = snd_soc_update_bits(codec, MADERA_ASYNC_SAMPLE_RATE_1,
+					      MADERA_ASYNC_SAMPLE_RATE_1_MASK,
+					      sr_val);
 		if (base)
 			snd_soc_update_bits(codec, base + MADERA_AIF_RATE_CTRL,
 					    MADERA_AIF1_RATE_MASK,
 					    8 << MADERA_AIF1_RATE_SHIFT);
 		break;
 	case MADERA_CLK_ASYNCCLK_2:
-		snd_soc_update_bits(codec, MADERA_ASYNC_SAMPLE_RATE_2,
-				    MADERA_ASYNC_SAMPLE_RATE_2_MASK, sr_val);
+		changed = snd_soc_update_bits(codec, MADERA_ASYNC_SAMPLE_RATE_2,
+					      MADERA_ASYNC_SAMPLE_RATE_2_MASK,
+					      sr_val);
 		if (base)
 			snd_soc_update_bits(codec, base + MADERA_AIF_RATE_CTRL,
 					    MADERA_AIF1_RATE_MASK,
@@ -3367,6 +3845,10 @@ static int madera_hw_params_rate(struct snd_pcm_substream *substream,
 		ret = -EINVAL;
 	}
 
+	/* Other DAIs on this clock must redo their checks */
+	if (changed > 0)
+		atomic_inc(&priv->aif_memo_gen);
+
 	if (change_rate)
 		madera_spin_sysclk(priv);
 
@@ -3405,12 +3887,60 @@ static bool madera_aif_cfg_changed(struct snd_soc_codec *codec,
 	return false;
 }
 
+/*
+ * Outside hw_params the registers this depends on are only changed by
+ * set_fmt and the sample rate controls, which invalidate the memo, so an
+ * identical reopen has nothing to read back or rewrite. The direction is
+ * part of the key as hw_params also records the per-direction SLIMbus rates.
+ */
+static bool madera_aif_memo_match(struct madera_priv *priv,
+				  struct madera_dai_priv *dai_priv,
+				  struct snd_pcm_hw_params *params, int id,
+				  int stream)
+{
+	const struct madera_aif_memo *memo = &dai_priv->memo;
+
+	return memo->valid &&
+	       memo->gen == atomic_read(&priv->aif_memo_gen) &&
+	       memo->stream == stream &&
+	       memo->rate == params_rate(params) &&
+	       memo->format == params_format(params) &&
+	       memo->channels == params_channels(params) &&
+	       memo->clk == dai_priv->clk &&
+	       memo->tdm_slots == priv->tdm_slots[id] &&
+	       memo->tdm_width == priv->tdm_width[id];
+}
+
+static void madera_aif_memo_store(struct madera_priv *priv,
+				  struct madera_dai_priv *dai_priv,
+				  struct snd_pcm_hw_params *params, int id,
+				  int stream, unsigned int gen, int bclk,
+				  int lrclk, int frame)
+{
+	struct madera_aif_memo *memo = &dai_priv->memo;
+
+	memo->gen = gen;
+	memo->stream = stream;
+	memo->rate = params_rate(params);
+	memo->format = params_format(params);
+	memo->channels = params_channels(params);
+	memo->clk = dai_priv->clk;
+	memo->tdm_slots = priv->tdm_slots[id];
+	memo->tdm_width = priv->tdm_width[id];
+	memo->bclk = bclk;
+	memo->lrclk = lrclk;
+	memo->frame = frame;
+	memo->sr_val = madera_sr_val(memo->rate);
+	memo->valid = true;
+}
+
 static int madera_hw_params(struct snd_pcm_substream *substream,
 			    struct snd_pcm_hw_params *params,
 			    struct snd_soc_dai *dai)
 {
 	struct snd_soc_codec *codec = dai->codec;
 	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	struct madera_dai_priv *dai_priv = &priv->dai[dai->id - 1];
 	struct madera *madera = priv->madera;
 	int base = dai->driver->base;
 	const int *rates;
@@ -3422,6 +3952,22 @@ static int madera_hw_params(struct snd_pcm_substream *substream,
 	int bclk, lrclk, wl, frame, bclk_target;
 	bool reconfig;
 	unsigned int aif_tx_state = 0, aif_rx_state = 0;
+	unsigned int gen;
+
+	if (madera_aif_memo_match(priv, dai_priv, params, dai->id - 1,
+				  substream->stream)) {
+		dai_priv->memo_hits++;
+		madera_aif_dbg(dai, "Unchanged: BCLK %d LRCLK %d SR %d\n",
+			       dai_priv->memo.bclk, dai_priv->memo.lrclk,
+			       dai_priv->memo.sr_val);
+		return 0;
+	}
+
+	dai_priv->memo_misses++;
+	dai_priv->memo.valid = false;
+
+	/* Sampled first so a change made below isn't hidden from a reopen */
+	gen = atomic_read(&priv->aif_memo_gen);
 
 	if (params_rate(params) % 4000)
 		rates = &madera_44k1_bclk_rates[0];
@@ -3531,6 +4077,12 @@ restore_aif:
 				   base + MADERA_AIF_RX_ENABLES,
 				   0xff, aif_rx_state);
 	}
+
+	if (ret == 0)
+		madera_aif_memo_store(priv, dai_priv, params, dai->id - 1,
+				      substream->stream, gen, bclk, lrclk,
+				      frame);
+
 	return ret;
 }
 
@@ -4740,26 +5292,74 @@ int madera_frf_bytes_put(struct snd_kcontrol *kcontrol,
 }
 EXPORT_SYMBOL_GPL(madera_frf_bytes_put);
 
-static bool madera_eq_filter_unstable(bool mode, __be16 _a, __be16 _b)
+/*
+ * Returns true if the EQ will be stepped to the new coefficients, false if
+ * the caller should write them directly.
+ */
+static bool madera_eq_ramp_start(struct madera_priv *priv, unsigned int base,
+				 const __be16 *data, unsigned int reg0)
 {
-	s16 a = be16_to_cpu(_a);
-	s16 b = be16_to_cpu(_b);
+	struct madera *madera = priv->madera;
+	struct madera_eq_ramp *ramp = NULL;
+	u16 cur[MADERA_EQ_NUM_REGS];
+	unsigned int ena;
+	int i, ret;
 
-	if (!mode) {
-		return abs(a) >= 4096;
-	} else {
-		if (abs(b) >= 4096)
-			return true;
+	for (i = 0; i < ARRAY_SIZE(madera_eq_base); i++)
+		if (madera_eq_base[i] == base)
+			ramp = &priv->eq_ramp[i];
 
-		return (abs((a << 16) / (4096 - b)) >= 4096 << 4);
+	if (!ramp)
+		return false;
+
+	mutex_lock(&priv->eq_ramp_lock);
+
+	/* Any ramp in progress is superseded by the new coefficients */
+	ramp->step = ramp->steps = 0;
+
+	if (!priv->eq_ramp_steps)
+		goto direct;
+
+	/* Can't step between filter modes, nor worth it if nothing plays */
+	if ((reg0 & MADERA_EQ1_B1_MODE) !=
+	    (be16_to_cpu(data[0]) & MADERA_EQ1_B1_MODE))
+		goto direct;
+
+	ret = regmap_read(madera->regmap, base - 1, &ena);
+	if (ret || !(ena & MADERA_EQ1_ENA))
+		goto direct;
+
+	ret = regmap_bulk_read(madera->regmap, base, cur, ARRAY_SIZE(cur));
+	if (ret)
+		goto direct;
+
+	for (i = 0; i < MADERA_EQ_NUM_REGS; i++) {
+		ramp->from[i] = cur[i];
+		ramp->to[i] = be16_to_cpu(data[i]);
 	}
+
+	ramp->mode = reg0 & MADERA_EQ1_B1_MODE;
+	ramp->steps = priv->eq_ramp_steps;
+
+	if (!hrtimer_active(&ramp->timer))
+		queue_work(system_highpri_wq, &ramp->work);
+
+	mutex_unlock(&priv->eq_ramp_lock);
+
+	return true;
+
+direct:
+	mutex_unlock(&priv->eq_ramp_lock);
+
+	return false;
 }
 
 int madera_eq_coeff_put(struct snd_kcontrol *kcontrol,
 			struct snd_ctl_elem_value *ucontrol)
 {
 	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
-	struct madera *madera = dev_get_drvdata(codec->dev->parent);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	struct madera *madera = priv->madera;
 	struct soc_bytes *params = (void *)kcontrol->private_value;
 	unsigned int val;
 	__be16 *data;
@@ -4774,11 +5374,7 @@ int madera_eq_coeff_put(struct snd_kcontrol *kcontrol,
 
 	data[0] &= cpu_to_be16(MADERA_EQ1_B1_MODE);
 
-	if (madera_eq_filter_unstable(!!data[0], data[1], data[2]) ||
-	    madera_eq_filter_unstable(true, data[4], data[5]) ||
-	    madera_eq_filter_unstable(true, data[8], data[9]) ||
-	    madera_eq_filter_unstable(true, data[12], data[13]) ||
-	    madera_eq_filter_unstable(false, data[16], data[17])) {
+	if (madera_eq_coeffs_unstable(!!data[0], data)) {
 		dev_err(madera->dev, "Rejecting unstable EQ coefficients\n");
 		ret = -EINVAL;
 		goto out;
@@ -4788,6 +5384,9 @@ int madera_eq_coeff_put(struct snd_kcontrol *kcontrol,
 	if (ret != 0)
 		goto out;
 
+	if (madera_eq_ramp_start(priv, params->base, data, val))
+		goto out;
+
 	val &= ~MADERA_EQ1_B1_MODE;
 	data[0] |= cpu_to_be16(val);
 
@@ -4816,6 +5415,358 @@ int madera_lhpf_coeff_put(struct snd_kcontrol *kcontrol,
 }
 EXPORT_SYMBOL_GPL(madera_lhpf_coeff_put);
 
+int madera_eq_ramp_steps_get(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+
+	ucontrol->value.integer.value[0] = priv->eq_ramp_steps;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_eq_ramp_steps_get);
+
+int madera_eq_ramp_steps_put(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	long val = ucontrol->value.integer.value[0];
+
+	if (val < 0 || val > MADERA_EQ_RAMP_MAX_STEPS)
+		return -EINVAL;
+
+	mutex_lock(&priv->eq_ramp_lock);
+	priv->eq_ramp_steps = val;
+	mutex_unlock(&priv->eq_ramp_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_eq_ramp_steps_put);
+
+int madera_eq_ramp_step_us_get(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+
+	ucontrol->value.integer.value[0] = priv->eq_ramp_step_us;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_eq_ramp_step_us_get);
+
+int madera_eq_ramp_step_us_put(struct snd_kcontrol *kcontrol,
+			       struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	long val = ucontrol->value.integer.value[0];
+
+	if (val < 0 || val > MADERA_EQ_RAMP_MAX_STEP_US)
+		return -EINVAL;
+
+	mutex_lock(&priv->eq_ramp_lock);
+	priv->eq_ramp_step_us = val;
+	mutex_unlock(&priv->eq_ramp_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_eq_ramp_step_us_put);
+
+static const struct {
+	unsigned int base;
+	unsigned int mask;
+} madera_coeff_preset_drc[] = {
+	{ MADERA_DRC1_CTRL1, MADERA_DRC1R_ENA | MADERA_DRC1L_ENA },
+	{ MADERA_DRC2_CTRL1, MADERA_DRC2R_ENA | MADERA_DRC2L_ENA },
+};
+
+static const unsigned int madera_coeff_preset_lhpf_base[] = {
+	MADERA_HPLPF1_2, MADERA_HPLPF2_2, MADERA_HPLPF3_2, MADERA_HPLPF4_2,
+};
+
+static int madera_check_coeff_preset(struct madera *madera,
+				     const struct madera_coeff_preset *preset)
+{
+	unsigned int blocks = be32_to_cpu(preset->blocks);
+	const __be16 *eq;
+	bool mode;
+	int i;
+
+	if (blocks & ~MADERA_COEFF_PRESET_ALL) {
+		dev_err(madera->dev, "Invalid preset block mask 0x%x\n",
+			blocks);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_EQ; i++) {
+		if (!(blocks & MADERA_COEFF_PRESET_EQ(i)))
+			continue;
+
+		eq = preset->eq[i];
+		mode = !!(eq[0] & cpu_to_be16(MADERA_EQ1_B1_MODE));
+
+		if (madera_eq_coeffs_unstable(mode, eq)) {
+			dev_err(madera->dev,
+				"Rejecting unstable EQ%d preset\n", i + 1);
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_LHPF; i++) {
+		if (!(blocks & MADERA_COEFF_PRESET_LHPF(i)))
+			continue;
+
+		if (abs((s16)be16_to_cpu(preset->lhpf[i])) >= 4096) {
+			dev_err(madera->dev,
+				"Rejecting unstable LHPF%d preset\n", i + 1);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int madera_store_coeff_preset(struct madera_priv *priv, int slot,
+			      const struct madera_coeff_preset *preset)
+{
+	int ret;
+
+	if (slot < 0 || slot >= MADERA_NUM_COEFF_PRESETS)
+		return -EINVAL;
+
+	ret = madera_check_coeff_preset(priv->madera, preset);
+	if (ret)
+		return ret;
+
+	mutex_lock(&priv->preset_lock);
+	priv->presets[slot] = *preset;
+	priv->presets[slot].name[MADERA_COEFF_PRESET_NAME_LEN - 1] = '\0';
+	priv->preset_valid |= BIT(slot);
+
+	/* The hardware no longer matches what is stored in this slot */
+	if (priv->preset_active == slot + 1)
+		priv->preset_active = 0;
+	mutex_unlock(&priv->preset_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_store_coeff_preset);
+
+int madera_find_coeff_preset(struct madera_priv *priv, const char *name)
+{
+	int i, ret = -ENOENT;
+
+	mutex_lock(&priv->preset_lock);
+	for (i = 0; i < MADERA_NUM_COEFF_PRESETS; i++) {
+		if (!(priv->preset_valid & BIT(i)))
+			continue;
+
+		if (!strncmp(priv->presets[i].name, name,
+			     MADERA_COEFF_PRESET_NAME_LEN)) {
+			ret = i;
+			break;
+		}
+	}
+	mutex_unlock(&priv->preset_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(madera_find_coeff_preset);
+
+static int madera_queue_coeff_block(struct madera *madera, unsigned int reg,
+				    unsigned int keep, __be16 *data,
+				    size_t len)
+{
+	unsigned int val;
+	int ret;
+
+	if (keep) {
+		ret = regmap_read(madera->regmap, reg, &val);
+		if (ret)
+			return ret;
+
+		data[0] &= cpu_to_be16(~keep);
+		data[0] |= cpu_to_be16(val & keep);
+	}
+
+	return regmap_raw_write_async(madera->regmap, reg, data, len);
+}
+
+int madera_apply_coeff_preset(struct madera_priv *priv, int slot)
+{
+	struct madera *madera = priv->madera;
+	struct madera_coeff_preset *buf;
+	unsigned int blocks;
+	ktime_t start;
+	int i, ret = 0, ret2;
+
+	if (slot < 0 || slot >= MADERA_NUM_COEFF_PRESETS)
+		return -EINVAL;
+
+	mutex_lock(&priv->preset_lock);
+
+	if (!(priv->preset_valid & BIT(slot))) {
+		ret = -ENOENT;
+		goto out_unlock;
+	}
+
+	/* Async writes need a DMA safe buffer that lives until completion */
+	buf = kmemdup(&priv->presets[slot], sizeof(*buf),
+		      GFP_KERNEL | GFP_DMA);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	blocks = be32_to_cpu(buf->blocks);
+
+	/* Don't let an EQ coefficient ramp overwrite the preset */
+	mutex_lock(&priv->eq_ramp_lock);
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_EQ; i++)
+		if (blocks & MADERA_COEFF_PRESET_EQ(i))
+			priv->eq_ramp[i].step = priv->eq_ramp[i].steps = 0;
+	mutex_unlock(&priv->eq_ramp_lock);
+
+	start = ktime_get();
+
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_EQ && !ret; i++) {
+		if (blocks & MADERA_COEFF_PRESET_EQ(i))
+			ret = madera_queue_coeff_block(madera,
+						madera_eq_base[i],
+						~MADERA_EQ1_B1_MODE & 0xffff,
+						buf->eq[i], sizeof(buf->eq[i]));
+	}
+
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_DRC && !ret; i++) {
+		if (blocks & MADERA_COEFF_PRESET_DRC(i))
+			ret = madera_queue_coeff_block(madera,
+						madera_coeff_preset_drc[i].base,
+						madera_coeff_preset_drc[i].mask,
+						buf->drc[i],
+						sizeof(buf->drc[i]));
+	}
+
+	for (i = 0; i < MADERA_COEFF_PRESET_NUM_LHPF && !ret; i++) {
+		if (blocks & MADERA_COEFF_PRESET_LHPF(i))
+			ret = madera_queue_coeff_block(madera,
+					madera_coeff_preset_lhpf_base[i], 0,
+					&buf->lhpf[i], sizeof(buf->lhpf[i]));
+	}
+
+	/* Always drain anything already queued, even on error */
+	ret2 = regmap_async_complete(madera->regmap);
+	if (!ret)
+		ret = ret2;
+
+	kfree(buf);
+
+	if (ret) {
+		dev_err(madera->dev, "Failed to apply coeff preset %d: %d\n",
+			slot + 1, ret);
+		priv->preset_active = 0;
+		goto out_unlock;
+	}
+
+	priv->preset_active = slot + 1;
+	priv->preset_apply_us = ktime_to_us(ktime_sub(ktime_get(), start));
+
+	dev_dbg(madera->dev, "Applied coeff preset %d '%s' (0x%x) in %uus\n",
+		slot + 1, priv->presets[slot].name, blocks,
+		priv->preset_apply_us);
+
+out_unlock:
+	mutex_unlock(&priv->preset_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(madera_apply_coeff_preset);
+
+int madera_coeff_preset_info(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_BYTES;
+	uinfo->count = sizeof(struct madera_coeff_preset);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_coeff_preset_info);
+
+int madera_coeff_preset_get(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	int slot = kcontrol->private_value;
+
+	mutex_lock(&priv->preset_lock);
+	memcpy(ucontrol->value.bytes.data, &priv->presets[slot],
+	       sizeof(priv->presets[slot]));
+	mutex_unlock(&priv->preset_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_coeff_preset_get);
+
+int madera_coeff_preset_put(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	struct madera_coeff_preset *preset;
+	int ret;
+
+	preset = kmemdup(ucontrol->value.bytes.data, sizeof(*preset),
+			 GFP_KERNEL);
+	if (!preset)
+		return -ENOMEM;
+
+	ret = madera_store_coeff_preset(priv, kcontrol->private_value, preset);
+
+	kfree(preset);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(madera_coeff_preset_put);
+
+int madera_coeff_preset_apply_get(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+
+	ucontrol->value.integer.value[0] = priv->preset_active;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(madera_coeff_preset_apply_get);
+
+int madera_coeff_preset_apply_put(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct madera_priv *priv = snd_soc_codec_get_drvdata(codec);
+	long slot = ucontrol->value.integer.value[0];
+	int ret;
+
+	if (slot < 0 || slot > MADERA_NUM_COEFF_PRESETS)
+		return -EINVAL;
+
+	/* 0 means no preset, leave the current coefficients alone */
+	if (!slot)
+		return 0;
+
+	ret = madera_apply_coeff_preset(priv, slot - 1);
+	if (ret)
+		return ret;
+
+	/* The coefficients changed, so let ALSA notify listeners */
+	return 1;
+}
+EXPORT_SYMBOL_GPL(madera_coeff_preset_apply_put);
+
 int madera_register_notifier(struct snd_soc_codec *codec,
 			     struct notifier_block *nb)
 {
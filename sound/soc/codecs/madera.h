@@ -12,6 +12,8 @@
 #define _ASOC_MADERA_H
 
 #include <linux/completion.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 
 #include <sound/soc.h>
 #include <sound/madera-pdata.h>
@@ -108,12 +110,101 @@ struct madera_voice_trigger_info {
 	u16 err_msg[4];
 };
 
+/* Last clocking decision made by hw_params for an AIF */
+struct madera_aif_memo {
+	bool valid;
+	unsigned int gen;
+
+	int stream;
+	unsigned int rate;
+	snd_pcm_format_t format;
+	unsigned int channels;
+	int clk;
+	int tdm_slots;
+	int tdm_width;
+
+	int bclk;
+	int lrclk;
+	int frame;
+	int sr_val;
+};
+
 struct madera_dai_priv {
 	int clk;
 	struct snd_pcm_hw_constraint_list constraint;
 
 	int sample_rate;
 	int bit_width;
+
+	struct madera_aif_memo memo;
+	unsigned int memo_hits;
+	unsigned int memo_misses;
+};
+
+#define MADERA_NUM_EQ			4
+#define MADERA_EQ_NUM_REGS		20
+
+#define MADERA_EQ_RAMP_MAX_STEPS	64
+#define MADERA_EQ_RAMP_MAX_STEP_US	10000
+#define MADERA_EQ_RAMP_DEFAULT_STEP_US	1000
+
+/* State of an EQ stepping towards new coefficients */
+struct madera_eq_ramp {
+	struct madera_priv *priv;
+	struct hrtimer timer;
+	struct work_struct work;
+	unsigned int base;
+	bool mode;
+	int step;
+	int steps;
+	s16 from[MADERA_EQ_NUM_REGS];
+	s16 to[MADERA_EQ_NUM_REGS];
+	__be16 buf[MADERA_EQ_NUM_REGS] ____cacheline_aligned;
+};
+
+#define MADERA_NUM_COEFF_PRESETS	4
+#define MADERA_COEFF_PRESET_NAME_LEN	16
+#define MADERA_COEFF_PRESET_NUM_EQ	MADERA_NUM_EQ
+#define MADERA_COEFF_PRESET_EQ_REGS	MADERA_EQ_NUM_REGS
+#define MADERA_COEFF_PRESET_NUM_DRC	2
+#define MADERA_COEFF_PRESET_DRC_REGS	5
+#define MADERA_COEFF_PRESET_NUM_LHPF	4
+
+#define MADERA_COEFF_PRESET_EQ(n)	BIT(n)
+#define MADERA_COEFF_PRESET_DRC(n)	BIT(4 + (n))
+#define MADERA_COEFF_PRESET_LHPF(n)	BIT(6 + (n))
+#define MADERA_COEFF_PRESET_ALL		GENMASK(9, 0)
+
+/*
+ * Layout of a coefficient preset as written to a "Coeff Preset N" control.
+ * Blocks not selected in the blocks bitmap are left untouched when the
+ * preset is applied. Coefficients use the same big-endian register image
+ * as the individual EQ, DRC and LHPF controls.
+ */
+struct madera_coeff_preset {
+	char name[MADERA_COEFF_PRESET_NAME_LEN];
+	__be32 blocks;
+	__be16 eq[MADERA_COEFF_PRESET_NUM_EQ][MADERA_COEFF_PRESET_EQ_REGS];
+	__be16 drc[MADERA_COEFF_PRESET_NUM_DRC][MADERA_COEFF_PRESET_DRC_REGS];
+	__be16 lhpf[MADERA_COEFF_PRESET_NUM_LHPF];
+} __packed;
+
+struct madera_priv;
+
+struct madera_dsp_gov {
+	struct madera_priv *priv;
+	int num;
+	struct delayed_work work;
+
+	bool active;
+	int level;
+	int n_levels;
+	unsigned int levels[MADERA_MAX_DSP_CLK_LEVELS + 1];
+	unsigned int low_samples;
+
+	ktime_t stamp;
+	u64 time_in_state_us[MADERA_MAX_DSP_CLK_LEVELS + 1];
+	unsigned int transitions;
 };
 
 struct madera_priv {
@@ -139,6 +230,9 @@ struct madera_priv {
 	struct mutex rate_lock;
 	struct mutex adsp_fw_lock;
 
+	/* Bumped whenever a sample rate shared between DAIs changes */
+	atomic_t aif_memo_gen;
+
 	int tdm_width[MADERA_MAX_AIF];
 	int tdm_slots[MADERA_MAX_AIF];
 
@@ -160,7 +254,27 @@ struct madera_priv {
 	u32 rx1_sampleszbits;
 	u32 rx2_samplerate;
 	u32 rx2_sampleszbits;
+	u32 tx1_samplerate;
+	u32 tx1_sampleszbits;
+	u32 tx2_samplerate;
+	u32 tx2_sampleszbits;
 	u8 slim_logic_addr;
+
+	struct madera_coeff_preset presets[MADERA_NUM_COEFF_PRESETS];
+	unsigned int preset_valid;
+	int preset_active;
+	unsigned int preset_apply_us;
+	struct mutex preset_lock;
+
+	struct madera_eq_ramp eq_ramp[MADERA_NUM_EQ];
+	unsigned int eq_ramp_steps;
+	unsigned int eq_ramp_step_us;
+	struct mutex eq_ramp_lock;
+
+	struct madera_dsp_gov dsp_gov[MADERA_MAX_ADSP];
+	struct mutex dsp_gov_lock;
+
+	struct notifier_block power_nb;
 };
 
 struct madera_fll_cfg {
@@ -313,7 +427,8 @@ extern unsigned int madera_mixer_values[MADERA_NUM_MIXER_INPUTS];
 	MADERA_MIXER_ROUTES(name, name "R")
 
 #define MADERA_SAMPLE_RATE_CONTROL(name, domain) \
-	SOC_ENUM(name, madera_sample_rate[(domain) - 2])
+	SOC_ENUM_EXT(name, madera_sample_rate[(domain) - 2], \
+		     snd_soc_get_enum_double, madera_sample_rate_put)
 
 #define MADERA_RATE_ENUM(xname, xenum) \
 {	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname,\
@@ -326,7 +441,16 @@ extern unsigned int madera_mixer_values[MADERA_NUM_MIXER_INPUTS];
 	.info = snd_soc_bytes_info, .get = snd_soc_bytes_get,	\
 	.put = madera_eq_coeff_put, .private_value =		\
 	((unsigned long)&(struct soc_bytes) { .base = xbase,	\
-	 .num_regs = 20, .mask = ~MADERA_EQ1_B1_MODE }) }
+	 .num_regs = MADERA_EQ_NUM_REGS, .mask = ~MADERA_EQ1_B1_MODE }) }
+
+#define MADERA_EQ_RAMP_CONTROLS						\
+	SOC_SINGLE_EXT("EQ Coefficient Ramp Steps", SND_SOC_NOPM, 0,	\
+		       MADERA_EQ_RAMP_MAX_STEPS, 0,			\
+		       madera_eq_ramp_steps_get, madera_eq_ramp_steps_put), \
+	SOC_SINGLE_EXT("EQ Coefficient Ramp Step Time", SND_SOC_NOPM, 0, \
+		       MADERA_EQ_RAMP_MAX_STEP_US, 0,			\
+		       madera_eq_ramp_step_us_get,			\
+		       madera_eq_ramp_step_us_put)
 
 #define MADERA_LHPF_CONTROL(xname, xbase)			\
 {	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname,	\
@@ -342,6 +466,22 @@ extern unsigned int madera_mixer_values[MADERA_NUM_MIXER_INPUTS];
 	((unsigned long)&(struct soc_bytes) {.base = xbase,	\
 	 .num_regs = xregs }) }
 
+#define MADERA_COEFF_PRESET_CONTROL(xname, xslot)		\
+{	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname,	\
+	.info = madera_coeff_preset_info,			\
+	.get = madera_coeff_preset_get,				\
+	.put = madera_coeff_preset_put, .private_value = xslot }
+
+#define MADERA_COEFF_PRESET_CONTROLS					\
+	MADERA_COEFF_PRESET_CONTROL("Coeff Preset 1", 0),		\
+	MADERA_COEFF_PRESET_CONTROL("Coeff Preset 2", 1),		\
+	MADERA_COEFF_PRESET_CONTROL("Coeff Preset 3", 2),		\
+	MADERA_COEFF_PRESET_CONTROL("Coeff Preset 4", 3),		\
+	SOC_SINGLE_EXT("Coeff Preset Apply", SND_SOC_NOPM, 0,		\
+		       MADERA_NUM_COEFF_PRESETS, 0,			\
+		       madera_coeff_preset_apply_get,			\
+		       madera_coeff_preset_apply_put)
+
 /* 2 mixer inputs with a stride of n in the register address */
 #define MADERA_MIXER_INPUTS_2_N(_reg, n)	\
 	(_reg),					\
@@ -384,6 +524,8 @@ extern const char * const madera_dfc_type_text[MADERA_DFC_TYPE_ENUM_SIZE];
 extern const unsigned int madera_dfc_type_val[MADERA_DFC_TYPE_ENUM_SIZE];
 
 extern const struct soc_enum madera_sample_rate[];
+extern int madera_sample_rate_put(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_value *ucontrol);
 extern const struct soc_enum madera_isrc_fsl[];
 extern const struct soc_enum madera_isrc_fsh[];
 extern const struct soc_enum madera_asrc1_rate[];
@@ -463,6 +605,8 @@ extern int madera_adsp_rate_get(struct snd_kcontrol *kcontrol,
 extern int madera_adsp_rate_put(struct snd_kcontrol *kcontrol,
 				struct snd_ctl_elem_value *ucontrol);
 extern int madera_set_adsp_clk(struct wm_adsp *dsp, unsigned int freq);
+extern void madera_start_adsp_clk_gov(struct wm_adsp *dsp, unsigned int freq);
+extern void madera_stop_adsp_clk_gov(struct wm_adsp *dsp);
 
 extern int madera_rate_put(struct snd_kcontrol *kcontrol,
 			   struct snd_ctl_elem_value *ucontrol);
@@ -474,6 +618,31 @@ extern int madera_eq_coeff_put(struct snd_kcontrol *kcontrol,
 				struct snd_ctl_elem_value *ucontrol);
 extern int madera_lhpf_coeff_put(struct snd_kcontrol *kcontrol,
 				 struct snd_ctl_elem_value *ucontrol);
+extern int madera_eq_ramp_steps_get(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol);
+extern int madera_eq_ramp_steps_put(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_value *ucontrol);
+extern int madera_eq_ramp_step_us_get(struct snd_kcontrol *kcontrol,
+				      struct snd_ctl_elem_value *ucontrol);
+extern int madera_eq_ramp_step_us_put(struct snd_kcontrol *kcontrol,
+				      struct snd_ctl_elem_value *ucontrol);
+
+extern int madera_coeff_preset_info(struct snd_kcontrol *kcontrol,
+				    struct snd_ctl_elem_info *uinfo);
+extern int madera_coeff_preset_get(struct snd_kcontrol *kcontrol,
+				   struct snd_ctl_elem_value *ucontrol);
+extern int madera_coeff_preset_put(struct snd_kcontrol *kcontrol,
+				   struct snd_ctl_elem_value *ucontrol);
+extern int madera_coeff_preset_apply_get(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol);
+extern int madera_coeff_preset_apply_put(struct snd_kcontrol *kcontrol,
+					 struct snd_ctl_elem_value *ucontrol);
+
+extern int madera_store_coeff_preset(struct madera_priv *priv, int slot,
+				     const struct madera_coeff_preset *preset);
+extern int madera_find_coeff_preset(struct madera_priv *priv,
+				    const char *name);
+extern int madera_apply_coeff_preset(struct madera_priv *priv, int slot);
 
 extern int madera_set_sysclk(struct snd_soc_codec *codec, int clk_id,
 			     int source, unsigned int freq, int dir);
@@ -510,6 +679,7 @@ extern int madera_core_destroy(struct madera_priv *priv);
 extern int madera_init_spk(struct snd_soc_codec *codec, int n_channels);
 extern int madera_free_spk(struct snd_soc_codec *codec);
 extern int madera_init_drc(struct snd_soc_codec *codec);
+extern void madera_init_debugfs(struct snd_soc_codec *codec);
 extern int madera_init_inputs(struct snd_soc_codec *codec,
 			      const char * const *dmic_inputs,
 			      int n_dmic_inputs,
@@ -13,17 +13,25 @@
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/init.h>
+#include <linux/bsearch.h>
+#include <linux/crc32.h>
 #include <linux/delay.h>
+#include <linux/devcoredump.h>
 #include <linux/firmware.h>
+#include <linux/jhash.h>
 #include <linux/list.h>
 #include <linux/of.h>
 #include <linux/pm.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
 #include <linux/workqueue.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
@@ -34,11 +42,6 @@
 
 #include "wm_adsp.h"
 
-/*
- * Remove auto sync of RX and TX rate until implemented
- */
-#define REMOVE_SYNC_SET_RATE
-
 #define adsp_crit(_dsp, fmt, ...) \
 	dev_crit(_dsp->dev, "DSP%d: " fmt, _dsp->num, ##__VA_ARGS__)
 #define adsp_err(_dsp, fmt, ...) \
@@ -593,6 +596,23 @@ struct wm_adsp_compr_buf {
 	int read_index;
 	int avail;
 	int num;
+
+	/* History drained from the DSP ahead of the first read */
+	u8 *prefetch;
+	size_t prefetch_head;
+	size_t prefetch_len;
+	bool prefetch_active;
+
+	/* Position latched when the DSP last raised the buffer IRQ */
+	int write_index;
+	int irq_write_index;
+	ktime_t irq_time;
+	u64 irq_words;
+
+	/* Fragment being timed from its IRQ until it is read */
+	ktime_t lat_start;
+	unsigned int lat_target;
+	bool lat_pending;
 };
 
 #define WM_ADSP_DATA_WORD_SIZE         3
@@ -602,6 +622,8 @@ struct wm_adsp_compr_buf {
 #define WM_ADSP_MIN_FRAGMENT_SIZE      (64 * WM_ADSP_DATA_WORD_SIZE)
 #define WM_ADSP_MAX_FRAGMENT_SIZE      (4096 * WM_ADSP_DATA_WORD_SIZE)
 
+#define WM_ADSP_PREFETCH_CHUNK_WORDS   1024
+
 #define WM_ADSP_ALG_XM_STRUCT_MAGIC    0x49aec7
 #define WM_ADSP_ALG_XM2_STRUCT_MAGIC   0x2e07b0
 
@@ -613,6 +635,15 @@ struct wm_adsp_compr_buf {
 
 static int wm_adsp_buffer_init(struct wm_adsp *dsp);
 static int wm_adsp_buffer_free(struct wm_adsp *dsp);
+static int wm_adsp_buffer_recover(struct wm_adsp *dsp);
+static unsigned int wm_adsp_addr_div(struct wm_adsp *dsp);
+static void wm_adsp_drop_resident(struct wm_adsp *dsp);
+static bool wm_adsp_resident_intact(struct wm_adsp *dsp, unsigned int fw_id,
+				    unsigned int fw_id_version);
+static void wm_adsp_prefetch_work(struct work_struct *work);
+static void wm_adsp_reset_fw_state(struct wm_adsp *dsp);
+static size_t wm_adsp_region_len(struct wm_adsp *dsp,
+				 const struct wm_adsp_region *mem);
 
 struct wm_adsp_buffer_region {
 	unsigned int offset;
@@ -809,6 +840,303 @@ static ssize_t wm_adsp_debugfs_bin_read(struct file *file,
 	return ret;
 }
 
+#define WM_ADSP_MEM_WINDOW		SZ_32K
+
+struct wm_adsp_mem_debugfs {
+	struct wm_adsp *dsp;
+	const struct wm_adsp_region *mem;
+};
+
+struct wm_adsp_mem_file {
+	struct wm_adsp *dsp;
+	const struct wm_adsp_region *mem;
+
+	/* Read ahead window, only reused by sequential reads */
+	u8 *buf;
+	loff_t win_start;
+	size_t win_len;
+	loff_t next;
+};
+
+static int wm_adsp_debugfs_mem_open(struct inode *inode, struct file *file)
+{
+	struct wm_adsp_mem_debugfs *info = inode->i_private;
+	struct wm_adsp_mem_file *mf;
+
+	mf = kzalloc(sizeof(*mf), GFP_KERNEL);
+	if (!mf)
+		return -ENOMEM;
+
+	mf->buf = kmalloc(WM_ADSP_MEM_WINDOW, GFP_KERNEL | GFP_DMA);
+	if (!mf->buf) {
+		kfree(mf);
+		return -ENOMEM;
+	}
+
+	mf->dsp = info->dsp;
+	mf->mem = info->mem;
+	mf->next = -1;
+	file->private_data = mf;
+
+	return 0;
+}
+
+static int wm_adsp_debugfs_mem_release(struct inode *inode, struct file *file)
+{
+	struct wm_adsp_mem_file *mf = file->private_data;
+
+	kfree(mf->buf);
+	kfree(mf);
+
+	return 0;
+}
+
+static int wm_adsp_debugfs_mem_fill(struct wm_adsp_mem_file *mf, loff_t pos,
+				    size_t len)
+{
+	struct wm_adsp *dsp = mf->dsp;
+	unsigned int reg;
+	int ret;
+
+	/* Registers are 32 bits wide, always read whole ones */
+	mf->win_start = round_down(pos, 4);
+	mf->win_len = min_t(size_t, len - mf->win_start, WM_ADSP_MEM_WINDOW);
+
+	reg = mf->mem->base + mf->win_start / wm_adsp_addr_div(dsp);
+
+	ret = regmap_raw_read(dsp->regmap, reg, mf->buf, mf->win_len);
+	if (ret)
+		mf->win_len = 0;
+
+	return ret;
+}
+
+static ssize_t wm_adsp_debugfs_mem_read(struct file *file,
+					char __user *user_buf,
+					size_t count, loff_t *ppos)
+{
+	struct wm_adsp_mem_file *mf = file->private_data;
+	struct wm_adsp *dsp = mf->dsp;
+	loff_t pos = *ppos;
+	size_t len, n;
+	ssize_t ret = 0;
+	int err;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	if (!dsp->booted) {
+		ret = -EIO;
+		goto out;
+	}
+
+	len = wm_adsp_region_len(dsp, mf->mem);
+	if (pos < 0 || pos >= len)
+		goto out;
+
+	count = min_t(size_t, count, len - pos);
+
+	/* Anything but a sequential read must see fresh data */
+	if (pos != mf->next)
+		mf->win_len = 0;
+
+	while (count) {
+		if (pos < mf->win_start || pos >= mf->win_start + mf->win_len) {
+			err = wm_adsp_debugfs_mem_fill(mf, pos, len);
+			if (err) {
+				if (!ret)
+					ret = err;
+				break;
+			}
+		}
+
+		n = min_t(size_t, count, mf->win_start + mf->win_len - pos);
+		if (copy_to_user(user_buf + ret,
+				 mf->buf + (pos - mf->win_start), n)) {
+			if (!ret)
+				ret = -EFAULT;
+			break;
+		}
+
+		pos += n;
+		ret += n;
+		count -= n;
+	}
+
+	if (ret > 0) {
+		*ppos = pos;
+		mf->next = pos;
+	}
+
+out:
+	mutex_unlock(&dsp->pwr_lock);
+
+	return ret;
+}
+
+static const struct file_operations wm_adsp_debugfs_mem_fops = {
+	.open = wm_adsp_debugfs_mem_open,
+	.read = wm_adsp_debugfs_mem_read,
+	.llseek = default_llseek,
+	.release = wm_adsp_debugfs_mem_release,
+};
+
+static const char *wm_adsp_debugfs_mem_name(int type)
+{
+	switch (type) {
+	case WMFW_ADSP2_XM:
+		return "xm";
+	case WMFW_ADSP2_YM:
+		return "ym";
+	case WMFW_ADSP2_PM:
+	case WMFW_HALO_PM_PACKED:
+		return "pm";
+	case WMFW_ADSP2_ZM:
+		return "zm";
+	default:
+		/* Packed HALO XM/YM alias the unpacked regions */
+		return NULL;
+	}
+}
+
+static int wm_adsp_debugfs_create_mem(struct wm_adsp *dsp,
+				      struct dentry *root)
+{
+	struct wm_adsp_mem_debugfs *info;
+	const char *name;
+	int i;
+
+	info = devm_kcalloc(dsp->dev, dsp->num_mems, sizeof(*info),
+			    GFP_KERNEL);
+	if (!info)
+		return -ENOMEM;
+
+	for (i = 0; i < dsp->num_mems; i++) {
+		name = wm_adsp_debugfs_mem_name(dsp->mem[i].type);
+		if (!name)
+			continue;
+
+		info[i].dsp = dsp;
+		info[i].mem = &dsp->mem[i];
+
+		if (!debugfs_create_file(name, S_IRUSR, root, &info[i],
+					 &wm_adsp_debugfs_mem_fops))
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static const char * const wm_adsp_bus_stat_names[] = {
+	[WM_ADSP_BUS_WMFW] = "wmfw",
+	[WM_ADSP_BUS_COEFF] = "coeff",
+	[WM_ADSP_BUS_STREAM] = "stream",
+	[WM_ADSP_BUS_SETUP] = "setup",
+};
+
+static int wm_adsp_debugfs_bus_stats_show(struct seq_file *s, void *data)
+{
+	struct wm_adsp *dsp = s->private;
+	struct wm_adsp_bus_stats *stats;
+	int i;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	for (i = 0; i < WM_ADSP_BUS_NUM_STATS; i++) {
+		stats = &dsp->bus_stats[i];
+		seq_printf(s, "%s: ops=%u transactions=%u bytes=%llu\n",
+			   wm_adsp_bus_stat_names[i], stats->ops,
+			   stats->transactions, stats->bytes);
+	}
+
+	mutex_unlock(&dsp->pwr_lock);
+
+	return 0;
+}
+
+static int wm_adsp_debugfs_bus_stats_open(struct inode *inode,
+					  struct file *file)
+{
+	return single_open(file, wm_adsp_debugfs_bus_stats_show,
+			   inode->i_private);
+}
+
+static ssize_t wm_adsp_debugfs_bus_stats_write(struct file *file,
+					       const char __user *user_buf,
+					       size_t count, loff_t *ppos)
+{
+	struct wm_adsp *dsp = ((struct seq_file *)file->private_data)->private;
+
+	mutex_lock(&dsp->pwr_lock);
+	memset(dsp->bus_stats, 0, sizeof(dsp->bus_stats));
+	mutex_unlock(&dsp->pwr_lock);
+
+	return count;
+}
+
+static const struct file_operations wm_adsp_debugfs_bus_stats_fops = {
+	.open = wm_adsp_debugfs_bus_stats_open,
+	.read = seq_read,
+	.write = wm_adsp_debugfs_bus_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int wm_adsp_debugfs_compr_latency_show(struct seq_file *s, void *data)
+{
+	struct wm_adsp *dsp = s->private;
+	struct wm_adsp_latency_stats *stats = &dsp->compr_latency;
+	struct wm_adsp_compr_buf *buf;
+	int i;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	seq_printf(s, "fragments=%u last=%uus min=%uus max=%uus avg=%lluus\n",
+		   stats->count, stats->last_us, stats->min_us, stats->max_us,
+		   stats->count ? div_u64(stats->total_us, stats->count) : 0);
+
+	for (i = 0; i < dsp->buf_num; i++) {
+		buf = dsp->buffer[i];
+		if (!buf)
+			continue;
+
+		seq_printf(s, "buf%d: irq=%lldns write=%d words=%llu\n",
+			   i, ktime_to_ns(buf->irq_time), buf->irq_write_index,
+			   buf->irq_words);
+	}
+
+	mutex_unlock(&dsp->pwr_lock);
+
+	return 0;
+}
+
+static int wm_adsp_debugfs_compr_latency_open(struct inode *inode,
+					      struct file *file)
+{
+	return single_open(file, wm_adsp_debugfs_compr_latency_show,
+			   inode->i_private);
+}
+
+static ssize_t wm_adsp_debugfs_compr_latency_write(struct file *file,
+						   const char __user *user_buf,
+						   size_t count, loff_t *ppos)
+{
+	struct wm_adsp *dsp = ((struct seq_file *)file->private_data)->private;
+
+	mutex_lock(&dsp->pwr_lock);
+	memset(&dsp->compr_latency, 0, sizeof(dsp->compr_latency));
+	mutex_unlock(&dsp->pwr_lock);
+
+	return count;
+}
+
+static const struct file_operations wm_adsp_debugfs_compr_latency_fops = {
+	.open = wm_adsp_debugfs_compr_latency_open,
+	.read = seq_read,
+	.write = wm_adsp_debugfs_compr_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static const struct {
 	const char *name;
 	const struct file_operations fops;
@@ -865,6 +1193,53 @@ static void wm_adsp2_init_debugfs(struct wm_adsp *dsp,
 				&dsp->fw_id_version))
 		goto err;
 
+	if (!debugfs_create_u32("recoveries", S_IRUGO, root,
+				&dsp->recovery_count))
+		goto err;
+
+	if (!debugfs_create_u32("recovery_failures", S_IRUGO, root,
+				&dsp->recovery_failures))
+		goto err;
+
+	if (!debugfs_create_u32("recovery_time_us", S_IRUGO, root,
+				&dsp->recovery_time_us))
+		goto err;
+
+	if (!debugfs_create_bool("resident", S_IRUGO, root, &dsp->resident))
+		goto err;
+
+	if (!debugfs_create_u32("boot_time_us", S_IRUGO, root,
+				&dsp->boot_time_us))
+		goto err;
+
+	if (!debugfs_create_u32("residency_hits", S_IRUGO, root,
+				&dsp->residency_hits))
+		goto err;
+
+	if (!debugfs_create_u32("residency_misses", S_IRUGO, root,
+				&dsp->residency_misses))
+		goto err;
+
+	if (!debugfs_create_u64("residency_saved_us", S_IRUGO, root,
+				&dsp->residency_saved_us))
+		goto err;
+
+	if (!debugfs_create_u64("delta_bytes_written", S_IRUGO, root,
+				&dsp->delta_bytes_written))
+		goto err;
+
+	if (!debugfs_create_u64("delta_bytes_skipped", S_IRUGO, root,
+				&dsp->delta_bytes_skipped))
+		goto err;
+
+	if (!debugfs_create_u32("prefetch_triggers", S_IRUGO, root,
+				&dsp->prefetch_triggers))
+		goto err;
+
+	if (!debugfs_create_u64("prefetch_bytes_served", S_IRUGO, root,
+				&dsp->prefetch_bytes_served))
+		goto err;
+
 	for (i = 0; i < ARRAY_SIZE(wm_adsp_debugfs_fops); ++i) {
 		if (!debugfs_create_file(wm_adsp_debugfs_fops[i].name,
 					 S_IRUGO, root, dsp,
@@ -872,6 +1247,17 @@ static void wm_adsp2_init_debugfs(struct wm_adsp *dsp,
 			goto err;
 	}
 
+	if (!debugfs_create_file("bus_stats", S_IRUGO | S_IWUSR, root, dsp,
+				 &wm_adsp_debugfs_bus_stats_fops))
+		goto err;
+
+	if (!debugfs_create_file("compr_latency", S_IRUGO | S_IWUSR, root,
+				 dsp, &wm_adsp_debugfs_compr_latency_fops))
+		goto err;
+
+	if (wm_adsp_debugfs_create_mem(dsp, root))
+		goto err;
+
 	dsp->debugfs_root = root;
 	return;
 
@@ -938,6 +1324,22 @@ static int wm_adsp_fw_put(struct snd_kcontrol *kcontrol,
 
 	mutex_lock(&dsp[e->shift_l].pwr_lock);
 
+	/*
+	 * An idle resident firmware must not block a firmware change, with
+	 * delta switching its memory is kept so only changes are loaded.
+	 */
+	if (dsp[e->shift_l].delta_switch && dsp[e->shift_l].resident &&
+	    wm_adsp_resident_intact(&dsp[e->shift_l],
+				    dsp[e->shift_l].fw_id,
+				    dsp[e->shift_l].fw_id_version)) {
+		dsp[e->shift_l].delta_fw_id = dsp[e->shift_l].fw_id;
+		dsp[e->shift_l].delta_fw_id_version =
+			dsp[e->shift_l].fw_id_version;
+		wm_adsp_reset_fw_state(&dsp[e->shift_l]);
+	} else {
+		wm_adsp_drop_resident(&dsp[e->shift_l]);
+	}
+
 	if (dsp[e->shift_l].booted || dsp[e->shift_l].compr[0])
 		ret = -EBUSY;
 	else
@@ -981,6 +1383,73 @@ static const struct snd_kcontrol_new wm_adsp_ao_fw_controls[] = {
 		     wm_adsp_fw_get, wm_adsp_fw_put),
 };
 
+static int wm_adsp_residency_get(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct soc_mixer_control *mc =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	struct wm_adsp *dsp = snd_soc_codec_get_drvdata(codec);
+
+	ucontrol->value.integer.value[0] = dsp[mc->shift].residency_ms;
+
+	return 0;
+}
+
+static int wm_adsp_residency_put(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_codec *codec = snd_soc_kcontrol_codec(kcontrol);
+	struct soc_mixer_control *mc =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	struct wm_adsp *dsp = snd_soc_codec_get_drvdata(codec);
+	unsigned int val = ucontrol->value.integer.value[0];
+
+	if (val > mc->max)
+		return -EINVAL;
+
+	if (val == dsp[mc->shift].residency_ms)
+		return 0;
+
+	mutex_lock(&dsp[mc->shift].pwr_lock);
+
+	dsp[mc->shift].residency_ms = val;
+
+	/* Disabling residency releases anything currently held */
+	if (!val)
+		wm_adsp_drop_resident(&dsp[mc->shift]);
+
+	mutex_unlock(&dsp[mc->shift].pwr_lock);
+
+	return 1;
+}
+
+#define WM_ADSP_MAX_RESIDENCY_MS	60000
+
+static const struct snd_kcontrol_new wm_adsp_residency_controls[] = {
+	SOC_SINGLE_EXT("DSP1 Residency Timeout", SND_SOC_NOPM, 0,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP2 Residency Timeout", SND_SOC_NOPM, 1,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP3 Residency Timeout", SND_SOC_NOPM, 2,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP4 Residency Timeout", SND_SOC_NOPM, 3,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP5 Residency Timeout", SND_SOC_NOPM, 4,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP6 Residency Timeout", SND_SOC_NOPM, 5,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+	SOC_SINGLE_EXT("DSP7 Residency Timeout", SND_SOC_NOPM, 6,
+		       WM_ADSP_MAX_RESIDENCY_MS, 0,
+		       wm_adsp_residency_get, wm_adsp_residency_put),
+};
+
 static struct wm_adsp_region const *wm_adsp_find_region(struct wm_adsp *dsp,
 							int type)
 {
@@ -1965,47 +2434,147 @@ static int wm_adsp_parse_coeff(struct wm_adsp *dsp,
 	return 0;
 }
 
-static int wm_adsp_write_blocks(struct wm_adsp *dsp, const u8 *data, size_t len,
-				unsigned int reg, struct list_head *list,
-				size_t burst_multiple)
-
+/* Bytes of raw data per register address */
+static unsigned int wm_adsp_addr_div(struct wm_adsp *dsp)
 {
-	size_t to_write = MAX_I2C_TX_SIZE - (MAX_I2C_TX_SIZE % burst_multiple);
-	size_t remain = len;
-	struct wm_adsp_buf *buf;
-	unsigned int addr_div;
-	int ret;
-
 	switch (dsp->type) {
 	case WMFW_ADSP1:
 	case WMFW_ADSP2:
-		addr_div = 2;
-		break;
+		return 2;
 	default:
-		addr_div = 1;
-		break;
+		return 1;
 	}
+}
 
-	while (remain > 0) {
-		if (remain < to_write)
-			to_write = remain;
+static inline void wm_adsp_bus_account(struct wm_adsp *dsp,
+				       enum wm_adsp_bus_stat stat,
+				       size_t bytes)
+{
+	dsp->bus_stats[stat].transactions++;
+	dsp->bus_stats[stat].bytes += bytes;
+}
 
-		buf = wm_adsp_buf_alloc(data, to_write, list);
-		if (!buf) {
-			adsp_err(dsp, "Out of memory\n");
-			return -ENOMEM;
-		}
+/*
+ * Hashes of the program memory chunks written by a firmware load, used to
+ * skip chunks that are already in memory when switching between related
+ * firmwares. Data memory is always written as the firmware modifies it.
+ */
+struct wm_adsp_delta {
+	const struct wm_adsp_chunk_hash *old;
+	int n_old;
+	struct wm_adsp_chunk_hash *new;
+	int n_new;
+	int size;
+	size_t skipped;
+	size_t written;
+};
 
-		ret = regmap_raw_write_async(dsp->regmap, reg,
-					     buf->buf, to_write);
-		if (ret != 0) {
-			adsp_err(dsp,
-				 "Failed to write %zd bytes at %d\n",
-				 to_write, reg);
+static u64 wm_adsp_chunk_hash(const u8 *data, size_t len)
+{
+	return ((u64)crc32_le(~0, data, len) << 32) | jhash(data, len, 0);
+}
 
-			return ret;
+static int wm_adsp_chunk_hash_cmp(const void *a, const void *b)
+{
+	const struct wm_adsp_chunk_hash *ha = a, *hb = b;
+
+	if (ha->reg < hb->reg)
+		return -1;
+
+	return ha->reg > hb->reg;
+}
+
+/* Record a chunk of the new image, returns 1 if it is already loaded */
+static int wm_adsp_delta_chunk(struct wm_adsp_delta *delta, unsigned int reg,
+			       const u8 *data, size_t len)
+{
+	struct wm_adsp_chunk_hash key, *chunk;
+	const struct wm_adsp_chunk_hash *old = NULL;
+
+	if (delta->n_new == delta->size) {
+		chunk = krealloc(delta->new,
+				 (delta->size + 64) * sizeof(*chunk),
+				 GFP_KERNEL);
+		if (!chunk)
+			return -ENOMEM;
+
+		delta->new = chunk;
+		delta->size += 64;
+	}
+
+	chunk = &delta->new[delta->n_new++];
+	chunk->reg = reg;
+	chunk->len = len;
+	chunk->hash = wm_adsp_chunk_hash(data, len);
+
+	if (delta->old) {
+		key.reg = reg;
+		old = bsearch(&key, delta->old, delta->n_old, sizeof(key),
+			      wm_adsp_chunk_hash_cmp);
+	}
+
+	if (old && old->len == chunk->len && old->hash == chunk->hash) {
+		delta->skipped += len;
+		return 1;
+	}
+
+	delta->written += len;
+
+	return 0;
+}
+
+/* Forget what is in program memory, called with pwr_lock held */
+static void wm_adsp_delta_invalidate(struct wm_adsp *dsp)
+{
+	kfree(dsp->pm_hashes);
+	dsp->pm_hashes = NULL;
+	dsp->n_pm_hashes = 0;
+}
+
+static int wm_adsp_write_blocks(struct wm_adsp *dsp, const u8 *data, size_t len,
+				unsigned int reg, struct list_head *list,
+				size_t burst_multiple,
+				enum wm_adsp_bus_stat stat,
+				struct wm_adsp_delta *delta)
+
+{
+	size_t to_write = MAX_I2C_TX_SIZE - (MAX_I2C_TX_SIZE % burst_multiple);
+	size_t remain = len;
+	struct wm_adsp_buf *buf;
+	unsigned int addr_div = wm_adsp_addr_div(dsp);
+	int ret;
+
+	while (remain > 0) {
+		if (remain < to_write)
+			to_write = remain;
+
+		if (delta) {
+			ret = wm_adsp_delta_chunk(delta, reg, data, to_write);
+			if (ret < 0)
+				return ret;
+			if (ret)
+				goto next;
+		}
+
+		buf = wm_adsp_buf_alloc(data, to_write, list);
+		if (!buf) {
+			adsp_err(dsp, "Out of memory\n");
+			return -ENOMEM;
+		}
+
+		ret = regmap_raw_write_async(dsp->regmap, reg,
+					     buf->buf, to_write);
+		if (ret != 0) {
+			adsp_err(dsp,
+				 "Failed to write %zd bytes at %d\n",
+				 to_write, reg);
+
+			return ret;
 		}
 
+		wm_adsp_bus_account(dsp, stat, to_write);
+
+next:
 		data += to_write;
 		reg += to_write / addr_div;
 		remain -= to_write;
@@ -2014,6 +2583,54 @@ static int wm_adsp_write_blocks(struct wm_adsp *dsp, const u8 *data, size_t len,
 	return 0;
 }
 
+static void wm_adsp_fw_cache_free(struct wm_adsp_fw_cache *cache)
+{
+	release_firmware(cache->fw);
+	kfree(cache->name);
+	cache->fw = NULL;
+	cache->name = NULL;
+}
+
+/* Recovery reuses the host copy so it doesn't depend on the filesystem */
+static int wm_adsp_request_firmware(struct wm_adsp *dsp,
+				    struct wm_adsp_fw_cache *cache,
+				    const struct firmware **firmware,
+				    const char *file)
+{
+	if (dsp->recovering && cache->fw && !strcmp(cache->name, file)) {
+		*firmware = cache->fw;
+		return 0;
+	}
+
+	return request_firmware(firmware, file, dsp->dev);
+}
+
+/* Keep a successfully loaded file in case the DSP needs recovering */
+static void wm_adsp_release_firmware(struct wm_adsp_fw_cache *cache,
+				     const struct firmware *firmware,
+				     const char *file, bool loaded)
+{
+	char *name;
+
+	if (firmware == cache->fw)
+		return;
+
+	if (!loaded) {
+		release_firmware(firmware);
+		return;
+	}
+
+	name = kstrdup(file, GFP_KERNEL);
+	if (!name) {
+		release_firmware(firmware);
+		return;
+	}
+
+	wm_adsp_fw_cache_free(cache);
+	cache->name = name;
+	cache->fw = firmware;
+}
+
 static int wm_adsp_load(struct wm_adsp *dsp)
 {
 	LIST_HEAD(buf_list);
@@ -2027,6 +2644,11 @@ static int wm_adsp_load(struct wm_adsp *dsp)
 	const struct wmfw_region *region;
 	const struct wm_adsp_region *mem;
 	const char *region_name;
+	struct wm_adsp_delta delta = {
+		.old = dsp->pm_hashes,
+		.n_old = dsp->n_pm_hashes,
+	};
+	struct wm_adsp_delta *pm_delta = NULL;
 	char *file, *text = NULL;
 	unsigned int reg;
 	int regions = 0;
@@ -2044,13 +2666,15 @@ static int wm_adsp_load(struct wm_adsp *dsp)
 			 dsp->num, dsp->firmwares[dsp->fw].file);
 	file[PAGE_SIZE - 1] = '\0';
 
-	ret = request_firmware(&firmware, file, dsp->dev);
+	ret = wm_adsp_request_firmware(dsp, &dsp->wmfw_cache, &firmware, file);
 	if (ret != 0) {
 		adsp_err(dsp, "Failed to request '%s'\n", file);
 		goto out;
 	}
 	ret = -EINVAL;
 
+	dsp->bus_stats[WM_ADSP_BUS_WMFW].ops++;
+
 	pos = sizeof(*header) + sizeof(*adsp1_sizes) + sizeof(*footer);
 	if (pos >= firmware->size) {
 		adsp_err(dsp, "%s: file too short, %zu bytes\n",
@@ -2137,6 +2761,11 @@ static int wm_adsp_load(struct wm_adsp *dsp)
 			 le32_to_cpu(adsp2_sizes->ym),
 			 le32_to_cpu(adsp2_sizes->pm),
 			 le32_to_cpu(adsp2_sizes->zm));
+
+		dsp->xm_words = le32_to_cpu(adsp2_sizes->xm);
+		dsp->ym_words = le32_to_cpu(adsp2_sizes->ym);
+		dsp->pm_words = le32_to_cpu(adsp2_sizes->pm);
+		dsp->zm_words = le32_to_cpu(adsp2_sizes->zm);
 		break;
 
 	default:
@@ -2225,11 +2854,24 @@ static int wm_adsp_load(struct wm_adsp *dsp)
 			text = NULL;
 		}
 
+		switch (type) {
+		case WMFW_ADSP1_PM:
+		case WMFW_HALO_PM_PACKED:
+			if (dsp->delta_switch)
+				pm_delta = &delta;
+			break;
+		default:
+			pm_delta = NULL;
+			break;
+		}
+
 		if (reg) {
 			ret = wm_adsp_write_blocks(dsp, region->data,
 						   le32_to_cpu(region->len),
 						   reg, &buf_list,
-						   burst_multiple);
+						   burst_multiple,
+						   WM_ADSP_BUS_WMFW,
+						   pm_delta);
 
 			if (ret != 0) {
 				adsp_err(dsp,
@@ -2256,10 +2898,29 @@ static int wm_adsp_load(struct wm_adsp *dsp)
 
 	wm_adsp_debugfs_save_wmfwname(dsp, file);
 
+	if (dsp->delta_switch) {
+		adsp_info(dsp, "%s: PM wrote %zu bytes, skipped %zu bytes\n",
+			  file, delta.written, delta.skipped);
+
+		dsp->delta_bytes_written += delta.written;
+		dsp->delta_bytes_skipped += delta.skipped;
+
+		sort(delta.new, delta.n_new, sizeof(*delta.new),
+		     wm_adsp_chunk_hash_cmp, NULL);
+
+		kfree(dsp->pm_hashes);
+		dsp->pm_hashes = delta.new;
+		dsp->n_pm_hashes = delta.n_new;
+		delta.new = NULL;
+	}
+
 out_fw:
 	regmap_async_complete(regmap);
 	wm_adsp_buf_free(&buf_list);
-	release_firmware(firmware);
+	if (ret != 0)
+		wm_adsp_delta_invalidate(dsp);
+	kfree(delta.new);
+	wm_adsp_release_firmware(&dsp->wmfw_cache, firmware, file, !ret);
 	kfree(text);
 out:
 	kfree(file);
@@ -2780,7 +3441,7 @@ static int wm_adsp_load_coeff(struct wm_adsp *dsp)
 			 dsp->num, dsp->firmwares[dsp->fw].file);
 	file[PAGE_SIZE - 1] = '\0';
 
-	ret = request_firmware(&firmware, file, dsp->dev);
+	ret = wm_adsp_request_firmware(dsp, &dsp->bin_cache, &firmware, file);
 	if (ret != 0) {
 		adsp_warn(dsp, "Failed to request '%s'\n", file);
 		ret = 0;
@@ -2788,6 +3449,8 @@ static int wm_adsp_load_coeff(struct wm_adsp *dsp)
 	}
 	ret = -EINVAL;
 
+	dsp->bus_stats[WM_ADSP_BUS_COEFF].ops++;
+
 	if (sizeof(*hdr) >= firmware->size) {
 		adsp_err(dsp, "%s: file too short, %zu bytes\n",
 			file, firmware->size);
@@ -2915,7 +3578,9 @@ static int wm_adsp_load_coeff(struct wm_adsp *dsp)
 			ret = wm_adsp_write_blocks(dsp, blk->data,
 						   le32_to_cpu(blk->len),
 						   reg, &buf_list,
-						   burst_multiple);
+						   burst_multiple,
+						   WM_ADSP_BUS_COEFF,
+						   NULL);
 			if (ret != 0) {
 				adsp_err(dsp,
 					"%s.%d: Failed to write to %x in %s: %d\n",
@@ -2939,7 +3604,7 @@ static int wm_adsp_load_coeff(struct wm_adsp *dsp)
 
 out_fw:
 	regmap_async_complete(regmap);
-	release_firmware(firmware);
+	wm_adsp_release_firmware(&dsp->bin_cache, firmware, file, !ret);
 	wm_adsp_buf_free(&buf_list);
 out:
 	kfree(file);
@@ -3121,19 +3786,202 @@ static int wm_adsp2_ena(struct wm_adsp *dsp)
 	return 0;
 }
 
-static void wm_adsp2_boot_work(struct work_struct *work)
+/* Forget everything learnt from the firmware, called with pwr_lock held */
+static void wm_adsp_reset_fw_state(struct wm_adsp *dsp)
 {
-	struct wm_adsp *dsp = container_of(work,
-					   struct wm_adsp,
-					   boot_work);
-	int ret;
+	struct wm_coeff_ctl *ctl;
+
+	wm_adsp_debugfs_clear(dsp);
+
+	dsp->fw_id = 0;
+	dsp->fw_id_version = 0;
+
+	dsp->booted = false;
+
+	list_for_each_entry(ctl, &dsp->ctl_list, list)
+		ctl->enabled = 0;
+
+	wm_adsp_free_alg_regions(dsp);
+}
+
+/* Drop the firmware and its memory, called with pwr_lock held */
+static void wm_adsp_release_fw(struct wm_adsp *dsp)
+{
+	wm_adsp_reset_fw_state(dsp);
+	wm_adsp_delta_invalidate(dsp);
+
+	switch (dsp->type) {
+	case WMFW_ADSP2:
+		regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
+				   ADSP2_MEM_ENA, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Called with pwr_lock held */
+static void wm_adsp_drop_resident(struct wm_adsp *dsp)
+{
+	if (!dsp->resident)
+		return;
+
+	dsp->resident = false;
+	wm_adsp_release_fw(dsp);
+
+	adsp_dbg(dsp, "Released resident firmware\n");
+}
+
+static void wm_adsp_idle_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work, struct wm_adsp,
+					   idle_work.work);
 
 	mutex_lock(&dsp->pwr_lock);
+	wm_adsp_drop_resident(dsp);
+	mutex_unlock(&dsp->pwr_lock);
+}
+
+/*
+ * Park a booted firmware with the core stopped but its memory retained,
+ * it is released if no one powers the DSP back up within residency_ms.
+ * Returns false if residency is disabled. Called with pwr_lock held.
+ */
+static bool wm_adsp_park_resident(struct wm_adsp *dsp)
+{
+	if (!dsp->residency_ms || !dsp->booted)
+		return false;
+
+	dsp->resident = true;
+	schedule_delayed_work(&dsp->idle_work,
+			      msecs_to_jiffies(dsp->residency_ms));
+
+	adsp_dbg(dsp, "Firmware resident for %ums\n", dsp->residency_ms);
+
+	return true;
+}
+
+/*
+ * Check the DSP memory has been retained since the firmware was parked and
+ * its ID block still matches the given firmware, called with pwr_lock held
+ */
+static bool wm_adsp_resident_intact(struct wm_adsp *dsp, unsigned int fw_id,
+				    unsigned int fw_id_version)
+{
+	const struct wm_adsp_region *mem;
+	struct wmfw_halo_id_hdr halo_id;
+	struct wmfw_adsp2_id_hdr adsp2_id;
+	unsigned int id, ver;
+	int ret;
+
+	if (atomic_xchg(&dsp->power_lost, 0))
+		return false;
+
+	mem = wm_adsp_find_region(dsp, WMFW_ADSP2_XM);
+	if (!mem)
+		return false;
+
+	switch (dsp->type) {
+	case WMFW_ADSP2:
+		ret = wm_adsp2_ena(dsp);
+		if (ret != 0)
+			return false;
+		break;
+	default:
+		break;
+	}
+
+	if (dsp->type == WMFW_HALO && dsp->fw_ver >= 3) {
+		ret = regmap_raw_read(dsp->regmap, mem->base, &halo_id,
+				      sizeof(halo_id));
+		id = be32_to_cpu(halo_id.fw.id);
+		ver = be32_to_cpu(halo_id.fw.ver);
+	} else {
+		ret = regmap_raw_read(dsp->regmap, mem->base, &adsp2_id,
+				      sizeof(adsp2_id));
+		id = be32_to_cpu(adsp2_id.fw.id);
+		ver = be32_to_cpu(adsp2_id.fw.ver);
+	}
+
+	if (dsp->type == WMFW_ADSP2 && dsp->rev == 0)
+		regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
+				   ADSP2_SYS_ENA, 0);
+
+	if (ret != 0) {
+		adsp_warn(dsp, "Failed to read resident firmware ID: %d\n",
+			  ret);
+		return false;
+	}
+
+	return id == fw_id && ver == fw_id_version;
+}
+
+/*
+ * Called with pwr_lock held from the boot work, returns true if the
+ * resident firmware could be reused and no boot is required.
+ */
+static bool wm_adsp_reuse_resident(struct wm_adsp *dsp)
+{
+	if (!dsp->resident)
+		return false;
+
+	dsp->resident = false;
+
+	/* Switched firmware, memory is kept for a delta load */
+	if (!dsp->booted) {
+		if (!wm_adsp_resident_intact(dsp, dsp->delta_fw_id,
+					     dsp->delta_fw_id_version)) {
+			adsp_dbg(dsp, "DSP memory lost, full load required\n");
+			wm_adsp_release_fw(dsp);
+		}
+		return false;
+	}
+
+	if (!wm_adsp_resident_intact(dsp, dsp->fw_id, dsp->fw_id_version)) {
+		adsp_warn(dsp, "Resident firmware corrupt, rebooting\n");
+		wm_adsp_release_fw(dsp);
+		return false;
+	}
+
+	dsp->residency_hits++;
+	dsp->residency_saved_us += dsp->boot_time_us;
+
+	adsp_dbg(dsp, "Reusing resident firmware, saved %uus\n",
+		 dsp->boot_time_us);
+
+	return true;
+}
+
+/* Called with pwr_lock held */
+static void wm_adsp_boot_resident(struct wm_adsp *dsp,
+				  int (*boot)(struct wm_adsp *dsp))
+{
+	ktime_t start;
+
+	if (wm_adsp_reuse_resident(dsp))
+		return;
+
+	dsp->residency_misses++;
+
+	/* Anything lost so far is rewritten by this boot */
+	atomic_set(&dsp->power_lost, 0);
+
+	start = ktime_get();
+	if (boot(dsp) == 0)
+		dsp->boot_time_us = ktime_to_us(ktime_sub(ktime_get(), start));
+	else
+		wm_adsp_delta_invalidate(dsp);
+}
+
+/* Called with pwr_lock held */
+static int wm_adsp2_boot(struct wm_adsp *dsp)
+{
+	int ret;
 
 	ret = regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
 				 ADSP2_MEM_ENA, ADSP2_MEM_ENA);
 	if (ret != 0)
-		goto err_mutex;
+		return ret;
 
 	ret = wm_adsp2_ena(dsp);
 	if (ret != 0)
@@ -3170,9 +4018,7 @@ static void wm_adsp2_boot_work(struct work_struct *work)
 
 	dsp->booted = true;
 
-	mutex_unlock(&dsp->pwr_lock);
-
-	return;
+	return 0;
 
 err_ena:
 	regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
@@ -3180,152 +4026,339 @@ err_ena:
 err_mem:
 	regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
 			   ADSP2_MEM_ENA, 0);
-err_mutex:
+
+	return ret;
+}
+
+static void wm_adsp2_boot_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work,
+					   struct wm_adsp,
+					   boot_work);
+
+	mutex_lock(&dsp->pwr_lock);
+	wm_adsp_boot_resident(dsp, wm_adsp2_boot);
 	mutex_unlock(&dsp->pwr_lock);
 }
 
-#ifndef REMOVE_SYNC_SET_RATE
+/* Rate cache entries that have never been set leave the hardware alone */
+#define WM_HALO_RATE_UNSET	0xff
+
+/*
+ * Apply a block of channel rates, only registers whose value differs are
+ * written and all of them go out before a single completion and settle
+ * wait. Called with rate_lock held.
+ */
 static int wm_halo_set_rate_block(struct wm_adsp *dsp,
 				  unsigned int rate_base,
 				  unsigned int n_rates,
-				  const u8 *rate_cache)
+				  const u8 *rate_cache,
+				  bool *changed)
 {
 	unsigned int addr = dsp->base + rate_base, val;
+	bool change;
 	int ret, i;
 
-	mutex_lock(dsp->rate_lock);
-
 	for (i = 0; i < n_rates; ++i) {
+		if (rate_cache[i] == WM_HALO_RATE_UNSET)
+			continue;
+
 		val = rate_cache[i] << HALO_DSP_RATE_SHIFT;
 
-		ret = regmap_update_bits(dsp->regmap,
-					 addr + (i * 8),
-					 HALO_DSP_RATE_MASK,
-					 val);
+		ret = regmap_update_bits_check_async(dsp->regmap,
+						     addr + (i * 8),
+						     HALO_DSP_RATE_MASK,
+						     val, &change);
 		if (ret) {
 			adsp_err(dsp, "Failed to set rate: %d\n", ret);
-			mutex_unlock(dsp->rate_lock);
 			return ret;
 		}
 
-		adsp_dbg(dsp, "Set rate %d to 0x%x\n", i, val);
+		if (change) {
+			adsp_dbg(dsp, "Set rate %d to 0x%x\n", i, val);
+			*changed = true;
+		}
 	}
 
-	udelay(300);
-
-	mutex_unlock(dsp->rate_lock);
-
 	return 0;
 }
-#endif
 
-static int wm_halo_clear_stream_arb(struct wm_adsp *dsp)
+static int wm_halo_sync_rates(struct wm_adsp *dsp)
 {
-	struct regmap *regmap = dsp->regmap;
-	unsigned int dspbase = dsp->base, reg, begin, end;
-	u32 values[3] = {0, 0, 0};
+	bool changed = false;
 	int ret;
 
-	/* disable stream arbiter masters */
-	for (reg = dspbase + HALO_STREAM_ARB_MSTR0_CONFIG_0;
-	     reg <= dspbase + HALO_STREAM_ARB_MSTR5_CONFIG_0;
-	     reg += 0x10) {
-		ret = regmap_update_bits(regmap, reg,
-					 HALO_STREAM_ARB_MSTR_EN_MASK, 0);
-		if (ret)
-			goto error;
-	}
+	mutex_lock(dsp->rate_lock);
 
-	/* clear stream arbiter masters */
-	for (reg = dspbase + HALO_STREAM_ARB_MSTR0_CONFIG_0;
-	     reg <= dspbase + HALO_STREAM_ARB_MSTR5_CONFIG_0;
-	     reg += 0x10) {
-		ret = regmap_bulk_write(regmap, reg, values, 3);
-		if (ret)
-			goto error;
+	ret = wm_halo_set_rate_block(dsp, HALO_SAMPLE_RATE_RX1,
+				     dsp->n_rx_channels,
+				     dsp->rx_rate_cache, &changed);
+	if (ret) {
+		adsp_err(dsp, "Failed to set RX rates.\n");
+		goto out;
 	}
 
-	/* clear stream arbiter channel configs */
-	begin = dspbase + HALO_STREAM_ARB_TX1_CONFIG_0;
-	end = begin + dsp->n_tx_channels * 0x8;
-	for (reg = begin; reg < end; reg += 0x8) {
-		ret = regmap_write(regmap, reg,
-				   HALO_STREAM_ARB_MSTR_SEL_DEFAULT);
-		if (ret)
-			goto error;
-	}
-	begin = dspbase + HALO_STREAM_ARB_RX1_CONFIG_0;
-	end = begin + dsp->n_rx_channels * 0x8;
-	for (reg = begin; reg < end; reg += 0x8) {
-		ret = regmap_write(regmap, reg,
-				   HALO_STREAM_ARB_MSTR_SEL_DEFAULT);
-		if (ret)
-			goto error;
-	}
+	ret = wm_halo_set_rate_block(dsp, HALO_SAMPLE_RATE_TX1,
+				     dsp->n_tx_channels,
+				     dsp->tx_rate_cache, &changed);
+	if (ret)
+		adsp_err(dsp, "Failed to set TX rates.\n");
 
-	/* clear stream arbiter interrupt registers */
-	values[0] = HALO_STREAM_ARB_MSTR_SEL_DEFAULT;
-	for (reg = dspbase + HALO_STREAM_ARB_IRQ0_CONFIG_0;
-	     reg <= dspbase + HALO_STREAM_ARB_IRQ7_CONFIG_1;
-	     reg += 0x10) {
-		ret = regmap_bulk_write(regmap, reg, values, 2);
-		if (ret)
-			goto error;
+out:
+	if (regmap_async_complete(dsp->regmap) && !ret) {
+		adsp_err(dsp, "Failed to complete rate update\n");
+		ret = -EIO;
 	}
-	return 0;
 
-error:
-	adsp_err(dsp,
-		 "Error while clearing stream arbiter config (reg 0x%x): %d\n",
-		 reg, ret);
+	/* Let the new rates settle before anything uses them */
+	if (changed)
+		usleep_range(300, 500);
+
+	mutex_unlock(dsp->rate_lock);
+
 	return ret;
 }
 
-static int wm_halo_configure_mpu(struct wm_adsp *dsp)
-{
+/*
+ * Set every RX and TX channel of a HALO core to one sample rate, for parts
+ * whose DSP channels all run from a single global rate. Applied straight
+ * away if the core is running, otherwise when it is next started.
+ */
+int wm_halo_set_rates(struct wm_adsp *dsp, unsigned int rate)
+{
+	int ret = 0;
+
+	if (rate > HALO_DSP_RATE_MASK)
+		return -EINVAL;
+
+	if (!dsp->rx_rate_cache || !dsp->tx_rate_cache)
+		return -ENODEV;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	mutex_lock(dsp->rate_lock);
+	memset(dsp->rx_rate_cache, rate, dsp->n_rx_channels);
+	memset(dsp->tx_rate_cache, rate, dsp->n_tx_channels);
+	mutex_unlock(dsp->rate_lock);
+
+	if (dsp->running)
+		ret = wm_halo_sync_rates(dsp);
+
+	mutex_unlock(&dsp->pwr_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(wm_halo_set_rates);
+
+/*
+ * A fixed register sequence with runs of consecutive registers coalesced
+ * so each run goes out as a single raw write.
+ */
+struct wm_adsp_reg_run {
+	unsigned int reg;
+	unsigned int len;
+};
+
+struct wm_adsp_reg_seq {
+	int n_runs;
+	struct wm_adsp_reg_run *runs;
+	__be32 *vals;
+};
+
+static void wm_adsp_reg_seq_free(struct wm_adsp_reg_seq *rs)
+{
+	if (!rs)
+		return;
+
+	kfree(rs->runs);
+	kfree(rs->vals);
+	kfree(rs);
+}
+
+static struct wm_adsp_reg_seq *
+wm_adsp_reg_seq_build(struct wm_adsp *dsp, const struct reg_sequence *seq,
+		      int n)
+{
+	unsigned int stride = regmap_get_reg_stride(dsp->regmap);
+	struct wm_adsp_reg_run *run = NULL;
+	struct wm_adsp_reg_seq *rs;
+	int i;
+
+	rs = kzalloc(sizeof(*rs), GFP_KERNEL);
+	if (!rs)
+		return NULL;
+
+	rs->runs = kcalloc(n, sizeof(*rs->runs), GFP_KERNEL);
+	rs->vals = kcalloc(n, sizeof(*rs->vals), GFP_KERNEL | GFP_DMA);
+	if (!rs->runs || !rs->vals) {
+		wm_adsp_reg_seq_free(rs);
+		return NULL;
+	}
+
+	for (i = 0; i < n; i++) {
+		rs->vals[i] = cpu_to_be32(seq[i].def);
+
+		if (run && seq[i].reg == run->reg + (run->len * stride)) {
+			run->len++;
+			continue;
+		}
+
+		run = &rs->runs[rs->n_runs++];
+		run->reg = seq[i].reg;
+		run->len = 1;
+	}
+
+	return rs;
+}
+
+static int wm_adsp_reg_seq_write(struct wm_adsp *dsp,
+				 const struct wm_adsp_reg_seq *rs)
+{
+	const __be32 *vals = rs->vals;
+	size_t len;
+	int i, ret;
+
+	dsp->bus_stats[WM_ADSP_BUS_SETUP].ops++;
+
+	for (i = 0; i < rs->n_runs; i++) {
+		len = rs->runs[i].len * sizeof(*vals);
+
+		ret = regmap_raw_write_async(dsp->regmap, rs->runs[i].reg,
+					     vals, len);
+		if (ret) {
+			adsp_err(dsp, "Failed to write 0x%x: %d\n",
+				 rs->runs[i].reg, ret);
+			regmap_async_complete(dsp->regmap);
+			return ret;
+		}
+
+		wm_adsp_bus_account(dsp, WM_ADSP_BUS_SETUP, len);
+
+		vals += rs->runs[i].len;
+	}
+
+	ret = regmap_async_complete(dsp->regmap);
+	if (ret)
+		adsp_err(dsp, "Failed to complete register sequence: %d\n",
+			 ret);
+
+	return ret;
+}
+
+static struct wm_adsp_reg_seq *wm_halo_build_stream_arb(struct wm_adsp *dsp)
+{
+	unsigned int dspbase = dsp->base, reg, i;
+	struct wm_adsp_reg_seq *rs;
+	struct reg_sequence *seq;
+	int n = 0;
+
+	seq = kcalloc((6 * 3) + dsp->n_tx_channels + dsp->n_rx_channels +
+		      (8 * 2), sizeof(*seq), GFP_KERNEL);
+	if (!seq)
+		return NULL;
+
+	/*
+	 * Clear the stream arbiter masters, CONFIG_0 holds the enable and is
+	 * written first so each master is disabled before it is cleared
+	 */
+	for (reg = dspbase + HALO_STREAM_ARB_MSTR0_CONFIG_0;
+	     reg <= dspbase + HALO_STREAM_ARB_MSTR5_CONFIG_0;
+	     reg += 0x10) {
+		seq[n++].reg = reg;
+		seq[n++].reg = reg + 0x4;
+		seq[n++].reg = reg + 0x8;
+	}
+
+	/* clear stream arbiter channel configs */
+	for (i = 0; i < dsp->n_tx_channels; i++) {
+		seq[n].reg = dspbase + HALO_STREAM_ARB_TX1_CONFIG_0 + (i * 0x8);
+		seq[n++].def = HALO_STREAM_ARB_MSTR_SEL_DEFAULT;
+	}
+	for (i = 0; i < dsp->n_rx_channels; i++) {
+		seq[n].reg = dspbase + HALO_STREAM_ARB_RX1_CONFIG_0 + (i * 0x8);
+		seq[n++].def = HALO_STREAM_ARB_MSTR_SEL_DEFAULT;
+	}
+
+	/* clear stream arbiter interrupt registers */
+	for (reg = dspbase + HALO_STREAM_ARB_IRQ0_CONFIG_0;
+	     reg <= dspbase + HALO_STREAM_ARB_IRQ7_CONFIG_0;
+	     reg += 0x10) {
+		seq[n].reg = reg;
+		seq[n++].def = HALO_STREAM_ARB_MSTR_SEL_DEFAULT;
+		seq[n++].reg = reg + 0x4;
+	}
+
+	rs = wm_adsp_reg_seq_build(dsp, seq, n);
+
+	kfree(seq);
+
+	return rs;
+}
+
+static int wm_halo_clear_stream_arb(struct wm_adsp *dsp)
+{
+	int ret;
+
+	if (!dsp->arb_seq) {
+		dsp->arb_seq = wm_halo_build_stream_arb(dsp);
+		if (!dsp->arb_seq)
+			return -ENOMEM;
+	}
+
+	ret = wm_adsp_reg_seq_write(dsp, dsp->arb_seq);
+	if (ret)
+		adsp_err(dsp,
+			 "Error while clearing stream arbiter config: %d\n",
+			 ret);
+
+	return ret;
+}
+
+/* The memory sizes are fixed so the MPU sequence is only built once */
+static struct wm_adsp_reg_seq *wm_halo_build_mpu(struct wm_adsp *dsp)
+{
 	struct regmap *regmap = dsp->regmap;
-	int i = 0, len = 0, ret;
 	unsigned int sysinfo_base = dsp->base_sysinfo, dsp_base = dsp->base;
 	unsigned int xm_sz, xm_bank_sz, ym_sz, ym_bank_sz;
 	unsigned int xm_acc_cfg, ym_acc_cfg;
-	unsigned int lock_cfg;
-
-	ret = regmap_read(regmap, sysinfo_base + HALO_SYS_INFO_XM_BANK_SIZE,
-			  &xm_bank_sz);
+	unsigned int lock_cfg, bank_sz[2];
+	struct reg_sequence seq[ARRAY_SIZE(halo_mpu_access) + 5];
+	int i, n = 0, ret;
+
+	/* XM and YM bank sizes are adjacent */
+	ret = regmap_bulk_read(regmap,
+			       sysinfo_base + HALO_SYS_INFO_XM_BANK_SIZE,
+			       bank_sz, ARRAY_SIZE(bank_sz));
 	if (ret) {
-		adsp_err(dsp, "Failed to read XM bank size.\n");
-		goto err;
+		adsp_err(dsp, "Failed to read bank sizes: %d\n", ret);
+		return NULL;
 	}
 
+	xm_bank_sz = bank_sz[0];
+	ym_bank_sz = bank_sz[1];
+
 	if (!xm_bank_sz) {
 		adsp_err(dsp, "Failed to configure MPU (XM_BANK_SIZE = 0)\n");
-		goto err;
-	}
-
-	ret = regmap_read(regmap, sysinfo_base + HALO_SYS_INFO_YM_BANK_SIZE,
-			  &ym_bank_sz);
-	if (ret) {
-		adsp_err(dsp, "Failed to read YM bank size.\n");
-		goto err;
+		return NULL;
 	}
 
 	if (!ym_bank_sz) {
 		adsp_err(dsp, "Failed to configure MPU (YM_BANK_SIZE = 0)\n");
-		goto err;
+		return NULL;
 	}
 
 	ret = regmap_read(regmap, sysinfo_base + HALO_SYS_INFO_XM_SRAM_SIZE,
 			  &xm_sz);
 	if (ret) {
 		adsp_err(dsp, "Failed to read XM size.\n");
-		goto err;
+		return NULL;
 	}
 
 	ret = regmap_read(regmap, sysinfo_base + HALO_SYS_INFO_YM_SRAM_SIZE,
 			  &ym_sz);
 	if (ret) {
 		adsp_err(dsp, "Failed to read YM size.\n");
-		goto err;
+		return NULL;
 	}
 
 	adsp_dbg(dsp,
@@ -3336,93 +4369,97 @@ static int wm_halo_configure_mpu(struct wm_adsp *dsp)
 	xm_acc_cfg = (1 << (xm_sz / xm_bank_sz)) - 1;
 	ym_acc_cfg = (1 << (ym_sz / ym_bank_sz)) - 1;
 
-	/* unlock MPU */
-	ret = regmap_write(regmap, dsp_base + HALO_MPU_LOCK_CONFIG,
-			   HALO_MPU_UNLOCK_CODE_0);
-	if (ret) {
-		adsp_err(dsp, "Error while unlocking MPU: %d\n", ret);
-		goto err;
-	}
-
-	ret = regmap_write(regmap, dsp_base + HALO_MPU_LOCK_CONFIG,
-			   HALO_MPU_UNLOCK_CODE_1);
-	if (ret) {
-		adsp_err(dsp, "Error while unlocking MPU: %d\n", ret);
-		goto err;
-	}
-
 	adsp_dbg(dsp, "Unlocking XM (cfg: %x) and YM (cfg: %x)",
 		 xm_acc_cfg, ym_acc_cfg);
 
-	/* unlock XMEM and YMEM */
-	ret = regmap_write(regmap, dsp_base + HALO_MPU_XMEM_ACCESS_0,
-			   xm_acc_cfg);
-	if (ret)
-		goto err;
+	/* unlock MPU */
+	seq[n].reg = dsp_base + HALO_MPU_LOCK_CONFIG;
+	seq[n++].def = HALO_MPU_UNLOCK_CODE_0;
+	seq[n].reg = dsp_base + HALO_MPU_LOCK_CONFIG;
+	seq[n++].def = HALO_MPU_UNLOCK_CODE_1;
 
-	ret = regmap_write(regmap, dsp_base + HALO_MPU_YMEM_ACCESS_0,
-			   ym_acc_cfg);
-	if (ret)
-		goto err;
+	/* unlock XMEM and YMEM */
+	seq[n].reg = dsp_base + HALO_MPU_XMEM_ACCESS_0;
+	seq[n++].def = xm_acc_cfg;
+	seq[n].reg = dsp_base + HALO_MPU_YMEM_ACCESS_0;
+	seq[n++].def = ym_acc_cfg;
 
-	len = sizeof(halo_mpu_access) / sizeof(halo_mpu_access[0]);
 	/* configure all other banks */
 	lock_cfg = (dsp->unlock_all) ? 0xFFFFFFFF : 0;
-	for (i = 0; i < len; i++) { /* TODO: think if can be done without LUT */
-		ret = regmap_write(regmap, dsp_base + halo_mpu_access[i],
-					lock_cfg);
-		if (ret)
-			goto err;
+	for (i = 0; i < ARRAY_SIZE(halo_mpu_access); i++) {
+		seq[n].reg = dsp_base + halo_mpu_access[i];
+		seq[n++].def = lock_cfg;
 	}
 
 	/* lock MPU */
-	ret = regmap_write(regmap, dsp_base + HALO_MPU_LOCK_CONFIG, 0);
+	seq[n].reg = dsp_base + HALO_MPU_LOCK_CONFIG;
+	seq[n++].def = 0;
+
+	return wm_adsp_reg_seq_build(dsp, seq, n);
+}
+
+static int wm_halo_configure_mpu(struct wm_adsp *dsp)
+{
+	int ret;
+
+	if (!dsp->mpu_seq) {
+		dsp->mpu_seq = wm_halo_build_mpu(dsp);
+		if (!dsp->mpu_seq)
+			return -EINVAL;
+	}
+
+	ret = wm_adsp_reg_seq_write(dsp, dsp->mpu_seq);
 	if (ret)
-		adsp_err(dsp, "Error while locking MPU: %d\n", ret);
+		adsp_err(dsp, "Error while configuring MPU: %d\n", ret);
 
-err:
 	return ret;
 }
 
-static void wm_halo_boot_work(struct work_struct *work)
+/* Called with pwr_lock held */
+static int wm_halo_boot(struct wm_adsp *dsp)
 {
-	struct wm_adsp *dsp = container_of(work,
-					   struct wm_adsp,
-					   boot_work);
 	int ret;
 
-	mutex_lock(&dsp->pwr_lock);
-
 	ret = wm_adsp_load(dsp);
 	if (ret != 0)
-		goto err;
+		return ret;
 
 	switch (dsp->fw_ver) {
 	case 1:
 	case 2:
 		ret = wm_adsp2_setup_algs(dsp);
 		if (ret != 0)
-			goto err;
+			return ret;
 		break;
 	default:
 		ret = wm_halo_setup_algs(dsp);
 		if (ret != 0)
-			goto err;
+			return ret;
 		break;
 	}
 
 	ret = wm_adsp_load_coeff(dsp);
 	if (ret != 0)
-		goto err;
+		return ret;
 
 	/* Initialize caches for enabled and unset controls */
 	ret = wm_coeff_init_control_caches(dsp);
 	if (ret != 0)
-		goto err;
+		return ret;
 
 	dsp->booted = true;
 
-err:
+	return 0;
+}
+
+static void wm_halo_boot_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work,
+					   struct wm_adsp,
+					   boot_work);
+
+	mutex_lock(&dsp->pwr_lock);
+	wm_adsp_boot_resident(dsp, wm_halo_boot);
 	mutex_unlock(&dsp->pwr_lock);
 }
 
@@ -3510,30 +4547,22 @@ int wm_adsp2_early_event(struct snd_soc_dapm_widget *w,
 	struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
 	struct wm_adsp *dsps = snd_soc_codec_get_drvdata(codec);
 	struct wm_adsp *dsp = &dsps[w->shift];
-	struct wm_coeff_ctl *ctl;
 
 	switch (event) {
 	case SND_SOC_DAPM_PRE_PMU:
+		cancel_delayed_work_sync(&dsp->idle_work);
 		wm_adsp2_set_dspclk(dsp, freq);
 		queue_work(system_unbound_wq, &dsp->boot_work);
 		break;
 	case SND_SOC_DAPM_PRE_PMD:
 		mutex_lock(&dsp->pwr_lock);
 
-		wm_adsp_debugfs_clear(dsp);
-
-		dsp->fw_id = 0;
-		dsp->fw_id_version = 0;
-
-		dsp->booted = false;
-
-		regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
-				   ADSP2_MEM_ENA, 0);
-
-		list_for_each_entry(ctl, &dsp->ctl_list, list)
-			ctl->enabled = 0;
+		if (wm_adsp_park_resident(dsp)) {
+			mutex_unlock(&dsp->pwr_lock);
+			break;
+		}
 
-		wm_adsp_free_alg_regions(dsp);
+		wm_adsp_release_fw(dsp);
 
 		mutex_unlock(&dsp->pwr_lock);
 
@@ -3553,26 +4582,21 @@ int wm_halo_early_event(struct snd_soc_dapm_widget *w,
 	struct snd_soc_codec *codec = snd_soc_dapm_to_codec(w->dapm);
 	struct wm_adsp *dsps = snd_soc_codec_get_drvdata(codec);
 	struct wm_adsp *dsp = &dsps[w->shift];
-	struct wm_coeff_ctl *ctl;
 
 	switch (event) {
 	case SND_SOC_DAPM_PRE_PMU:
+		cancel_delayed_work_sync(&dsp->idle_work);
 		queue_work(system_unbound_wq, &dsp->boot_work);
 		break;
 	case SND_SOC_DAPM_PRE_PMD:
 		mutex_lock(&dsp->pwr_lock);
 
-		wm_adsp_debugfs_clear(dsp);
-
-		dsp->fw_id = 0;
-		dsp->fw_id_version = 0;
-
-		dsp->booted = false;
-
-		list_for_each_entry(ctl, &dsp->ctl_list, list)
-			ctl->enabled = 0;
+		if (wm_adsp_park_resident(dsp)) {
+			mutex_unlock(&dsp->pwr_lock);
+			break;
+		}
 
-		wm_adsp_free_alg_regions(dsp);
+		wm_adsp_release_fw(dsp);
 
 		mutex_unlock(&dsp->pwr_lock);
 
@@ -3586,6 +4610,49 @@ int wm_halo_early_event(struct snd_soc_dapm_widget *w,
 }
 EXPORT_SYMBOL_GPL(wm_halo_early_event);
 
+static int wm_adsp2_start_core(struct wm_adsp *dsp)
+{
+	int ret;
+
+	ret = wm_adsp2_ena(dsp);
+	if (ret != 0)
+		return ret;
+
+	/* Sync set controls */
+	ret = wm_coeff_sync_controls(dsp);
+	if (ret != 0)
+		return ret;
+
+	wm_adsp2_lock(dsp, dsp->lock_regions);
+
+	return regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
+				  ADSP2_CORE_ENA | ADSP2_START,
+				  ADSP2_CORE_ENA | ADSP2_START);
+}
+
+static void wm_adsp2_stop_core(struct wm_adsp *dsp)
+{
+	regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
+			   ADSP2_CORE_ENA | ADSP2_START, 0);
+
+	/* Make sure DMAs are quiesced */
+	switch (dsp->rev) {
+	case 0:
+		regmap_write(dsp->regmap, dsp->base + ADSP2_RDMA_CONFIG_1, 0);
+		regmap_write(dsp->regmap, dsp->base + ADSP2_WDMA_CONFIG_1, 0);
+		regmap_write(dsp->regmap, dsp->base + ADSP2_WDMA_CONFIG_2, 0);
+
+		regmap_update_bits(dsp->regmap, dsp->base + ADSP2_CONTROL,
+				   ADSP2_SYS_ENA, 0);
+		break;
+	default:
+		regmap_write(dsp->regmap, dsp->base + ADSP2_RDMA_CONFIG_1, 0);
+		regmap_write(dsp->regmap, dsp->base + ADSP2_WDMA_CONFIG_1, 0);
+		regmap_write(dsp->regmap, dsp->base + ADSP2V2_WDMA_CONFIG_2, 0);
+		break;
+	}
+}
+
 int wm_adsp2_event(struct snd_soc_dapm_widget *w,
 		   struct snd_kcontrol *kcontrol, int event)
 {
@@ -3605,21 +4672,7 @@ int wm_adsp2_event(struct snd_soc_dapm_widget *w,
 			goto err;
 		}
 
-		ret = wm_adsp2_ena(dsp);
-		if (ret != 0)
-			goto err;
-
-		/* Sync set controls */
-		ret = wm_coeff_sync_controls(dsp);
-		if (ret != 0)
-			goto err;
-
-		wm_adsp2_lock(dsp, dsp->lock_regions);
-
-		ret = regmap_update_bits(dsp->regmap,
-					 dsp->base + ADSP2_CONTROL,
-					 ADSP2_CORE_ENA | ADSP2_START,
-					 ADSP2_CORE_ENA | ADSP2_START);
+		ret = wm_adsp2_start_core(dsp);
 		if (ret != 0)
 			goto err;
 
@@ -3629,6 +4682,7 @@ int wm_adsp2_event(struct snd_soc_dapm_widget *w,
 				goto err;
 		}
 
+		dsp->recovery_burst = 0;
 		dsp->running = true;
 
 		mutex_unlock(&dsp->pwr_lock);
@@ -3655,33 +4709,7 @@ int wm_adsp2_event(struct snd_soc_dapm_widget *w,
 
 		dsp->running = false;
 
-		regmap_update_bits(dsp->regmap,
-				   dsp->base + ADSP2_CONTROL,
-				   ADSP2_CORE_ENA | ADSP2_START, 0);
-
-		/* Make sure DMAs are quiesced */
-		switch (dsp->rev) {
-		case 0:
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2_RDMA_CONFIG_1, 0);
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2_WDMA_CONFIG_1, 0);
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2_WDMA_CONFIG_2, 0);
-
-			regmap_update_bits(dsp->regmap,
-					   dsp->base + ADSP2_CONTROL,
-					   ADSP2_SYS_ENA, 0);
-			break;
-		default:
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2_RDMA_CONFIG_1, 0);
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2_WDMA_CONFIG_1, 0);
-			regmap_write(dsp->regmap,
-				     dsp->base + ADSP2V2_WDMA_CONFIG_2, 0);
-			break;
-		}
+		wm_adsp2_stop_core(dsp);
 
 		if (dsp->firmwares[dsp->fw].num_caps != 0)
 			wm_adsp_buffer_free(dsp);
@@ -3704,6 +4732,57 @@ err:
 }
 EXPORT_SYMBOL_GPL(wm_adsp2_event);
 
+static int wm_halo_start_core(struct wm_adsp *dsp)
+{
+	int ret;
+
+	ret = regmap_update_bits(dsp->regmap,
+				 dsp->base + HALO_CCM_CORE_CONTROL,
+				 HALO_CORE_RESET, HALO_CORE_RESET);
+	if (ret != 0) {
+		adsp_err(dsp, "Error while resetting core: %d\n", ret);
+		return ret;
+	}
+
+	/* Sync set controls */
+	ret = wm_coeff_sync_controls(dsp);
+	if (ret != 0)
+		return ret;
+
+	ret = wm_halo_sync_rates(dsp);
+	if (ret != 0)
+		return ret;
+
+	ret = wm_halo_clear_stream_arb(dsp);
+	if (ret != 0)
+		return ret;
+
+	/* disable NMI */
+	ret = regmap_write(dsp->regmap,
+			   dsp->base + HALO_INTP_CTL_NMI_CONTROL,
+			   0);
+	if (ret != 0) {
+		adsp_err(dsp, "Error while disabling NMI: %d\n", ret);
+		return ret;
+	}
+
+	ret = wm_halo_configure_mpu(dsp);
+	if (ret != 0)
+		return ret;
+
+	return regmap_update_bits(dsp->regmap,
+				  dsp->base + HALO_CCM_CORE_CONTROL,
+				  HALO_CORE_EN, HALO_CORE_EN);
+}
+
+static void wm_halo_stop_core(struct wm_adsp *dsp)
+{
+	regmap_update_bits(dsp->regmap, dsp->base + HALO_CCM_CORE_CONTROL,
+			   HALO_CORE_EN, 0);
+
+	wm_halo_clear_stream_arb(dsp);
+}
+
 int wm_halo_event(struct snd_soc_dapm_widget *w, struct snd_kcontrol *kcontrol,
 		  int event)
 {
@@ -3723,110 +4802,356 @@ int wm_halo_event(struct snd_soc_dapm_widget *w, struct snd_kcontrol *kcontrol,
 			goto err;
 		}
 
-		ret = regmap_update_bits(dsp->regmap,
-					 dsp->base + HALO_CCM_CORE_CONTROL,
-					 HALO_CORE_RESET, HALO_CORE_RESET);
+		ret = wm_halo_start_core(dsp);
+		if (ret != 0)
+			goto err;
+
+		if (dsp->firmwares[dsp->fw].num_caps != 0) {
+			ret = wm_adsp_buffer_init(dsp);
+			if (ret < 0)
+				goto err;
+		}
+
+		dsp->recovery_burst = 0;
+		dsp->running = true;
+
+		mutex_unlock(&dsp->pwr_lock);
+		break;
+	case SND_SOC_DAPM_PRE_PMD:
+		/* Tell the firmware to cleanup */
+		wm_adsp_signal_event_controls(dsp, WM_ADSP_FW_EVENT_SHUTDOWN);
+
+		/* Log firmware state, it can be useful for analysis */
+		wm_halo_show_fw_status(dsp);
+
+		mutex_lock(&dsp->pwr_lock);
+
+		dsp->running = false;
+
+		wm_halo_stop_core(dsp);
+
+		if (dsp->firmwares[dsp->fw].num_caps != 0)
+			wm_adsp_buffer_free(dsp);
+
+		mutex_unlock(&dsp->pwr_lock);
+
+		adsp_info(dsp, "Execution stopped\n");
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+err:
+	mutex_unlock(&dsp->pwr_lock);
+	regmap_update_bits(dsp->regmap, dsp->base + HALO_CCM_CORE_CONTROL,
+			   HALO_CORE_EN, 0);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(wm_halo_event);
+
+#define WM_ADSP_SNAPSHOT_MAGIC		0x53504457	/* "WDPS" */
+#define WM_ADSP_SNAPSHOT_MAX_READ	SZ_32K
+
+struct wm_adsp_snapshot_hdr {
+	__le32 magic;
+	__le32 core;
+	__le32 num;
+	__le32 fw_id;
+	__le32 fw_version;
+	__le32 n_regions;
+} __packed;
+
+struct wm_adsp_snapshot_region {
+	__le32 type;
+	__le32 base;
+	__le32 len;
+} __packed;
+
+/* Length in bytes of the raw register data backing a memory region */
+static size_t wm_adsp_region_len(struct wm_adsp *dsp,
+				 const struct wm_adsp_region *mem)
+{
+	unsigned int words;
+
+	/* The packed HALO XM/YM views alias the unpacked ones, skip them */
+	switch (mem->type) {
+	case WMFW_ADSP2_XM:
+		words = dsp->xm_words;
+		break;
+	case WMFW_ADSP2_YM:
+		words = dsp->ym_words;
+		break;
+	case WMFW_ADSP2_PM:
+	case WMFW_HALO_PM_PACKED:
+		words = dsp->pm_words;
+		break;
+	case WMFW_ADSP2_ZM:
+		words = dsp->zm_words;
+		break;
+	default:
+		return 0;
+	}
+
+	if (!words)
+		return 0;
+
+	return round_down((wm_adsp_region_to_reg(dsp, mem, words) - mem->base) *
+			  wm_adsp_addr_div(dsp), 4);
+}
+
+/* Called with pwr_lock held */
+static void wm_adsp_capture_snapshot(struct wm_adsp *dsp)
+{
+	struct wm_adsp_snapshot_hdr *hdr;
+	struct wm_adsp_snapshot_region *rgn;
+	const struct wm_adsp_region *mem;
+	size_t len, total, chunk, max_read, done;
+	ktime_t start = ktime_get();
+	unsigned int reg, n = 0;
+	void *dump, *bounce;
+	u8 *pos;
+	int i, ret;
+
+	dsp->snapshot_pending = false;
+
+	if (!dsp->booted)
+		return;
+
+	total = sizeof(*hdr);
+	for (i = 0; i < dsp->num_mems; i++) {
+		len = wm_adsp_region_len(dsp, &dsp->mem[i]);
+		if (len)
+			total += sizeof(*rgn) + len;
+	}
+
+	/* Use the biggest reads the bus allows to keep this quick */
+	max_read = regmap_get_raw_read_max(dsp->regmap);
+	if (!max_read || max_read > WM_ADSP_SNAPSHOT_MAX_READ)
+		max_read = WM_ADSP_SNAPSHOT_MAX_READ;
+	max_read = round_down(max_read, 4);
+
+	dump = vzalloc(total);
+	bounce = kmalloc(max_read, GFP_KERNEL | GFP_DMA);
+	if (!dump || !bounce) {
+		adsp_err(dsp, "Failed to allocate %zu byte snapshot\n", total);
+		goto err;
+	}
+
+	hdr = dump;
+	pos = dump + sizeof(*hdr);
+
+	for (i = 0; i < dsp->num_mems; i++) {
+		mem = &dsp->mem[i];
+
+		len = wm_adsp_region_len(dsp, mem);
+		if (!len)
+			continue;
+
+		rgn = (void *)pos;
+		rgn->type = cpu_to_le32(mem->type);
+		rgn->base = cpu_to_le32(mem->base);
+		rgn->len = cpu_to_le32(len);
+		pos += sizeof(*rgn);
+
+		reg = mem->base;
+		for (done = 0; done < len; done += chunk) {
+			chunk = min(len - done, max_read);
+
+			ret = regmap_raw_read(dsp->regmap, reg, bounce, chunk);
+			if (ret) {
+				adsp_err(dsp, "Failed to read 0x%x: %d\n",
+					 reg, ret);
+				goto err;
+			}
+
+			memcpy(pos + done, bounce, chunk);
+			reg += chunk / wm_adsp_addr_div(dsp);
+		}
+
+		pos += len;
+		n++;
+	}
+
+	hdr->magic = cpu_to_le32(WM_ADSP_SNAPSHOT_MAGIC);
+	hdr->core = cpu_to_le32(dsp->type);
+	hdr->num = cpu_to_le32(dsp->num);
+	hdr->fw_id = cpu_to_le32(dsp->fw_id);
+	hdr->fw_version = cpu_to_le32(dsp->fw_id_version);
+	hdr->n_regions = cpu_to_le32(n);
+
+	kfree(bounce);
+
+	adsp_info(dsp, "Captured %zu byte snapshot in %lldus\n", total,
+		  ktime_to_us(ktime_sub(ktime_get(), start)));
+
+	/* devcoredump takes ownership of the buffer */
+	dev_coredumpv(dsp->dev, dump, total, GFP_KERNEL);
+
+	return;
+
+err:
+	kfree(bounce);
+	vfree(dump);
+}
+
+static void wm_adsp_snapshot_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work,
+					   struct wm_adsp,
+					   snapshot_work);
+
+	mutex_lock(&dsp->pwr_lock);
+	if (dsp->snapshot_pending)
+		wm_adsp_capture_snapshot(dsp);
+	mutex_unlock(&dsp->pwr_lock);
+}
+
+void wm_adsp_queue_snapshot(struct wm_adsp *dsp)
+{
+	dsp->snapshot_pending = true;
+	queue_work(system_unbound_wq, &dsp->snapshot_work);
+}
+EXPORT_SYMBOL_GPL(wm_adsp_queue_snapshot);
+
+/* Called with pwr_lock held */
+static int wm_adsp_recover(struct wm_adsp *dsp)
+{
+	int ret;
+
+	switch (dsp->type) {
+	case WMFW_HALO:
+		wm_halo_stop_core(dsp);
+		wm_adsp_reset_fw_state(dsp);
+		wm_adsp_delta_invalidate(dsp);
+
+		ret = wm_halo_boot(dsp);
+		if (ret != 0)
+			return ret;
+
+		ret = wm_halo_start_core(dsp);
+		if (ret != 0) {
+			regmap_update_bits(dsp->regmap,
+					   dsp->base + HALO_CCM_CORE_CONTROL,
+					   HALO_CORE_EN, 0);
+			return ret;
+		}
+		break;
+	default:
+		wm_adsp_stop_watchdog(dsp);
+		wm_adsp2_stop_core(dsp);
+		wm_adsp_reset_fw_state(dsp);
+		wm_adsp_delta_invalidate(dsp);
+
+		ret = wm_adsp2_boot(dsp);
+		if (ret != 0)
+			return ret;
+
+		ret = wm_adsp2_start_core(dsp);
 		if (ret != 0) {
-			adsp_err(dsp, "Error while resetting core: %d\n", ret);
+			regmap_update_bits(dsp->regmap,
+					   dsp->base + ADSP2_CONTROL,
+					   ADSP2_SYS_ENA | ADSP2_CORE_ENA |
+					   ADSP2_START, 0);
 			return ret;
 		}
+		break;
+	}
+
+	if (dsp->firmwares[dsp->fw].num_caps != 0)
+		return wm_adsp_buffer_recover(dsp);
+
+	return 0;
+}
+
+/*
+ * A DSP that faults again soon after each restart is left stopped after a few
+ * attempts instead of being restarted forever
+ */
+#define WM_ADSP_RECOVERY_MAX_BURST	3
+#define WM_ADSP_RECOVERY_WINDOW_MS	10000
+
+static void wm_adsp_recovery_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work,
+					   struct wm_adsp,
+					   recovery_work);
+	ktime_t start = ktime_get();
+	int ret;
 
-		/* Sync set controls */
-		ret = wm_coeff_sync_controls(dsp);
-		if (ret != 0)
-			goto err;
+	mutex_lock(&dsp->pwr_lock);
 
-#ifdef REMOVE_SYNC_SET_RATE
-		adsp_dbg(dsp, "Setting RX and TX rates DISABLED.\n");
-#else
-		adsp_dbg(dsp, "Setting RX rates.\n");
-		ret = wm_halo_set_rate_block(dsp, HALO_SAMPLE_RATE_RX1,
-					     dsp->n_rx_channels,
-					     dsp->rx_rate_cache);
-		if (ret) {
-			adsp_err(dsp, "Failed to set RX rates.\n");
-			goto err;
-		}
+	/* Nothing to do if the DSP was powered down in the meantime */
+	if (!dsp->running)
+		goto out;
 
-		adsp_dbg(dsp, "Setting TX rates.\n");
-		ret = wm_halo_set_rate_block(dsp, HALO_SAMPLE_RATE_TX1,
-					     dsp->n_tx_channels,
-					     dsp->tx_rate_cache);
-		if (ret) {
-			adsp_err(dsp, "Failed to set TX rates.\n");
-			goto err;
-		}
-#endif
+	/* Capture the faulted state before it is overwritten */
+	if (dsp->snapshot_pending)
+		wm_adsp_capture_snapshot(dsp);
 
-		ret = wm_halo_clear_stream_arb(dsp);
-		if (ret != 0)
-			goto err;
+	if (ktime_to_ms(ktime_sub(start, dsp->recovery_last)) <
+	    WM_ADSP_RECOVERY_WINDOW_MS)
+		dsp->recovery_burst++;
+	else
+		dsp->recovery_burst = 1;
 
-		/* disable NMI */
-		ret = regmap_write(dsp->regmap,
-				   dsp->base + HALO_INTP_CTL_NMI_CONTROL,
-				   0);
-		if (ret != 0) {
-			adsp_err(dsp, "Error while disabling NMI: %d\n", ret);
-			goto err;
-		}
+	dsp->recovery_last = start;
 
-		ret = wm_halo_configure_mpu(dsp);
-		if (ret != 0)
-			goto err;
+	dsp->running = false;
 
-		ret = regmap_update_bits(dsp->regmap,
-					 dsp->base + HALO_CCM_CORE_CONTROL,
-					 HALO_CORE_EN, HALO_CORE_EN);
-		if (ret != 0)
-			goto err;
+	if (dsp->recovery_burst > WM_ADSP_RECOVERY_MAX_BURST) {
+		adsp_err(dsp, "DSP keeps faulting, leaving it stopped\n");
 
-		if (dsp->firmwares[dsp->fw].num_caps != 0) {
-			ret = wm_adsp_buffer_init(dsp);
-			if (ret < 0)
-				goto err;
+		switch (dsp->type) {
+		case WMFW_HALO:
+			wm_halo_stop_core(dsp);
+			break;
+		default:
+			wm_adsp_stop_watchdog(dsp);
+			wm_adsp2_stop_core(dsp);
+			break;
 		}
 
-		dsp->running = true;
+		dsp->recovery_failures++;
 
-		mutex_unlock(&dsp->pwr_lock);
-		break;
-	case SND_SOC_DAPM_PRE_PMD:
-		/* Tell the firmware to cleanup */
-		wm_adsp_signal_event_controls(dsp, WM_ADSP_FW_EVENT_SHUTDOWN);
+		if (dsp->firmwares[dsp->fw].num_caps != 0)
+			wm_adsp_buffer_free(dsp);
+		goto out;
+	}
 
-		/* Log firmware state, it can be useful for analysis */
-		wm_halo_show_fw_status(dsp);
+	adsp_warn(dsp, "Restarting DSP after fatal error\n");
 
-		mutex_lock(&dsp->pwr_lock);
+	dsp->recovering = true;
 
-		dsp->running = false;
+	ret = wm_adsp_recover(dsp);
 
-		regmap_update_bits(dsp->regmap,
-				   dsp->base + HALO_CCM_CORE_CONTROL,
-				   HALO_CORE_EN, 0);
+	dsp->recovering = false;
+	dsp->recovery_time_us = ktime_to_us(ktime_sub(ktime_get(), start));
 
-		wm_halo_clear_stream_arb(dsp);
+	if (ret) {
+		dsp->recovery_failures++;
+		adsp_err(dsp, "Failed to recover DSP: %d\n", ret);
 
 		if (dsp->firmwares[dsp->fw].num_caps != 0)
 			wm_adsp_buffer_free(dsp);
+		goto out;
+	}
 
-		mutex_unlock(&dsp->pwr_lock);
+	dsp->running = true;
+	dsp->recovery_count++;
 
-		adsp_info(dsp, "Execution stopped\n");
-		break;
-	default:
-		break;
-	}
+	adsp_info(dsp, "Recovered in %uus (%u recoveries)\n",
+		  dsp->recovery_time_us, dsp->recovery_count);
 
-	return 0;
-err:
+out:
 	mutex_unlock(&dsp->pwr_lock);
-	regmap_update_bits(dsp->regmap, dsp->base + HALO_CCM_CORE_CONTROL,
-			   HALO_CORE_EN, 0);
-	return ret;
 }
-EXPORT_SYMBOL_GPL(wm_halo_event);
+
+static void wm_adsp_schedule_recovery(struct wm_adsp *dsp)
+{
+	if (dsp->running)
+		queue_work(system_unbound_wq, &dsp->recovery_work);
+}
 
 int wm_adsp2_codec_probe(struct wm_adsp *dsp, struct snd_soc_codec *codec)
 {
@@ -3853,6 +5178,12 @@ int wm_adsp2_codec_probe(struct wm_adsp *dsp, struct snd_soc_codec *codec)
 					 1);
 	else
 		ret = snd_soc_add_codec_controls(codec, &dsp->fw_ctrl, 1);
+	if (ret)
+		return ret;
+
+	if (!dsp->ao_dsp && dsp->num <= ARRAY_SIZE(wm_adsp_residency_controls))
+		ret = snd_soc_add_codec_controls(codec,
+				&wm_adsp_residency_controls[dsp->num - 1], 1);
 
 	return ret;
 }
@@ -3972,6 +5303,9 @@ static int wm_adsp_of_parse_firmware(struct wm_adsp *dsp,
 		dsp->firmwares[i].fullname =
 			of_property_read_bool(fw, "cirrus,full-name");
 
+		dsp->firmwares[i].sample_count =
+			of_property_read_bool(fw, "cirrus,sample-count");
+
 		wm_adsp_of_parse_caps(dsp, fw, &dsp->firmwares[i]);
 
 		i++;
@@ -4013,6 +5347,13 @@ static int wm_adsp_of_parse_adsp(struct wm_adsp *dsp)
 	if (!core)
 		return 0;
 
+	dsp->delta_switch = of_property_read_bool(core,
+						  "cirrus,delta-fw-switch");
+
+	of_property_read_u32(core, "cirrus,trigger-prefetch-bytes",
+			     &dsp->prefetch_bytes);
+	dsp->prefetch_bytes -= dsp->prefetch_bytes % WM_ADSP_DATA_WORD_SIZE;
+
 	return wm_adsp_of_parse_firmware(dsp, core);
 }
 #else
@@ -4047,6 +5388,10 @@ int wm_adsp2_init(struct wm_adsp *dsp)
 	INIT_LIST_HEAD(&dsp->alg_regions);
 	INIT_LIST_HEAD(&dsp->ctl_list);
 	INIT_WORK(&dsp->boot_work, wm_adsp2_boot_work);
+	INIT_WORK(&dsp->recovery_work, wm_adsp_recovery_work);
+	INIT_DELAYED_WORK(&dsp->idle_work, wm_adsp_idle_work);
+	INIT_WORK(&dsp->snapshot_work, wm_adsp_snapshot_work);
+	INIT_WORK(&dsp->prefetch_work, wm_adsp_prefetch_work);
 
 	mutex_init(&dsp->pwr_lock);
 
@@ -4066,14 +5411,24 @@ int wm_halo_init(struct wm_adsp *dsp, struct mutex *rate_lock)
 	INIT_LIST_HEAD(&dsp->alg_regions);
 	INIT_LIST_HEAD(&dsp->ctl_list);
 	INIT_WORK(&dsp->boot_work, wm_halo_boot_work);
+	INIT_WORK(&dsp->recovery_work, wm_adsp_recovery_work);
+	INIT_DELAYED_WORK(&dsp->idle_work, wm_adsp_idle_work);
+	INIT_WORK(&dsp->snapshot_work, wm_adsp_snapshot_work);
+	INIT_WORK(&dsp->prefetch_work, wm_adsp_prefetch_work);
 
 	mutex_init(&dsp->pwr_lock);
 
 	dsp->rate_lock = rate_lock;
-	dsp->rx_rate_cache = kcalloc(dsp->n_rx_channels, sizeof(u8),
-				     GFP_KERNEL);
-	dsp->tx_rate_cache = kcalloc(dsp->n_tx_channels, sizeof(u8),
-				     GFP_KERNEL);
+	dsp->rx_rate_cache = kmalloc(dsp->n_rx_channels, GFP_KERNEL);
+	dsp->tx_rate_cache = kmalloc(dsp->n_tx_channels, GFP_KERNEL);
+	if (!dsp->rx_rate_cache || !dsp->tx_rate_cache) {
+		kfree(dsp->rx_rate_cache);
+		kfree(dsp->tx_rate_cache);
+		return -ENOMEM;
+	}
+
+	memset(dsp->rx_rate_cache, WM_HALO_RATE_UNSET, dsp->n_rx_channels);
+	memset(dsp->tx_rate_cache, WM_HALO_RATE_UNSET, dsp->n_tx_channels);
 
 	if (!dsp->dev->of_node || wm_adsp_of_parse_adsp(dsp) <= 0) {
 		dsp->fw_enum = wm_adsp_fw_enum[dsp->num - 1];
@@ -4090,6 +5445,19 @@ void wm_adsp2_remove(struct wm_adsp *dsp)
 {
 	struct wm_coeff_ctl *ctl;
 
+	cancel_work_sync(&dsp->recovery_work);
+	cancel_work_sync(&dsp->snapshot_work);
+	cancel_work_sync(&dsp->prefetch_work);
+	cancel_delayed_work_sync(&dsp->idle_work);
+
+	wm_adsp_fw_cache_free(&dsp->wmfw_cache);
+	wm_adsp_fw_cache_free(&dsp->bin_cache);
+	wm_adsp_delta_invalidate(dsp);
+	wm_adsp_reg_seq_free(dsp->arb_seq);
+	wm_adsp_reg_seq_free(dsp->mpu_seq);
+	kfree(dsp->rx_rate_cache);
+	kfree(dsp->tx_rate_cache);
+
 	while (!list_empty(&dsp->ctl_list)) {
 		ctl = list_first_entry(&dsp->ctl_list, struct wm_coeff_ctl,
 					list);
@@ -4123,6 +5491,17 @@ static int wm_adsp_compr_attach(struct wm_adsp_compr *compr)
 	return 0;
 }
 
+/* Discard any trigger history held on the host and stop collecting more */
+static void wm_adsp_buffer_drop_prefetch(struct wm_adsp_compr_buf *buf)
+{
+	buf->prefetch_active = false;
+
+	vfree(buf->prefetch);
+	buf->prefetch = NULL;
+	buf->prefetch_head = 0;
+	buf->prefetch_len = 0;
+}
+
 static void wm_adsp_compr_detach(struct wm_adsp_compr *compr)
 {
 	if (!compr)
@@ -4133,6 +5512,12 @@ static void wm_adsp_compr_detach(struct wm_adsp_compr *compr)
 		snd_compr_fragment_elapsed(compr->stream);
 
 	if (wm_adsp_compr_attached(compr)) {
+		/*
+		 * History the closing reader didn't drain belongs to its
+		 * session, it mustn't be served to the next stream
+		 */
+		wm_adsp_buffer_drop_prefetch(compr->buf);
+		compr->buf->lat_pending = false;
 		compr->buf->compr = NULL;
 		compr->buf = NULL;
 	}
@@ -4332,6 +5717,8 @@ static int wm_adsp_read_data_block(struct wm_adsp *dsp, int mem_type,
 	if (ret < 0)
 		return ret;
 
+	wm_adsp_bus_account(dsp, WM_ADSP_BUS_STREAM, sizeof(*data) * num_words);
+
 	for (i = 0; i < num_words; ++i)
 		data[i] = be32_to_cpu(data[i]) & 0x00ffffffu;
 
@@ -4357,9 +5744,50 @@ static int wm_adsp_write_data_word(struct wm_adsp *dsp, int mem_type,
 
 	data = cpu_to_be32(data & 0x00ffffffu);
 
+	wm_adsp_bus_account(dsp, WM_ADSP_BUS_STREAM, sizeof(data));
+
 	return regmap_raw_write(dsp->regmap, reg, &data, sizeof(data));
 }
 
+/*
+ * Tell the DSP its memory may have lost power, for example because the codec
+ * has runtime suspended. Any parked firmware or program memory hashes are
+ * then distrusted at the next boot. Safe to call without pwr_lock.
+ */
+void wm_adsp_power_lost(struct wm_adsp *dsp)
+{
+	atomic_set(&dsp->power_lost, 1);
+}
+EXPORT_SYMBOL_GPL(wm_adsp_power_lost);
+
+/*
+ * Read a word of an algorithm's XM block while the firmware is running,
+ * for codec drivers sampling status the firmware publishes there.
+ */
+int wm_adsp_read_alg_xm(struct wm_adsp *dsp, unsigned int alg,
+			unsigned int offset, u32 *val)
+{
+	struct wm_adsp_alg_region *alg_region;
+	int ret = -EBUSY;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	if (dsp->running) {
+		alg_region = wm_adsp_find_alg_region(dsp, WMFW_ADSP2_XM, alg);
+		if (alg_region)
+			ret = wm_adsp_read_data_word(dsp, WMFW_ADSP2_XM,
+						     alg_region->base + offset,
+						     val);
+		else
+			ret = -ENOENT;
+	}
+
+	mutex_unlock(&dsp->pwr_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(wm_adsp_read_alg_xm);
+
 static inline int wm_adsp_buffer_read(struct wm_adsp_compr_buf *buf,
 				      unsigned int field_offset, u32 *data)
 {
@@ -4573,6 +6001,7 @@ static int wm_adsp_buffer_free(struct wm_adsp *dsp)
 		if (dsp->buffer[i]) {
 			wm_adsp_compr_detach(dsp->buffer[i]->compr);
 
+			wm_adsp_buffer_drop_prefetch(dsp->buffer[i]);
 			kfree(dsp->buffer[i]->regions);
 			kfree(dsp->buffer[i]);
 
@@ -4583,6 +6012,70 @@ static int wm_adsp_buffer_free(struct wm_adsp *dsp)
 	return 0;
 }
 
+/*
+ * Relocate the host buffers after the firmware has been restarted and hand
+ * them back to any streams that were attached, so capture carries on.
+ */
+static int wm_adsp_buffer_recover(struct wm_adsp *dsp)
+{
+	struct wm_adsp_compr *compr[WM_ADSP_MAX_CHANNEL_PER_DSP] = { NULL };
+	struct wm_adsp_compr_buf *buf;
+	int i, ret;
+
+	for (i = 0; i < dsp->buf_num; i++) {
+		buf = dsp->buffer[i];
+		if (buf && buf->compr) {
+			compr[i] = buf->compr;
+			compr[i]->buf = NULL;
+			buf->compr = NULL;
+		}
+	}
+
+	wm_adsp_buffer_free(dsp);
+
+	ret = wm_adsp_buffer_init(dsp);
+	if (ret < 0) {
+		adsp_err(dsp, "Failed to recover host buffer: %d\n", ret);
+		goto err;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(compr); i++) {
+		if (!compr[i])
+			continue;
+
+		buf = dsp->buffer[i];
+		if (!buf) {
+			ret = -ENODEV;
+			goto err;
+		}
+
+		compr[i]->buf = buf;
+		buf->compr = compr[i];
+		buf->avail = 0;
+
+		ret = wm_adsp_buffer_write(buf,
+					   HOST_BUFFER_FIELD(high_water_mark),
+					   wm_adsp_compr_frag_words(compr[i]));
+		if (ret < 0) {
+			adsp_err(dsp, "Failed to set high water mark: %d\n",
+				 ret);
+			goto err;
+		}
+
+		compr[i] = NULL;
+	}
+
+	return 0;
+
+err:
+	/* Wake any stream we couldn't reattach so it sees the error */
+	for (i = 0; i < ARRAY_SIZE(compr); i++)
+		if (compr[i] && compr[i]->stream)
+			snd_compr_fragment_elapsed(compr[i]->stream);
+
+	return ret;
+}
+
 int wm_adsp_compr_trigger(struct snd_compr_stream *stream, int cmd)
 {
 	struct wm_adsp_compr *compr = stream->runtime->private_data;
@@ -4605,6 +6098,10 @@ int wm_adsp_compr_trigger(struct snd_compr_stream *stream, int cmd)
 			break;
 		}
 
+		/*
+		 * History prefetched since the last stream was freed was
+		 * captured for this session, so it is kept and served first.
+		 */
 		compr->buf->avail = 0;
 
 		/* Trigger the IRQ at one fragment of data */
@@ -4673,6 +6170,7 @@ static int wm_adsp_buffer_update_avail(struct wm_adsp_compr_buf *buf)
 		return ret;
 
 	write_index = sign_extend32(next_write_index, 23);
+	buf->write_index = write_index;
 
 	/* Don't empty the buffer as it kills the firmware */
 	write_index--;
@@ -4706,10 +6204,56 @@ static int wm_adsp_buffer_get_error(struct wm_adsp_compr_buf *buf)
 	return 0;
 }
 
+/* Words ready for the reader, including any already prefetched to the host */
+static inline int wm_adsp_buffer_words(struct wm_adsp_compr_buf *buf)
+{
+	return buf->avail + buf->prefetch_len / WM_ADSP_DATA_WORD_SIZE;
+}
+
+/*
+ * Latch where the DSP had written up to when it raised the IRQ, so the
+ * captured data can be related to host time, and start timing delivery
+ * of the fragment unless one is already being timed.
+ */
+static int wm_adsp_buffer_latch_irq(struct wm_adsp_compr_buf *buf,
+				    ktime_t now)
+{
+	struct wm_adsp *dsp = buf->dsp;
+	u32 words_written[2];
+	int ret;
+
+	buf->irq_time = now;
+	buf->irq_write_index = buf->write_index;
+
+	if (!buf->lat_pending && buf->avail) {
+		buf->lat_start = now;
+		buf->lat_target = wm_adsp_buffer_words(buf) *
+				  WM_ADSP_DATA_WORD_SIZE;
+		if (buf->compr)
+			buf->lat_target += buf->compr->copied_total;
+		buf->lat_pending = true;
+	}
+
+	if (dsp->firmwares[dsp->fw].sample_count) {
+		ret = wm_adsp_read_data_block(dsp, WMFW_ADSP2_XM,
+				buf->host_buf_ptr +
+				HOST_BUFFER_FIELD(words_written),
+				ARRAY_SIZE(words_written), words_written);
+		if (ret < 0)
+			return ret;
+
+		buf->irq_words = ((u64)words_written[0] << 24) |
+				 words_written[1];
+	}
+
+	return 0;
+}
+
 int wm_adsp_compr_handle_irq(struct wm_adsp *dsp, int channel)
 {
 	struct wm_adsp_compr_buf *buf;
 	struct wm_adsp_compr *compr;
+	ktime_t now = ktime_get();
 	int ret = 0;
 
 	mutex_lock(&dsp->pwr_lock);
@@ -4741,9 +6285,29 @@ int wm_adsp_compr_handle_irq(struct wm_adsp *dsp, int channel)
 		goto out;
 	}
 
-	if (dsp->firmwares[dsp->fw].voice_trigger && buf->irq_count == 2)
+	/* Only the debug position is lost, so still report the fragment */
+	ret = wm_adsp_buffer_latch_irq(buf, now);
+	if (ret < 0) {
+		adsp_err(dsp, "Failed to latch IRQ position: %d\n", ret);
+		ret = 0;
+	}
+
+	if (dsp->firmwares[dsp->fw].voice_trigger && buf->irq_count == 2) {
 		ret = WM_ADSP_COMPR_VOICE_TRIGGER;
 
+		/*
+		 * Start pulling the pre-roll into the host now, unless a
+		 * reader is already consuming the stream.
+		 */
+		if (dsp->prefetch_bytes && !(compr && compr->copied_total)) {
+			buf->prefetch_active = true;
+			dsp->prefetch_triggers++;
+		}
+	}
+
+	if (buf->prefetch_active)
+		queue_work(system_highpri_wq, &dsp->prefetch_work);
+
 out_notify:
 	if (compr && compr->stream)
 		snd_compr_fragment_elapsed(compr->stream);
@@ -4789,7 +6353,7 @@ int wm_adsp_compr_pointer(struct snd_compr_stream *stream,
 		goto out;
 	}
 
-	if (buf->avail < wm_adsp_compr_frag_words(compr)) {
+	if (wm_adsp_buffer_words(buf) < wm_adsp_compr_frag_words(compr)) {
 		ret = wm_adsp_buffer_update_avail(buf);
 		if (ret < 0) {
 			adsp_err(dsp, "Error reading avail: %d\n", ret);
@@ -4800,7 +6364,8 @@ int wm_adsp_compr_pointer(struct snd_compr_stream *stream,
 		 * If we really have less than 1 fragment available tell the
 		 * DSP to inform us once a whole fragment is available.
 		 */
-		if (buf->avail < wm_adsp_compr_frag_words(compr)) {
+		if (wm_adsp_buffer_words(buf) <
+		    wm_adsp_compr_frag_words(compr)) {
 			ret = wm_adsp_buffer_get_error(buf);
 			if (ret < 0) {
 				if (compr->buf->error)
@@ -4820,7 +6385,8 @@ int wm_adsp_compr_pointer(struct snd_compr_stream *stream,
 	}
 
 	tstamp->copied_total = compr->copied_total;
-	tstamp->copied_total += buf->avail * WM_ADSP_DATA_WORD_SIZE;
+	tstamp->copied_total += wm_adsp_buffer_words(buf) *
+				WM_ADSP_DATA_WORD_SIZE;
 	tstamp->sampling_rate = compr->sample_rate;
 
 out:
@@ -4830,14 +6396,14 @@ out:
 }
 EXPORT_SYMBOL_GPL(wm_adsp_compr_pointer);
 
-static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
+static int wm_adsp_buffer_capture_words(struct wm_adsp_compr_buf *buf,
+					u32 *raw_buf, int max_read, int target)
 {
-	struct wm_adsp_compr_buf *buf = compr->buf;
 	struct wm_adsp *dsp = buf->dsp;
-	u8 *pack_in = (u8 *)compr->raw_buf;
-	u8 *pack_out = (u8 *)compr->raw_buf;
+	u8 *pack_in = (u8 *)raw_buf;
+	u8 *pack_out = (u8 *)raw_buf;
 	unsigned int adsp_addr;
-	int mem_type, nwords, max_read;
+	int mem_type, nwords;
 	int i, j, ret;
 
 	/* Calculate read parameters */
@@ -4848,11 +6414,12 @@ static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
 	if (i == dsp->firmwares[dsp->fw].caps->num_regions)
 		return -EINVAL;
 
+	dsp->bus_stats[WM_ADSP_BUS_STREAM].ops++;
+
 	mem_type = buf->regions[i].mem_type;
 	adsp_addr = buf->regions[i].base_addr +
 		    (buf->read_index - buf->regions[i].offset);
 
-	max_read = wm_adsp_compr_frag_words(compr);
 	nwords = buf->regions[i].cumulative_size - buf->read_index;
 
 	if (nwords > target)
@@ -4866,7 +6433,7 @@ static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
 
 	/* Read data from DSP */
 	ret = wm_adsp_read_data_block(buf->dsp, mem_type, adsp_addr,
-				      nwords, compr->raw_buf);
+				      nwords, raw_buf);
 	if (ret < 0)
 		return ret;
 
@@ -4875,7 +6442,7 @@ static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
 		for (j = 0; j < WM_ADSP_DATA_WORD_SIZE; j++)
 			*pack_out++ = *pack_in++;
 
-		pack_in += sizeof(*(compr->raw_buf)) - WM_ADSP_DATA_WORD_SIZE;
+		pack_in += sizeof(*raw_buf) - WM_ADSP_DATA_WORD_SIZE;
 	}
 
 	/* update read index to account for words read */
@@ -4894,6 +6461,132 @@ static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
 	return nwords;
 }
 
+static int wm_adsp_buffer_capture_block(struct wm_adsp_compr *compr, int target)
+{
+	return wm_adsp_buffer_capture_words(compr->buf, compr->raw_buf,
+					    wm_adsp_compr_frag_words(compr),
+					    target);
+}
+
+static int wm_adsp_buffer_prefetch(struct wm_adsp_compr_buf *buf, u32 *raw_buf)
+{
+	struct wm_adsp *dsp = buf->dsp;
+	int space, nwords = 0;
+	int ret;
+
+	if (!buf->prefetch) {
+		buf->prefetch = vmalloc(dsp->prefetch_bytes);
+		if (!buf->prefetch)
+			return -ENOMEM;
+	}
+
+	ret = wm_adsp_buffer_update_avail(buf);
+	if (ret < 0)
+		return ret;
+
+	/* Nothing is consumed until the reader arrives, so just append */
+	for (;;) {
+		space = (dsp->prefetch_bytes - buf->prefetch_len) /
+			WM_ADSP_DATA_WORD_SIZE;
+		if (!space)
+			break;
+
+		nwords = wm_adsp_buffer_capture_words(buf, raw_buf,
+					WM_ADSP_PREFETCH_CHUNK_WORDS, space);
+		if (nwords <= 0)
+			break;
+
+		memcpy(buf->prefetch + buf->prefetch_len, raw_buf,
+		       nwords * WM_ADSP_DATA_WORD_SIZE);
+		buf->prefetch_len += nwords * WM_ADSP_DATA_WORD_SIZE;
+	}
+
+	if (nwords < 0)
+		return nwords;
+
+	adsp_dbg(dsp, "Prefetched %zu bytes\n", buf->prefetch_len);
+
+	if (!space)
+		return 0;
+
+	/* Ask the DSP to tell us when more history is ready */
+	return wm_adsp_buffer_reenable_irq(buf);
+}
+
+static void wm_adsp_prefetch_work(struct work_struct *work)
+{
+	struct wm_adsp *dsp = container_of(work, struct wm_adsp,
+					   prefetch_work);
+	struct wm_adsp_compr_buf *buf;
+	u32 *raw_buf;
+	int i, ret;
+
+	raw_buf = kmalloc_array(WM_ADSP_PREFETCH_CHUNK_WORDS, sizeof(*raw_buf),
+				GFP_DMA | GFP_KERNEL);
+	if (!raw_buf)
+		return;
+
+	mutex_lock(&dsp->pwr_lock);
+
+	for (i = 0; i < dsp->buf_num; i++) {
+		buf = dsp->buffer[i];
+		if (!buf || !buf->prefetch_active || buf->error)
+			continue;
+
+		ret = wm_adsp_buffer_prefetch(buf, raw_buf);
+		if (ret < 0) {
+			adsp_err(dsp, "Failed to prefetch buffer %d: %d\n",
+				 i, ret);
+			buf->prefetch_active = false;
+		}
+	}
+
+	mutex_unlock(&dsp->pwr_lock);
+
+	kfree(raw_buf);
+}
+
+static int wm_adsp_buffer_read_prefetch(struct wm_adsp_compr_buf *buf,
+					char __user *ubuf, size_t count)
+{
+	size_t nbytes = min(count, buf->prefetch_len);
+
+	if (copy_to_user(ubuf, buf->prefetch + buf->prefetch_head, nbytes))
+		return -EFAULT;
+
+	buf->prefetch_head += nbytes;
+	buf->prefetch_len -= nbytes;
+	buf->dsp->prefetch_bytes_served += nbytes;
+
+	if (!buf->prefetch_len)
+		wm_adsp_buffer_drop_prefetch(buf);
+
+	return nbytes;
+}
+
+static void wm_adsp_compr_account_latency(struct wm_adsp_compr *compr)
+{
+	struct wm_adsp_compr_buf *buf = compr->buf;
+	struct wm_adsp_latency_stats *stats = &compr->dsp->compr_latency;
+	u32 us;
+
+	if (!buf->lat_pending || compr->copied_total < buf->lat_target)
+		return;
+
+	buf->lat_pending = false;
+
+	us = ktime_to_us(ktime_sub(ktime_get(), buf->lat_start));
+
+	if (!stats->count || us < stats->min_us)
+		stats->min_us = us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+
+	stats->last_us = us;
+	stats->total_us += us;
+	stats->count++;
+}
+
 static int wm_adsp_compr_read(struct wm_adsp_compr *compr,
 			      char __user *buf, size_t count)
 {
@@ -4910,12 +6603,30 @@ static int wm_adsp_compr_read(struct wm_adsp_compr *compr,
 
 	count /= WM_ADSP_DATA_WORD_SIZE;
 
-	do {
+	/* The reader has arrived, serve it the history captured so far */
+	compr->buf->prefetch_active = false;
+
+	if (compr->buf->prefetch_len) {
+		nbytes = wm_adsp_buffer_read_prefetch(compr->buf, buf,
+					count * WM_ADSP_DATA_WORD_SIZE);
+		if (nbytes < 0) {
+			adsp_err(dsp, "Failed to copy prefetch to user: %d\n",
+				 nbytes);
+			return nbytes;
+		}
+
+		count -= nbytes / WM_ADSP_DATA_WORD_SIZE;
+		ntotal += nbytes;
+	}
+
+	while (count > 0) {
 		nwords = wm_adsp_buffer_capture_block(compr, count);
 		if (nwords < 0) {
 			adsp_err(dsp, "Failed to capture block: %d\n", nwords);
 			return nwords;
 		}
+		if (!nwords)
+			break;
 
 		nbytes = nwords * WM_ADSP_DATA_WORD_SIZE;
 
@@ -4929,10 +6640,12 @@ static int wm_adsp_compr_read(struct wm_adsp_compr *compr,
 
 		count -= nwords;
 		ntotal += nbytes;
-	} while (nwords > 0 && count > 0);
+	}
 
 	compr->copied_total += ntotal;
 
+	wm_adsp_compr_account_latency(compr);
+
 	return ntotal;
 }
 
@@ -5003,6 +6716,8 @@ irqreturn_t wm_adsp2_bus_error(struct wm_adsp *dsp)
 	if (val & ADSP2_WDT_TIMEOUT_STS_MASK) {
 		adsp_err(dsp, "watchdog timeout error\n");
 		wm_adsp_stop_watchdog(dsp);
+		wm_adsp_queue_snapshot(dsp);
+		wm_adsp_schedule_recovery(dsp);
 	}
 
 	if (val & (ADSP2_SLAVE_ERR_MASK | ADSP2_REGION_LOCK_ERR_MASK)) {
@@ -5037,6 +6752,9 @@ irqreturn_t wm_adsp2_bus_error(struct wm_adsp *dsp)
 		adsp_err(dsp, "pmem error address = 0x%x\n",
 			 (val & ADSP2_PMEM_ERR_ADDR_MASK) >>
 			 ADSP2_PMEM_ERR_ADDR_SHIFT);
+
+		wm_adsp_queue_snapshot(dsp);
+		wm_adsp_schedule_recovery(dsp);
 	}
 
 	regmap_update_bits(regmap, dsp->base + ADSP2_LOCK_REGION_CTRL,
@@ -5089,6 +6807,9 @@ irqreturn_t wm_halo_bus_error(struct wm_adsp *dsp)
 	/* Ensure we log the fault even if we fail to read the fault info */
 	adsp_warn(dsp, "MPU FAULT\n");
 
+	wm_adsp_queue_snapshot(dsp);
+	wm_adsp_schedule_recovery(dsp);
+
 	ret = regmap_read(regmap, dsp->base_sysinfo + HALO_AHBM_WINDOW_DEBUG_1,
 			  &ahb_sts);
 	if (ret) {
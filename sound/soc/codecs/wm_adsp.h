@@ -46,6 +46,38 @@ struct wm_adsp_region {
 	unsigned int base;
 };
 
+enum wm_adsp_bus_stat {
+	WM_ADSP_BUS_WMFW,
+	WM_ADSP_BUS_COEFF,
+	WM_ADSP_BUS_STREAM,
+	WM_ADSP_BUS_SETUP,
+	WM_ADSP_BUS_NUM_STATS,
+};
+
+/* Control bus traffic, ops is loads or capture blocks as appropriate */
+struct wm_adsp_bus_stats {
+	unsigned int ops;
+	unsigned int transactions;
+	u64 bytes;
+};
+
+/* Delay from a compressed buffer IRQ until its data reaches the reader */
+struct wm_adsp_latency_stats {
+	unsigned int count;
+	u32 last_us;
+	u32 min_us;
+	u32 max_us;
+	u64 total_us;
+};
+
+/* Host resident copy of the last firmware file loaded */
+struct wm_adsp_fw_cache {
+	char *name;
+	const struct firmware *fw;
+};
+
+struct wm_adsp_reg_seq;
+
 struct wm_adsp_alg_region {
 	struct list_head list;
 	unsigned int alg;
@@ -77,6 +109,13 @@ struct wm_adsp_fw_defs {
 	int num_caps;
 	struct wm_adsp_fw_caps *caps;
 	bool voice_trigger;
+	bool sample_count;
+};
+
+struct wm_adsp_chunk_hash {
+	unsigned int reg;
+	unsigned int len;
+	u64 hash;
 };
 
 struct wm_adsp {
@@ -108,6 +147,12 @@ struct wm_adsp {
 	int fw;
 	int fw_ver;
 
+	/* Memory sizes in words from the wmfw header */
+	unsigned int xm_words;
+	unsigned int ym_words;
+	unsigned int pm_words;
+	unsigned int zm_words;
+
 	bool preloaded;
 	bool booted;
 	bool running;
@@ -120,6 +165,9 @@ struct wm_adsp {
 	struct list_head ctl_list;
 
 	struct work_struct boot_work;
+	struct work_struct recovery_work;
+	struct work_struct snapshot_work;
+	bool snapshot_pending;
 
 	int buf_num;
 	struct wm_adsp_compr *compr[WM_ADSP_MAX_CHANNEL_PER_DSP];
@@ -129,6 +177,8 @@ struct wm_adsp {
 
 	unsigned int lock_regions;
 	bool unlock_all;
+	struct wm_adsp_reg_seq *mpu_seq;
+	struct wm_adsp_reg_seq *arb_seq;
 
 	unsigned int n_rx_channels;
 	unsigned int n_tx_channels;
@@ -137,6 +187,41 @@ struct wm_adsp {
 	u8 *rx_rate_cache;
 	u8 *tx_rate_cache;
 
+	struct wm_adsp_bus_stats bus_stats[WM_ADSP_BUS_NUM_STATS];
+
+	struct wm_adsp_fw_cache wmfw_cache;
+	struct wm_adsp_fw_cache bin_cache;
+	bool recovering;
+	u32 recovery_count;
+	u32 recovery_failures;
+	u32 recovery_time_us;
+	u32 recovery_burst;
+	ktime_t recovery_last;
+
+	struct delayed_work idle_work;
+	unsigned int residency_ms;
+	bool resident;
+	u32 boot_time_us;
+	u32 residency_hits;
+	u32 residency_misses;
+	u64 residency_saved_us;
+
+	bool delta_switch;
+	struct wm_adsp_chunk_hash *pm_hashes;
+	int n_pm_hashes;
+	unsigned int delta_fw_id;
+	unsigned int delta_fw_id_version;
+	atomic_t power_lost;
+	u64 delta_bytes_skipped;
+	u64 delta_bytes_written;
+
+	unsigned int prefetch_bytes;
+	struct work_struct prefetch_work;
+	u32 prefetch_triggers;
+	u64 prefetch_bytes_served;
+
+	struct wm_adsp_latency_stats compr_latency;
+
 #ifdef CONFIG_DEBUG_FS
 	struct dentry *debugfs_root;
 	char *wmfw_file_name;
@@ -196,6 +281,7 @@ void wm_adsp2_remove(struct wm_adsp *dsp);
 int wm_adsp2_codec_probe(struct wm_adsp *dsp, struct snd_soc_codec *codec);
 int wm_adsp2_codec_remove(struct wm_adsp *dsp, struct snd_soc_codec *codec);
 int wm_halo_init(struct wm_adsp *dsp, struct mutex *rate_lock);
+int wm_halo_set_rates(struct wm_adsp *dsp, unsigned int rate);
 int wm_adsp1_event(struct snd_soc_dapm_widget *w,
 		   struct snd_kcontrol *kcontrol, int event);
 
@@ -206,6 +292,10 @@ int wm_adsp2_early_event(struct snd_soc_dapm_widget *w,
 int wm_adsp2_lock(struct wm_adsp *adsp, unsigned int regions);
 irqreturn_t wm_adsp2_bus_error(struct wm_adsp *adsp);
 irqreturn_t wm_halo_bus_error(struct wm_adsp *dsp);
+void wm_adsp_queue_snapshot(struct wm_adsp *dsp);
+void wm_adsp_power_lost(struct wm_adsp *dsp);
+int wm_adsp_read_alg_xm(struct wm_adsp *dsp, unsigned int alg,
+			unsigned int offset, u32 *val);
 
 int wm_adsp2_event(struct snd_soc_dapm_widget *w,
 		   struct snd_kcontrol *kcontrol, int event);
@@ -0,0 +1,220 @@
+/*
+ * extcon_madera_test.c -- Host tests for Madera jack detection
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * extcon-madera.c is built into the test so its static helpers can be
+ * reached. The codec registers are a cached fake register map and every bus
+ * transaction is counted.
+ */
+
+#include "extcon-madera.c"
+
+#include "kunit.h"
+
+#define EXTCON_MADERA_TEST_BASE		0x460
+#define EXTCON_MADERA_TEST_NREGS	0x40
+
+static const struct {
+	const char *name;
+	const struct madera_hp_tuning *tuning;
+	int n_tunings;
+} extcon_madera_test_tunings[] = {
+	{ "cs47l35", cs47l35_hp_tuning, ARRAY_SIZE(cs47l35_hp_tuning) },
+	{ "cs47l85", cs47l85_hp_tuning, ARRAY_SIZE(cs47l85_hp_tuning) },
+	{ "cs47l90", cs47l90_hp_tuning, ARRAY_SIZE(cs47l90_hp_tuning) },
+};
+
+struct extcon_madera_test {
+	struct device dev;
+	struct madera madera;
+	struct madera_extcon info;
+	struct regmap *ref;
+};
+
+static struct regmap *extcon_madera_test_regmap(void)
+{
+	/* 16-bit control registers behind a register cache */
+	struct regmap *regmap = regmap_test_init(2, 1, true);
+
+	if (!regmap)
+		return NULL;
+
+	if (regmap_test_add_window(regmap, EXTCON_MADERA_TEST_BASE,
+				   EXTCON_MADERA_TEST_NREGS)) {
+		regmap_test_exit(regmap);
+		return NULL;
+	}
+
+	return regmap;
+}
+
+static int extcon_madera_test_init(struct kunit *test)
+{
+	struct extcon_madera_test *priv;
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	test->priv = priv;
+
+	priv->dev.name = "extcon_madera_test";
+	priv->madera.dev = &priv->dev;
+	priv->info.dev = &priv->dev;
+	priv->info.madera = &priv->madera;
+
+	priv->madera.regmap = extcon_madera_test_regmap();
+	if (!priv->madera.regmap)
+		return -ENOMEM;
+
+	/* Receives every patch in full, to compare against */
+	priv->ref = extcon_madera_test_regmap();
+	if (!priv->ref)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void extcon_madera_test_exit(struct kunit *test)
+{
+	struct extcon_madera_test *priv = test->priv;
+
+	if (!priv)
+		return;
+
+	regmap_test_exit(priv->madera.regmap);
+	regmap_test_exit(priv->ref);
+	kfree(priv);
+}
+
+/* Put the registers back to reset, then apply a whole tuning */
+static void extcon_madera_test_reset(struct kunit *test, struct regmap *regmap,
+				     const struct madera_hp_tuning *tuning)
+{
+	int i;
+
+	for (i = 0; i < EXTCON_MADERA_TEST_NREGS; i++)
+		regmap_test_poke(regmap, EXTCON_MADERA_TEST_BASE + i, 0);
+
+	if (tuning)
+		KUNIT_ASSERT_EQ(test, 0,
+				regmap_multi_reg_write(regmap, tuning->patch,
+						       tuning->patch_len));
+}
+
+static void extcon_madera_test_delta_one(struct kunit *test, const char *name,
+					 const struct madera_hp_tuning *from,
+					 const struct madera_hp_tuning *to)
+{
+	struct extcon_madera_test *priv = test->priv;
+	struct regmap *regmap = priv->madera.regmap;
+	unsigned int reg;
+	int i;
+
+	extcon_madera_test_reset(test, regmap, from);
+	extcon_madera_test_reset(test, priv->ref, from);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_tune_headphone_patch(&priv->info, to->patch,
+						    to->patch_len));
+	KUNIT_ASSERT_EQ(test, 0,
+			regmap_multi_reg_write(priv->ref, to->patch,
+					       to->patch_len));
+
+	for (i = 0; i < EXTCON_MADERA_TEST_NREGS; i++) {
+		reg = EXTCON_MADERA_TEST_BASE + i;
+
+		KUNIT_EXPECT_EQ_MSG(test, regmap_test_peek(priv->ref, reg),
+				    regmap_test_peek(regmap, reg),
+				    "%s: reg 0x%x", name, reg);
+	}
+}
+
+/*
+ * Applying only the differences from the previous tuning must leave the
+ * registers exactly as writing the whole patch would, for every move
+ * between the tunings of each codec, starting from the reset state or from
+ * any tuning
+ */
+static void extcon_madera_test_hp_tuning_delta(struct kunit *test)
+{
+	const struct madera_hp_tuning *tuning;
+	int i, from, to, n;
+
+	for (i = 0; i < ARRAY_SIZE(extcon_madera_test_tunings); i++) {
+		tuning = extcon_madera_test_tunings[i].tuning;
+		n = extcon_madera_test_tunings[i].n_tunings;
+
+		for (to = 0; to < n; to++) {
+			extcon_madera_test_delta_one(test,
+					extcon_madera_test_tunings[i].name,
+					NULL, &tuning[to]);
+
+			for (from = 0; from < n; from++)
+				extcon_madera_test_delta_one(test,
+					extcon_madera_test_tunings[i].name,
+					&tuning[from], &tuning[to]);
+		}
+	}
+}
+
+/*
+ * The cs47l35 tunings are runs of consecutive registers, so the changes are
+ * queued as raw transfers and completed once. Re-applying the tuning the
+ * codec already holds writes nothing.
+ */
+static void extcon_madera_test_hp_tuning_async(struct kunit *test)
+{
+	struct extcon_madera_test *priv = test->priv;
+	struct regmap *regmap = priv->madera.regmap;
+	const struct madera_hp_tuning *low = &cs47l35_hp_tuning[0];
+	const struct madera_hp_tuning *normal = &cs47l35_hp_tuning[1];
+
+	KUNIT_ASSERT_EQ(test, 0, regmap_multi_reg_write(regmap, low->patch,
+							 low->patch_len));
+
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_tune_headphone_patch(&priv->info, normal->patch,
+						    normal->patch_len));
+
+	KUNIT_EXPECT_GT(test, regmap->writes, 0U);
+	KUNIT_EXPECT_EQ(test, regmap->writes, regmap->async_writes);
+	KUNIT_EXPECT_EQ(test, 1U, regmap->async_completes);
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+
+	/* Fewer transfers, and fewer bytes, than the full patch */
+	KUNIT_EXPECT_LT(test, regmap->writes, (unsigned int)normal->patch_len);
+	KUNIT_EXPECT_LT(test, regmap->bytes_written,
+			normal->patch_len * sizeof(u16));
+
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_tune_headphone_patch(&priv->info, normal->patch,
+						    normal->patch_len));
+
+	KUNIT_EXPECT_EQ(test, 0U, regmap->writes);
+	KUNIT_EXPECT_EQ(test, 0U, regmap->async_completes);
+}
+
+static struct kunit_case extcon_madera_test_cases[] = {
+	KUNIT_CASE(extcon_madera_test_hp_tuning_delta),
+	KUNIT_CASE(extcon_madera_test_hp_tuning_async),
+	{}
+};
+
+static struct kunit_suite extcon_madera_test_suite = {
+	.name = "extcon-madera",
+	.init = extcon_madera_test_init,
+	.exit = extcon_madera_test_exit,
+	.test_cases = extcon_madera_test_cases,
+};
+
+kunit_test_suite(extcon_madera_test_suite);
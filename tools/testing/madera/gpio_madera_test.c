@@ -0,0 +1,250 @@
+/*
+ * gpio_madera_test.c -- Host tests for Madera GPIOs
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * gpio-madera.c is built into the test so its static helpers can be
+ * reached. The codec registers are a cached fake register map and every bus
+ * transaction is counted.
+ */
+
+#include "gpio-madera.c"
+
+#include "kunit.h"
+
+#define GPIO_MADERA_TEST_CTRL_2		0xa5a5
+#define GPIO_MADERA_TEST_OUT \
+	(GPIO_MADERA_TEST_CTRL_2 & ~MADERA_GP1_DIR_MASK)
+
+struct gpio_madera_test {
+	struct device dev;
+	struct madera madera;
+	struct madera_gpio gpio;
+};
+
+static int gpio_madera_test_init(struct kunit *test)
+{
+	struct gpio_madera_test *priv;
+	struct regmap *regmap;
+	int i, ret;
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	test->priv = priv;
+
+	priv->dev.name = "gpio_madera_test";
+	priv->madera.dev = &priv->dev;
+	priv->madera.type = CS47L85;
+
+	/* 16-bit control registers behind a register cache */
+	regmap = regmap_test_init(2, 1, true);
+	if (!regmap)
+		return -ENOMEM;
+
+	priv->madera.regmap = regmap;
+
+	ret = regmap_test_add_window(regmap, MADERA_GPIO1_CTRL_1,
+				     2 * CS47L85_NUM_GPIOS);
+	if (ret)
+		return ret;
+
+	/* Outputs, driven low, with other settings in CTRL_2 to preserve */
+	for (i = 0; i < CS47L85_NUM_GPIOS; i++)
+		regmap_test_poke(regmap, MADERA_GPIO1_CTRL_2 + (2 * i),
+				 GPIO_MADERA_TEST_OUT);
+
+	priv->gpio.madera = &priv->madera;
+	mutex_init(&priv->gpio.lock);
+	priv->gpio.gpio_chip = template_chip;
+	priv->gpio.gpio_chip.parent = &priv->dev;
+	priv->gpio.gpio_chip.ngpio = CS47L85_NUM_GPIOS;
+
+	return devm_gpiochip_add_data(&priv->dev, &priv->gpio.gpio_chip,
+				      &priv->gpio);
+}
+
+static void gpio_madera_test_exit(struct kunit *test)
+{
+	struct gpio_madera_test *priv = test->priv;
+
+	if (!priv)
+		return;
+
+	regmap_test_exit(priv->madera.regmap);
+	kfree(priv);
+}
+
+static unsigned int gpio_madera_test_reg(struct gpio_madera_test *priv,
+					 unsigned int reg, unsigned int offset)
+{
+	return regmap_test_peek(priv->madera.regmap, reg + (2 * offset));
+}
+
+/* The levels of adjacent pins change together in one bulk write */
+static void gpio_madera_test_set_multiple_run(struct kunit *test)
+{
+	struct gpio_madera_test *priv = test->priv;
+	struct gpio_chip *chip = &priv->gpio.gpio_chip;
+	struct regmap *regmap = priv->madera.regmap;
+	DECLARE_BITMAP(mask, CS47L85_NUM_GPIOS) = { 0 };
+	DECLARE_BITMAP(bits, CS47L85_NUM_GPIOS) = { 0 };
+	int i;
+
+	for (i = 2; i <= 5; i++)
+		set_bit(i, mask);
+	set_bit(2, bits);
+	set_bit(4, bits);
+
+	regmap_test_reset_stats(regmap);
+
+	chip->set_multiple(chip, mask, bits);
+
+	/* One transfer covering CTRL_1 of pin 2 up to CTRL_1 of pin 5 */
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, 1U, regmap->writes);
+	KUNIT_EXPECT_EQ(test, (size_t)(2 * 3 + 1) * 2, regmap->bytes_written);
+
+	for (i = 0; i < CS47L85_NUM_GPIOS; i++) {
+		KUNIT_EXPECT_EQ_MSG(test, i == 2 || i == 4 ? MADERA_GP1_LVL : 0,
+				    gpio_madera_test_reg(priv,
+							 MADERA_GPIO1_CTRL_1,
+							 i),
+				    "GPIO%d", i + 1);
+		KUNIT_EXPECT_EQ_MSG(test, GPIO_MADERA_TEST_OUT,
+				    gpio_madera_test_reg(priv,
+							 MADERA_GPIO1_CTRL_2,
+							 i),
+				    "GPIO%d", i + 1);
+	}
+}
+
+/*
+ * Pins separated by a gap are written separately, a lone pin only has its
+ * level updated, and the pins in the gap are never rewritten
+ */
+static void gpio_madera_test_set_multiple_split(struct kunit *test)
+{
+	struct gpio_madera_test *priv = test->priv;
+	struct gpio_chip *chip = &priv->gpio.gpio_chip;
+	struct regmap *regmap = priv->madera.regmap;
+	DECLARE_BITMAP(mask, CS47L85_NUM_GPIOS) = { 0 };
+	DECLARE_BITMAP(bits, CS47L85_NUM_GPIOS) = { 0 };
+
+	set_bit(0, mask);
+	set_bit(1, mask);
+	set_bit(5, mask);
+	set_bit(30, mask);
+	memcpy(bits, mask, sizeof(bits));
+
+	regmap_test_reset_stats(regmap);
+
+	chip->set_multiple(chip, mask, bits);
+
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, 3U, regmap->writes);
+	KUNIT_EXPECT_EQ(test, (size_t)(3 + 1 + 1) * 2, regmap->bytes_written);
+
+	KUNIT_EXPECT_EQ(test, MADERA_GP1_LVL,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_1, 1));
+	KUNIT_EXPECT_EQ(test, 0,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_1, 3));
+	KUNIT_EXPECT_EQ(test, MADERA_GP1_LVL,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_1, 5));
+	KUNIT_EXPECT_EQ(test, MADERA_GP1_LVL,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_1, 30));
+
+	/* Setting the levels the pins already have touches nothing */
+	regmap_test_reset_stats(regmap);
+
+	clear_bit(0, mask);
+	clear_bit(1, mask);
+
+	chip->set_multiple(chip, mask, bits);
+
+	KUNIT_EXPECT_EQ(test, 0U, regmap->writes);
+}
+
+/*
+ * Reading the levels takes one transfer per run of nearby pins, even when
+ * the registers have to come from the device rather than the cache
+ */
+static void gpio_madera_test_get_multiple(struct kunit *test)
+{
+	struct gpio_madera_test *priv = test->priv;
+	struct gpio_chip *chip = &priv->gpio.gpio_chip;
+	struct regmap *regmap = priv->madera.regmap;
+	DECLARE_BITMAP(mask, CS47L85_NUM_GPIOS) = { 0 };
+	DECLARE_BITMAP(bits, CS47L85_NUM_GPIOS) = { 0 };
+
+	regmap->cache = false;
+
+	regmap_test_poke(regmap, MADERA_GPIO1_CTRL_1 + (2 * 4),
+			 MADERA_GP1_LVL);
+	regmap_test_poke(regmap, MADERA_GPIO1_CTRL_1 + (2 * 20),
+			 MADERA_GP1_LVL);
+	set_bit(0, bits);
+
+	set_bit(0, mask);
+	set_bit(4, mask);
+	set_bit(20, mask);
+
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0, chip->get_multiple(chip, mask, bits));
+
+	/* GPIO1 and GPIO5 in one run, GPIO21 alone */
+	KUNIT_EXPECT_EQ(test, 2U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, (size_t)(2 * 5 + 2) * 2, regmap->bytes_read);
+
+	KUNIT_EXPECT_FALSE(test, test_bit(0, bits));
+	KUNIT_EXPECT_TRUE(test, test_bit(4, bits));
+	KUNIT_EXPECT_TRUE(test, test_bit(20, bits));
+}
+
+/* The level and the direction are set with one write, level first */
+static void gpio_madera_test_direction_output(struct kunit *test)
+{
+	struct gpio_madera_test *priv = test->priv;
+	struct gpio_chip *chip = &priv->gpio.gpio_chip;
+	struct regmap *regmap = priv->madera.regmap;
+
+	regmap_test_poke(regmap, MADERA_GPIO1_CTRL_2 + (2 * 7),
+			 GPIO_MADERA_TEST_CTRL_2 | MADERA_GP1_DIR);
+
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0, chip->direction_output(chip, 7, 1));
+
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, 1U, regmap->writes);
+	KUNIT_EXPECT_EQ(test, (size_t)2 * 2, regmap->bytes_written);
+
+	KUNIT_EXPECT_EQ(test, MADERA_GP1_LVL,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_1, 7));
+	KUNIT_EXPECT_EQ(test, GPIO_MADERA_TEST_OUT,
+			gpio_madera_test_reg(priv, MADERA_GPIO1_CTRL_2, 7));
+	KUNIT_EXPECT_EQ(test, 0, chip->get_direction(chip, 7));
+}
+
+static struct kunit_case gpio_madera_test_cases[] = {
+	KUNIT_CASE(gpio_madera_test_set_multiple_run),
+	KUNIT_CASE(gpio_madera_test_set_multiple_split),
+	KUNIT_CASE(gpio_madera_test_get_multiple),
+	KUNIT_CASE(gpio_madera_test_direction_output),
+	{}
+};
+
+static struct kunit_suite gpio_madera_test_suite = {
+	.name = "gpio-madera",
+	.init = gpio_madera_test_init,
+	.exit = gpio_madera_test_exit,
+	.test_cases = gpio_madera_test_cases,
+};
+
+kunit_test_suite(gpio_madera_test_suite);
@@ -0,0 +1,289 @@
+/*
+ * madera_test.c -- Host tests for Madera class codecs common support
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * madera.c is built into the test so its static helpers can be reached.
+ * The codec registers are a cached fake register map and every bus
+ * transaction is counted.
+ */
+
+#include "madera.c"
+
+#include "kunit.h"
+
+static const unsigned int madera_test_frefs[] = {
+	32000, 32768, 44100, 48000, 128000, 256000, 512000, 768000,
+	1024000, 1411200, 1536000, 2048000, 2822400, 3072000, 6144000,
+	11289600, 12000000, 12288000, 13000000, 19200000, 24576000,
+	26000000, 27000000,
+};
+
+static const unsigned int madera_test_fouts[] = {
+	90316800, 98304000,
+};
+
+static const struct {
+	enum madera_type type;
+	unsigned int rev;
+} madera_test_devices[] = {
+	{ CS47L35, 0 },
+	{ CS47L35, 1 },
+	{ CS47L85, 0 },
+	{ WM1840, 0 },
+	{ CS47L90, 0 },
+};
+
+/* The rest of the MFD and the SLIMbus support are not part of the test */
+int madera_request_irq(struct madera *madera, int irq, const char *name,
+		       irq_handler_t handler, void *data)
+{
+	return -ENXIO;
+}
+
+void madera_free_irq(struct madera *madera, int irq, void *data)
+{
+}
+
+int madera_irq_read_status(struct madera *madera, unsigned int reg,
+			   unsigned int *val)
+{
+	return regmap_read(madera->regmap, reg, val);
+}
+
+int madera_get_num_micbias(struct madera *madera, unsigned int *n_micbiases,
+			   unsigned int *n_child_micbiases)
+{
+	*n_micbiases = 0;
+	*n_child_micbiases = 0;
+
+	return -ENODEV;
+}
+
+int madera_set_channel_map(struct snd_soc_dai *dai,
+			   unsigned int tx_num, unsigned int *tx_slot,
+			   unsigned int rx_num, unsigned int *rx_slot)
+{
+	return -ENOTSUPP;
+}
+
+int madera_get_channel_map(struct snd_soc_dai *dai,
+			   unsigned int *tx_num, unsigned int *tx_slot,
+			   unsigned int *rx_num, unsigned int *rx_slot)
+{
+	return -ENOTSUPP;
+}
+
+struct madera_test {
+	struct device dev;
+	struct madera madera;
+	struct madera_fll fll;
+};
+
+static int madera_test_init(struct kunit *test)
+{
+	struct madera_test *priv;
+	int ret;
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	test->priv = priv;
+
+	priv->dev.name = "madera_test";
+	priv->madera.dev = &priv->dev;
+	priv->madera.type = CS47L90;
+
+	/* 16-bit control registers behind a register cache */
+	priv->madera.regmap = regmap_test_init(2, 1, true);
+	if (!priv->madera.regmap)
+		return -ENOMEM;
+
+	ret = regmap_test_add_window(priv->madera.regmap,
+				     MADERA_FLL1_CONTROL_1 - 1, 0x40);
+	if (ret)
+		return ret;
+
+	ret = regmap_test_add_window(priv->madera.regmap,
+				     MADERA_IRQ1_RAW_STATUS_2, 1);
+	if (ret)
+		return ret;
+
+	/* The FLL locks as soon as it is enabled */
+	regmap_test_poke(priv->madera.regmap, MADERA_IRQ1_RAW_STATUS_2,
+			 MADERA_FLL1_LOCK_STS1);
+
+	return madera_init_fll(&priv->madera, 1, MADERA_FLL1_CONTROL_1 - 1,
+			       &priv->fll);
+}
+
+static void madera_test_exit(struct kunit *test)
+{
+	struct madera_test *priv = test->priv;
+
+	if (!priv)
+		return;
+
+	regmap_test_exit(priv->madera.regmap);
+	kfree(priv);
+}
+
+static void madera_test_calc_fll_one(struct kunit *test,
+				     struct madera_fll *fll,
+				     unsigned int fref, bool sync)
+{
+	struct madera_fll_cfg cfg = { 0 };
+	u64 want, got, ratio;
+
+	KUNIT_ASSERT_EQ(test, 0, madera_calc_fll(fll, &cfg, fref, sync));
+
+	/* FRATIO holds a power of two for the sync loop */
+	if (sync)
+		ratio = 1 << cfg.fratio;
+	else
+		ratio = cfg.fratio + 1;
+
+	ratio *= fref >> cfg.refdiv;
+
+	KUNIT_EXPECT_LE(test, cfg.refdiv, 3);
+	KUNIT_EXPECT_GE(test, cfg.n, 1);
+
+	if (!cfg.lambda) {
+		KUNIT_EXPECT_EQ(test, 0, cfg.theta);
+		KUNIT_EXPECT_EQ(test, (u64)fll->fout, cfg.n * ratio);
+		return;
+	}
+
+	KUNIT_EXPECT_LT(test, cfg.lambda, 1 << 16);
+	KUNIT_EXPECT_LT(test, cfg.theta, cfg.lambda);
+
+	/*
+	 * Fout = (N + THETA / LAMBDA) * FRATIO * Fref, allowing for the LSB
+	 * lost from each of THETA and LAMBDA when they are scaled to 16 bits
+	 */
+	want = (u64)fll->fout * cfg.lambda;
+	got = ((u64)cfg.n * cfg.lambda + cfg.theta) * ratio;
+
+	KUNIT_EXPECT_LE_MSG(test, max(want, got) - min(want, got), 2 * ratio,
+			    "fref=%u fout=%u sync=%d N=%d THETA=%d LAMBDA=%d",
+			    fref, fll->fout, sync, cfg.n, cfg.theta,
+			    cfg.lambda);
+}
+
+static void madera_test_calc_fll(struct kunit *test)
+{
+	struct madera_test *priv = test->priv;
+	struct madera_fll *fll = &priv->fll;
+	int i, j, k;
+
+	for (i = 0; i < ARRAY_SIZE(madera_test_devices); i++) {
+		priv->madera.type = madera_test_devices[i].type;
+		priv->madera.rev = madera_test_devices[i].rev;
+
+		for (j = 0; j < ARRAY_SIZE(madera_test_fouts); j++) {
+			fll->fout = madera_test_fouts[j];
+
+			for (k = 0; k < ARRAY_SIZE(madera_test_frefs); k++) {
+				madera_test_calc_fll_one(test, fll,
+							 madera_test_frefs[k],
+							 false);
+				madera_test_calc_fll_one(test, fll,
+							 madera_test_frefs[k],
+							 true);
+			}
+		}
+	}
+}
+
+static unsigned int madera_test_fll_reg(struct madera_test *priv,
+					unsigned int offs)
+{
+	return regmap_test_peek(priv->madera.regmap,
+				MADERA_FLL1_CONTROL_1 - 1 + offs);
+}
+
+static void madera_test_fll_change(struct kunit *test)
+{
+	struct madera_test *priv = test->priv;
+	struct madera_fll *fll = &priv->fll;
+	struct regmap *regmap = priv->madera.regmap;
+	struct madera_fll_cfg cfg = { 0 };
+
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_set_fll_refclk(fll, MADERA_FLL_SRC_MCLK1,
+					      24576000, 98304000));
+	KUNIT_EXPECT_TRUE(test, madera_test_fll_reg(priv,
+			  MADERA_FLL_CONTROL_1_OFFS) &
+			  MADERA_FLL1_ENA);
+
+	KUNIT_ASSERT_EQ(test, 0, madera_calc_fll(fll, &cfg, 24576000, false));
+	KUNIT_EXPECT_EQ(test, cfg.n, madera_test_fll_reg(priv,
+			MADERA_FLL_CONTROL_2_OFFS) & MADERA_FLL1_N_MASK);
+	KUNIT_EXPECT_EQ(test, cfg.theta, madera_test_fll_reg(priv,
+			MADERA_FLL_CONTROL_3_OFFS));
+	KUNIT_EXPECT_EQ(test, cfg.lambda, madera_test_fll_reg(priv,
+			MADERA_FLL_CONTROL_4_OFFS));
+
+	/*
+	 * Register state comes from the cache and only the lock is polled.
+	 * Settings the FLL already holds after reset are not rewritten.
+	 */
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, 6U, regmap->writes);
+
+	/* Setting the same clock again touches nothing */
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_set_fll_refclk(fll, MADERA_FLL_SRC_MCLK1,
+					      24576000, 98304000));
+	KUNIT_EXPECT_EQ(test, 0U, regmap->writes);
+
+	/*
+	 * Moving the running FLL to a new reference writes the divider and N
+	 * that changed, bracketed by the FREERUN and gain writes that keep
+	 * the output smooth across the switch
+	 */
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_set_fll_refclk(fll, MADERA_FLL_SRC_MCLK1,
+					      12288000, 98304000));
+	KUNIT_EXPECT_EQ(test, 5U, regmap->writes);
+	KUNIT_EXPECT_EQ(test, 4U, regmap->async_writes);
+
+	KUNIT_ASSERT_EQ(test, 0, madera_calc_fll(fll, &cfg, 12288000, false));
+	KUNIT_EXPECT_EQ(test, cfg.n, madera_test_fll_reg(priv,
+			MADERA_FLL_CONTROL_2_OFFS) & MADERA_FLL1_N_MASK);
+
+	/* Stopping it clears the enable and waits for the lock to drop */
+	regmap_test_poke(regmap, MADERA_IRQ1_RAW_STATUS_2, 0);
+
+	KUNIT_ASSERT_EQ(test, 0,
+			madera_set_fll_refclk(fll, MADERA_FLL_SRC_NONE, 0, 0));
+	KUNIT_EXPECT_FALSE(test, madera_test_fll_reg(priv,
+			   MADERA_FLL_CONTROL_1_OFFS) &
+			   MADERA_FLL1_ENA);
+}
+
+static struct kunit_case madera_test_cases[] = {
+	KUNIT_CASE(madera_test_calc_fll),
+	KUNIT_CASE(madera_test_fll_change),
+	{}
+};
+
+static struct kunit_suite madera_test_suite = {
+	.name = "madera",
+	.init = madera_test_init,
+	.exit = madera_test_exit,
+	.test_cases = madera_test_cases,
+};
+
+kunit_test_suite(madera_test_suite);
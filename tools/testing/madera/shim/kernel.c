@@ -0,0 +1,340 @@
+/*
+ * kernel.c -- Minimal kernel API for building Madera drivers on the host
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "kernel.h"
+
+/* Set to 7 to see debug messages from the drivers */
+int kernel_log_level = 3;
+
+ktime_t kernel_test_now;
+unsigned long jiffies;
+
+static struct workqueue_struct kernel_test_wq;
+struct workqueue_struct *system_wq = &kernel_test_wq;
+struct workqueue_struct *system_highpri_wq = &kernel_test_wq;
+struct workqueue_struct *system_unbound_wq = &kernel_test_wq;
+struct workqueue_struct *system_power_efficient_wq = &kernel_test_wq;
+struct workqueue_struct *system_freezable_wq = &kernel_test_wq;
+
+void kernel_log(int level, const struct device *dev, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (level > kernel_log_level)
+		return;
+
+	fprintf(stderr, "<%d> %s: ", level, dev_name(dev));
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+void *kmalloc(size_t size, gfp_t flags)
+{
+	/* Never zero sized, so a kmalloc(0) can still be told from failure */
+	void *p = malloc(size ? size : 1);
+
+	if (p && (flags & __GFP_ZERO))
+		memset(p, 0, size);
+
+	return p;
+}
+
+void kfree(const void *p)
+{
+	free((void *)p);
+}
+
+void *krealloc(const void *p, size_t size, gfp_t flags)
+{
+	return realloc((void *)p, size ? size : 1);
+}
+
+char *kasprintf(gfp_t flags, const char *fmt, ...)
+{
+	va_list ap;
+	char *p;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+
+	p = kmalloc(len + 1, flags);
+	if (!p)
+		return NULL;
+
+	va_start(ap, fmt);
+	vsnprintf(p, len + 1, fmt, ap);
+	va_end(ap);
+
+	return p;
+}
+
+unsigned long gcd(unsigned long a, unsigned long b)
+{
+	unsigned long r;
+
+	while (b) {
+		r = a % b;
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+int blocking_notifier_chain_register(struct blocking_notifier_head *nh,
+				     struct notifier_block *nb)
+{
+	nb->next = nh->head;
+	nh->head = nb;
+
+	return 0;
+}
+
+int blocking_notifier_chain_unregister(struct blocking_notifier_head *nh,
+				       struct notifier_block *nb)
+{
+	struct notifier_block **p;
+
+	for (p = &nh->head; *p; p = &(*p)->next) {
+		if (*p == nb) {
+			*p = nb->next;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+int blocking_notifier_call_chain(struct blocking_notifier_head *nh,
+				 unsigned long val, void *v)
+{
+	struct notifier_block *nb;
+	int ret = NOTIFY_DONE;
+
+	for (nb = nh->head; nb; nb = nb->next)
+		ret = nb->notifier_call(nb, val, v);
+
+	return ret;
+}
+
+void sort(void *base, size_t num, size_t size,
+	  int (*cmp)(const void *, const void *),
+	  void (*swap_fn)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+/* Same polynomial and bit order as the kernel's crc32_le() */
+u32 crc32_le(u32 crc, const void *p, size_t len)
+{
+	const u8 *data = p;
+	int i;
+
+	while (len--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+	}
+
+	return crc;
+}
+
+#define rol32(x, k)	(((x) << (k)) | ((x) >> (32 - (k))))
+
+#define __jhash_mix(a, b, c)			\
+{						\
+	a -= c;  a ^= rol32(c, 4);  c += b;	\
+	b -= a;  b ^= rol32(a, 6);  a += c;	\
+	c -= b;  c ^= rol32(b, 8);  b += a;	\
+	a -= c;  a ^= rol32(c, 16); c += b;	\
+	b -= a;  b ^= rol32(a, 19); a += c;	\
+	c -= b;  c ^= rol32(b, 4);  b += a;	\
+}
+
+#define __jhash_final(a, b, c)			\
+{						\
+	c ^= b; c -= rol32(b, 14);		\
+	a ^= c; a -= rol32(c, 11);		\
+	b ^= a; b -= rol32(a, 25);		\
+	c ^= b; c -= rol32(b, 16);		\
+	a ^= c; a -= rol32(c, 4);		\
+	b ^= a; b -= rol32(a, 14);		\
+	c ^= b; c -= rol32(b, 24);		\
+}
+
+/* Bob Jenkins' lookup3 hash, as implemented by the kernel's jhash() */
+u32 jhash(const void *key, u32 length, u32 initval)
+{
+	const u8 *k = key;
+	u32 a, b, c, w[3];
+
+	a = b = c = 0xdeadbeef + length + initval;
+
+	while (length > 12) {
+		memcpy(w, k, sizeof(w));
+		a += w[0];
+		b += w[1];
+		c += w[2];
+		__jhash_mix(a, b, c);
+		length -= 12;
+		k += 12;
+	}
+
+	switch (length) {
+	case 12: c += (u32)k[11] << 24;	/* fall through */
+	case 11: c += (u32)k[10] << 16;	/* fall through */
+	case 10: c += (u32)k[9] << 8;	/* fall through */
+	case 9:  c += k[8];		/* fall through */
+	case 8:  b += (u32)k[7] << 24;	/* fall through */
+	case 7:  b += (u32)k[6] << 16;	/* fall through */
+	case 6:  b += (u32)k[5] << 8;	/* fall through */
+	case 5:  b += k[4];		/* fall through */
+	case 4:  a += (u32)k[3] << 24;	/* fall through */
+	case 3:  a += (u32)k[2] << 16;	/* fall through */
+	case 2:  a += (u32)k[1] << 8;	/* fall through */
+	case 1:  a += k[0];
+		 __jhash_final(a, b, c);
+	case 0:
+		break;
+	}
+
+	return c;
+}
+
+int kstrtoint(const char *s, unsigned int base, int *res)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(s, &end, base);
+	if (errno || end == s || (*end && *end != '\n'))
+		return -EINVAL;
+
+	*res = val;
+
+	return 0;
+}
+
+int kstrtouint(const char *s, unsigned int base, unsigned int *res)
+{
+	int val, ret;
+
+	ret = kstrtoint(s, base, &val);
+	if (ret)
+		return ret;
+	if (val < 0)
+		return -EINVAL;
+
+	*res = val;
+
+	return 0;
+}
+
+int kstrtobool(const char *s, bool *res)
+{
+	switch (s[0]) {
+	case 'y': case 'Y': case '1':
+		*res = true;
+		return 0;
+	case 'n': case 'N': case '0':
+		*res = false;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+ssize_t simple_read_from_buffer(void __user *to, size_t count, loff_t *ppos,
+				const void *from, size_t available)
+{
+	loff_t pos = *ppos;
+
+	if (pos < 0)
+		return -EINVAL;
+	if (pos >= available || !count)
+		return 0;
+	if (count > available - pos)
+		count = available - pos;
+
+	memcpy(to, (const u8 *)from + pos, count);
+	*ppos = pos + count;
+
+	return count;
+}
+
+struct kernel_test_firmware {
+	struct kernel_test_firmware *next;
+	char *name;
+	struct firmware fw;
+};
+
+static struct kernel_test_firmware *kernel_test_firmwares;
+unsigned int kernel_test_firmware_requests;
+
+void kernel_test_add_firmware(const char *name, const void *data, size_t size)
+{
+	struct kernel_test_firmware *entry = kzalloc(sizeof(*entry),
+						     GFP_KERNEL);
+
+	entry->name = kstrdup(name, GFP_KERNEL);
+	entry->fw.data = kmemdup(data, size, GFP_KERNEL);
+	entry->fw.size = size;
+	entry->next = kernel_test_firmwares;
+	kernel_test_firmwares = entry;
+}
+
+void kernel_test_clear_firmware(void)
+{
+	struct kernel_test_firmware *entry;
+
+	while (kernel_test_firmwares) {
+		entry = kernel_test_firmwares;
+		kernel_test_firmwares = entry->next;
+		kfree(entry->name);
+		kfree(entry->fw.data);
+		kfree(entry);
+	}
+
+	kernel_test_firmware_requests = 0;
+}
+
+int request_firmware(const struct firmware **fw, const char *name,
+		     struct device *dev)
+{
+	struct kernel_test_firmware *entry;
+	struct firmware *copy;
+
+	kernel_test_firmware_requests++;
+
+	for (entry = kernel_test_firmwares; entry; entry = entry->next) {
+		if (strcmp(entry->name, name))
+			continue;
+
+		copy = kmemdup(&entry->fw, sizeof(*copy), GFP_KERNEL);
+		if (!copy)
+			return -ENOMEM;
+
+		*fw = copy;
+		return 0;
+	}
+
+	*fw = NULL;
+
+	return -ENOENT;
+}
+
+void release_firmware(const struct firmware *fw)
+{
+	kfree(fw);
+}
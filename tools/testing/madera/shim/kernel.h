@@ -0,0 +1,1110 @@
+/*
+ * kernel.h -- Minimal kernel API for building Madera drivers on the host
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Force included ahead of every driver source. Only what the drivers under
+ * test use is provided: locking, work and timers are no-ops run from a
+ * single thread, allocation goes to libc, and regmap is the fake in regmap.c.
+ */
+
+#ifndef MADERA_TEST_KERNEL_H
+#define MADERA_TEST_KERNEL_H
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Types */
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef long long s64;
+typedef u16 __le16;
+typedef u16 __be16;
+typedef u32 __le32;
+typedef u32 __be32;
+typedef u64 __le64;
+typedef u64 __be64;
+typedef u8 __u8;
+typedef u16 __u16;
+typedef u32 __u32;
+typedef u64 __u64;
+typedef s32 __s32;
+typedef unsigned int gfp_t;
+typedef s64 ktime_t;
+typedef unsigned short umode_t;
+typedef u64 dma_addr_t;
+
+#define __user
+#define __iomem
+#define __force
+#define __init
+#define __exit
+#define __maybe_unused		__attribute__((unused))
+#define __always_unused		__attribute__((unused))
+#define __packed		__attribute__((packed))
+#define __aligned(x)		__attribute__((aligned(x)))
+#define __printf(a, b)		__attribute__((format(printf, a, b)))
+#define ____cacheline_aligned	__aligned(64)
+#define fallthrough		do {} while (0)
+#define likely(x)		__builtin_expect(!!(x), 1)
+#define unlikely(x)		__builtin_expect(!!(x), 0)
+#define READ_ONCE(x)		(*(volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)	(*(volatile __typeof__(x) *)&(x) = (v))
+
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+#define MODULE_LICENSE(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_ALIAS(x)
+#define MODULE_DEVICE_TABLE(type, name)
+#define MODULE_PARM_DESC(name, desc)
+#define module_param(name, type, perm)
+#define module_platform_driver(drv)
+#define module_init(fn)
+#define module_exit(fn)
+#define THIS_MODULE		NULL
+
+/* Helpers */
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define BIT(n)			(1UL << (n))
+#define GENMASK(h, l)		(((~0U) << (l)) & (~0U >> (31 - (h))))
+#define BITS_PER_LONG		(sizeof(long) * 8)
+#define DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+#define DIV_ROUND_CLOSEST(x, d)	(((x) + ((d) / 2)) / (d))
+#define round_down(x, y)	((x) & ~((__typeof__(x))((y) - 1)))
+#define round_up(x, y) \
+	((((x) - 1) | ((__typeof__(x))((y) - 1))) + 1)
+#define ALIGN(x, a)		round_up(x, a)
+#define IS_ALIGNED(x, a)	(((x) & ((__typeof__(x))(a) - 1)) == 0)
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define max(a, b)		((a) > (b) ? (a) : (b))
+#define min_t(t, a, b)		((t)(a) < (t)(b) ? (t)(a) : (t)(b))
+#define max_t(t, a, b)		((t)(a) > (t)(b) ? (t)(a) : (t)(b))
+#define clamp(v, lo, hi)	min(max(v, lo), hi)
+#define clamp_val(v, lo, hi)	clamp(v, lo, hi)
+#define swap(a, b) \
+	do { __typeof__(a) __t = (a); (a) = (b); (b) = __t; } while (0)
+#define abs(x)			((x) < 0 ? -(x) : (x))
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+#define BUILD_BUG_ON(c)		((void)sizeof(char[1 - 2 * !!(c)]))
+#define WARN_ON(c)		({ int __c = !!(c); if (__c) \
+				   fprintf(stderr, "WARN_ON %s:%d\n", \
+					   __FILE__, __LINE__); __c; })
+#define WARN_ON_ONCE(c)		WARN_ON(c)
+#define WARN(c, ...)		WARN_ON(c)
+#define BUG_ON(c)		do { if (c) abort(); } while (0)
+#define IS_ENABLED(x)		0
+#define SZ_1K			0x400
+#define SZ_4K			0x1000
+#define SZ_32K			0x8000
+#define SZ_64K			0x10000
+#define U16_MAX			0xffff
+#define U32_MAX			0xffffffffU
+#define S32_MAX			INT_MAX
+#define NSEC_PER_USEC		1000L
+#define NSEC_PER_MSEC		1000000L
+#define USEC_PER_MSEC		1000L
+#define NSEC_PER_SEC		1000000000L
+#define HZ			100
+#define PAGE_SIZE		4096
+
+static inline int fls(unsigned int x)
+{
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+static inline unsigned long __ffs(unsigned long x)
+{
+	return __builtin_ctzl(x);
+}
+
+static inline int hweight32(u32 x)
+{
+	return __builtin_popcount(x);
+}
+
+#define BITS_TO_LONGS(n)	DIV_ROUND_UP(n, BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits) \
+	unsigned long name[BITS_TO_LONGS(bits)]
+
+static inline int test_bit(unsigned int nr, const unsigned long *addr)
+{
+	return (addr[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+static inline void set_bit(unsigned int nr, unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] |= BIT(nr % BITS_PER_LONG);
+}
+
+static inline void clear_bit(unsigned int nr, unsigned long *addr)
+{
+	addr[nr / BITS_PER_LONG] &= ~BIT(nr % BITS_PER_LONG);
+}
+
+static inline unsigned long find_next_bit(const unsigned long *addr,
+					  unsigned long size,
+					  unsigned long offset)
+{
+	for (; offset < size; offset++)
+		if (test_bit(offset, addr))
+			return offset;
+
+	return size;
+}
+
+static inline s32 sign_extend32(u32 value, int index)
+{
+	u8 shift = 31 - index;
+
+	return (s32)(value << shift) >> shift;
+}
+
+static inline u64 div_u64(u64 a, u32 b)
+{
+	return a / b;
+}
+
+static inline s64 div_s64(s64 a, s32 b)
+{
+	return a / b;
+}
+
+static inline u64 div64_u64(u64 a, u64 b)
+{
+	return a / b;
+}
+
+static inline s64 div64_s64(s64 a, s64 b)
+{
+	return a / b;
+}
+
+static inline u64 div_u64_rem(u64 a, u32 b, u32 *rem)
+{
+	*rem = a % b;
+	return a / b;
+}
+
+#define do_div(n, base) ({ u32 __rem = (n) % (base); (n) /= (base); __rem; })
+
+unsigned long gcd(unsigned long a, unsigned long b);
+
+/* Byte order, the host is assumed to be little endian */
+
+#define cpu_to_le16(x)		((u16)(x))
+#define le16_to_cpu(x)		((u16)(x))
+#define cpu_to_le32(x)		((u32)(x))
+#define le32_to_cpu(x)		((u32)(x))
+#define le64_to_cpu(x)		((u64)(x))
+#define cpu_to_le64(x)		((u64)(x))
+#define cpu_to_be16(x)		__builtin_bswap16(x)
+#define be16_to_cpu(x)		__builtin_bswap16(x)
+#define cpu_to_be32(x)		__builtin_bswap32(x)
+#define be32_to_cpu(x)		__builtin_bswap32(x)
+#define cpu_to_be64(x)		__builtin_bswap64(x)
+#define be64_to_cpu(x)		__builtin_bswap64(x)
+
+static inline u32 get_unaligned_be32(const void *p)
+{
+	u32 v;
+
+	memcpy(&v, p, sizeof(v));
+	return be32_to_cpu(v);
+}
+
+static inline void put_unaligned_be32(u32 val, void *p)
+{
+	val = cpu_to_be32(val);
+	memcpy(p, &val, sizeof(val));
+}
+
+static inline void cpu_to_be32_array(__be32 *dst, const u32 *src, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = cpu_to_be32(src[i]);
+}
+
+static inline void be32_to_cpu_array(u32 *dst, const __be32 *src, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = be32_to_cpu(src[i]);
+}
+
+/* Errors */
+
+#define MAX_ERRNO		4095
+#define ERESTARTSYS		512
+#define EPROBE_DEFER		517
+#define ENOTSUPP		524
+#define IS_ERR_VALUE(x)		((unsigned long)(void *)(x) >= \
+				 (unsigned long)-MAX_ERRNO)
+
+static inline void *ERR_PTR(long error)
+{
+	return (void *)error;
+}
+
+static inline long PTR_ERR(const void *ptr)
+{
+	return (long)ptr;
+}
+
+static inline bool IS_ERR(const void *ptr)
+{
+	return IS_ERR_VALUE((unsigned long)ptr);
+}
+
+static inline bool IS_ERR_OR_NULL(const void *ptr)
+{
+	return !ptr || IS_ERR(ptr);
+}
+
+static inline int PTR_ERR_OR_ZERO(const void *ptr)
+{
+	return IS_ERR(ptr) ? PTR_ERR(ptr) : 0;
+}
+
+/* Logging */
+
+struct device {
+	const char *name;
+	struct device *parent;
+	void *driver_data;
+	void *platform_data;
+	struct device_node *of_node;
+};
+
+extern int kernel_log_level;
+
+void kernel_log(int level, const struct device *dev, const char *fmt, ...)
+	__printf(3, 4);
+
+#define dev_crit(dev, ...)	kernel_log(2, dev, __VA_ARGS__)
+#define dev_err(dev, ...)	kernel_log(3, dev, __VA_ARGS__)
+#define dev_warn(dev, ...)	kernel_log(4, dev, __VA_ARGS__)
+#define dev_notice(dev, ...)	kernel_log(5, dev, __VA_ARGS__)
+#define dev_info(dev, ...)	kernel_log(6, dev, __VA_ARGS__)
+#define dev_dbg(dev, ...)	kernel_log(7, dev, __VA_ARGS__)
+#define dev_vdbg(dev, ...)	kernel_log(7, dev, __VA_ARGS__)
+#define dev_err_ratelimited	dev_err
+#define dev_warn_ratelimited	dev_warn
+#define dev_info_ratelimited	dev_info
+#define pr_err(...)		kernel_log(3, NULL, __VA_ARGS__)
+#define pr_warn(...)		kernel_log(4, NULL, __VA_ARGS__)
+#define pr_info(...)		kernel_log(6, NULL, __VA_ARGS__)
+#define pr_debug(...)		kernel_log(7, NULL, __VA_ARGS__)
+
+static inline const char *dev_name(const struct device *dev)
+{
+	return dev && dev->name ? dev->name : "test";
+}
+
+static inline void *dev_get_drvdata(const struct device *dev)
+{
+	return dev->driver_data;
+}
+
+static inline void dev_set_drvdata(struct device *dev, void *data)
+{
+	dev->driver_data = data;
+}
+
+static inline void *dev_get_platdata(const struct device *dev)
+{
+	return dev->platform_data;
+}
+
+/* Memory */
+
+#define GFP_KERNEL		0x1
+#define GFP_ATOMIC		0x2
+#define GFP_DMA			0x4
+#define __GFP_ZERO		0x8
+
+void *kmalloc(size_t size, gfp_t flags);
+void kfree(const void *p);
+void *krealloc(const void *p, size_t size, gfp_t flags);
+
+static inline void *kzalloc(size_t size, gfp_t flags)
+{
+	return kmalloc(size, flags | __GFP_ZERO);
+}
+
+static inline void *kmalloc_array(size_t n, size_t size, gfp_t flags)
+{
+	return kmalloc(n * size, flags);
+}
+
+static inline void *kcalloc(size_t n, size_t size, gfp_t flags)
+{
+	return kzalloc(n * size, flags);
+}
+
+static inline void *kmemdup(const void *src, size_t len, gfp_t flags)
+{
+	void *p = kmalloc(len, flags);
+
+	if (p)
+		memcpy(p, src, len);
+	return p;
+}
+
+static inline char *kstrdup(const char *s, gfp_t flags)
+{
+	return s ? kmemdup(s, strlen(s) + 1, flags) : NULL;
+}
+
+char *kasprintf(gfp_t flags, const char *fmt, ...) __printf(2, 3);
+
+#define vmalloc(size)		kmalloc(size, GFP_KERNEL)
+#define vzalloc(size)		kzalloc(size, GFP_KERNEL)
+#define vfree(p)		kfree(p)
+#define kvfree(p)		kfree(p)
+
+/* devm allocations are never released, which is fine for a test binary */
+#define devm_kzalloc(dev, size, flags)		kzalloc(size, flags)
+#define devm_kcalloc(dev, n, size, flags)	kcalloc(n, size, flags)
+#define devm_kmalloc(dev, size, flags)		kmalloc(size, flags)
+#define devm_kfree(dev, p)			kfree(p)
+#define devm_kmalloc_array(dev, n, size, flags) \
+	kmalloc_array(n, size, flags)
+#define devm_kstrdup(dev, s, flags)		kstrdup(s, flags)
+#define devm_kasprintf(dev, flags, ...)	kasprintf(flags, __VA_ARGS__)
+
+static inline unsigned long copy_to_user(void __user *to, const void *from,
+					 unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+static inline unsigned long copy_from_user(void *to, const void __user *from,
+					   unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+/* Lists */
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name)	{ &(name), &(name) }
+#define LIST_HEAD(name) \
+	struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void __list_add(struct list_head *new, struct list_head *prev,
+			      struct list_head *next)
+{
+	next->prev = new;
+	new->next = next;
+	new->prev = prev;
+	prev->next = new;
+}
+
+static inline void list_add(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head, head->next);
+}
+
+static inline void list_add_tail(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head->prev, head);
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->next->prev = entry->prev;
+	entry->prev->next = entry->next;
+	entry->next = NULL;
+	entry->prev = NULL;
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+	return head->next == head;
+}
+
+#define list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define list_first_entry(ptr, type, member) \
+	list_entry((ptr)->next, type, member)
+#define list_next_entry(pos, member) \
+	list_entry((pos)->member.next, __typeof__(*(pos)), member)
+#define list_for_each_entry(pos, head, member) \
+	for (pos = list_first_entry(head, __typeof__(*pos), member); \
+	     &pos->member != (head); pos = list_next_entry(pos, member))
+#define list_for_each_entry_safe(pos, n, head, member) \
+	for (pos = list_first_entry(head, __typeof__(*pos), member), \
+	     n = list_next_entry(pos, member); &pos->member != (head); \
+	     pos = n, n = list_next_entry(n, member))
+
+/* Atomics and locking, the tests are single threaded */
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i)		{ (i) }
+#define atomic_read(v)		READ_ONCE((v)->counter)
+#define atomic_set(v, i)	WRITE_ONCE((v)->counter, (i))
+#define atomic_inc(v)		((v)->counter++)
+#define atomic_dec(v)		((v)->counter--)
+#define atomic_add(i, v)	((v)->counter += (i))
+#define atomic_inc_return(v)	(++(v)->counter)
+#define atomic_dec_return(v)	(--(v)->counter)
+
+static inline int atomic_xchg(atomic_t *v, int i)
+{
+	int old = v->counter;
+
+	v->counter = i;
+	return old;
+}
+
+static inline int atomic_cmpxchg(atomic_t *v, int old, int new)
+{
+	int cur = v->counter;
+
+	if (cur == old)
+		v->counter = new;
+	return cur;
+}
+
+struct mutex {
+	int locked;
+};
+
+struct lock_class_key {
+	int dummy;
+};
+
+#define DEFINE_MUTEX(name)	struct mutex name = { 0 }
+#define mutex_init(m)		((m)->locked = 0)
+#define mutex_destroy(m)	do { } while (0)
+#define mutex_lock(m)		((m)->locked++)
+#define mutex_lock_nested(m, c)	mutex_lock(m)
+#define mutex_unlock(m)		((m)->locked--)
+#define mutex_is_locked(m)	((m)->locked != 0)
+#define lockdep_assert_held(m)	do { } while (0)
+
+static inline int mutex_trylock(struct mutex *m)
+{
+	m->locked++;
+	return 1;
+}
+
+typedef struct {
+	int locked;
+} spinlock_t;
+
+#define DEFINE_SPINLOCK(name)		spinlock_t name = { 0 }
+#define spin_lock_init(l)		((l)->locked = 0)
+#define spin_lock(l)			do { } while (0)
+#define spin_unlock(l)			do { } while (0)
+#define spin_lock_irq(l)		do { } while (0)
+#define spin_unlock_irq(l)		do { } while (0)
+#define spin_lock_irqsave(l, f)		((f) = 0)
+#define spin_unlock_irqrestore(l, f)	((void)(f))
+
+struct completion {
+	unsigned int done;
+};
+
+#define init_completion(c)	((c)->done = 0)
+#define reinit_completion(c)	((c)->done = 0)
+#define complete(c)		((c)->done++)
+#define complete_all(c)		((c)->done = UINT_MAX / 2)
+#define wait_for_completion(c)	do { } while (0)
+
+static inline bool try_wait_for_completion(struct completion *c)
+{
+	if (!c->done)
+		return false;
+
+	c->done--;
+	return true;
+}
+
+static inline unsigned long
+wait_for_completion_timeout(struct completion *c, unsigned long timeout)
+{
+	if (!c->done)
+		return 0;
+
+	c->done--;
+	return timeout ? timeout : 1;
+}
+
+/* Time, always reads zero unless a test moves it */
+
+extern ktime_t kernel_test_now;
+
+#define ktime_get()		(kernel_test_now)
+#define ktime_get_boottime()	(kernel_test_now)
+#define ktime_get_real()	(kernel_test_now)
+#define ktime_set(s, ns)	((ktime_t)(s) * NSEC_PER_SEC + (ns))
+#define ktime_add(a, b)		((a) + (b))
+#define ktime_sub(a, b)		((a) - (b))
+#define ktime_add_ms(k, ms)	((k) + (ktime_t)(ms) * NSEC_PER_MSEC)
+#define ktime_add_us(k, us)	((k) + (ktime_t)(us) * NSEC_PER_USEC)
+#define ktime_add_ns(k, ns)	((k) + (ns))
+#define ktime_to_ns(k)		((s64)(k))
+#define ktime_to_us(k)		((s64)(k) / NSEC_PER_USEC)
+#define ktime_to_ms(k)		((s64)(k) / NSEC_PER_MSEC)
+#define ktime_us_delta(a, b)	ktime_to_us((a) - (b))
+#define ktime_ms_delta(a, b)	ktime_to_ms((a) - (b))
+#define ns_to_ktime(ns)		((ktime_t)(ns))
+#define ms_to_ktime(ms)		((ktime_t)(ms) * NSEC_PER_MSEC)
+#define us_to_ktime(us)		((ktime_t)(us) * NSEC_PER_USEC)
+#define ktime_compare(a, b)	((a) < (b) ? -1 : (a) > (b))
+#define ktime_after(a, b)	((a) > (b))
+#define ktime_before(a, b)	((a) < (b))
+
+extern unsigned long jiffies;
+
+#define msecs_to_jiffies(ms)	((unsigned long)DIV_ROUND_UP(ms, 1000 / HZ))
+#define usecs_to_jiffies(us)	msecs_to_jiffies(DIV_ROUND_UP(us, 1000))
+#define jiffies_to_msecs(j)	((unsigned int)(j) * (1000 / HZ))
+#define time_after(a, b)	((long)((b) - (a)) < 0)
+#define time_before(a, b)	time_after(b, a)
+
+#define msleep(ms)		do { } while (0)
+#define usleep_range(lo, hi)	do { } while (0)
+#define udelay(us)		do { } while (0)
+#define mdelay(ms)		do { } while (0)
+#define ndelay(ns)		do { } while (0)
+
+/* Work, timers and threads, queued work is never run by itself */
+
+struct work_struct;
+typedef void (*work_func_t)(struct work_struct *work);
+
+struct work_struct {
+	work_func_t func;
+	bool pending;
+};
+
+struct delayed_work {
+	struct work_struct work;
+};
+
+struct workqueue_struct {
+	int dummy;
+};
+
+extern struct workqueue_struct *system_wq;
+extern struct workqueue_struct *system_highpri_wq;
+extern struct workqueue_struct *system_unbound_wq;
+extern struct workqueue_struct *system_power_efficient_wq;
+extern struct workqueue_struct *system_freezable_wq;
+
+#define INIT_WORK(w, f)		((w)->func = (f), (w)->pending = false)
+#define INIT_DELAYED_WORK(w, f)	INIT_WORK(&(w)->work, f)
+#define to_delayed_work(w)	container_of(w, struct delayed_work, work)
+
+static inline bool queue_work(struct workqueue_struct *wq,
+			      struct work_struct *work)
+{
+	bool was = work->pending;
+
+	work->pending = true;
+	return !was;
+}
+
+#define schedule_work(w)	queue_work(system_wq, w)
+#define queue_delayed_work(wq, w, d)	queue_work(wq, &(w)->work)
+#define mod_delayed_work(wq, w, d)	queue_work(wq, &(w)->work)
+#define schedule_delayed_work(w, d)	queue_work(system_wq, &(w)->work)
+
+static inline bool cancel_work_sync(struct work_struct *work)
+{
+	bool was = work->pending;
+
+	work->pending = false;
+	return was;
+}
+
+#define cancel_delayed_work_sync(w)	cancel_work_sync(&(w)->work)
+#define cancel_delayed_work(w)		cancel_work_sync(&(w)->work)
+#define flush_work(w)			do { } while (0)
+#define flush_delayed_work(w)		do { } while (0)
+#define flush_workqueue(wq)		do { } while (0)
+#define delayed_work_pending(w)		((w)->work.pending)
+#define work_pending(w)			((w)->pending)
+#define destroy_workqueue(wq)		do { } while (0)
+#define alloc_workqueue(...)		(system_wq)
+#define create_singlethread_workqueue(n)	(system_wq)
+
+/* Run a queued work item, as the workqueue would have */
+static inline void kernel_test_run_work(struct work_struct *work)
+{
+	if (work->pending) {
+		work->pending = false;
+		work->func(work);
+	}
+}
+
+enum hrtimer_restart {
+	HRTIMER_NORESTART,
+	HRTIMER_RESTART,
+};
+
+enum hrtimer_mode {
+	HRTIMER_MODE_ABS,
+	HRTIMER_MODE_REL,
+};
+
+#define CLOCK_MONOTONIC		1
+
+struct hrtimer {
+	enum hrtimer_restart (*function)(struct hrtimer *timer);
+	bool active;
+	ktime_t expires;
+};
+
+#define hrtimer_init(t, c, m)	((t)->active = false)
+#define hrtimer_start(t, k, m)	((t)->active = true, (t)->expires = (k))
+#define hrtimer_cancel(t)	((t)->active = false)
+#define hrtimer_try_to_cancel(t) ((t)->active = false)
+#define hrtimer_active(t)	((t)->active)
+#define hrtimer_forward_now(t, k) ((t)->expires += (k), 1)
+
+struct kthread_work;
+typedef void (*kthread_work_func_t)(struct kthread_work *work);
+
+struct kthread_work {
+	kthread_work_func_t func;
+	bool pending;
+};
+
+struct task_struct {
+	int dummy;
+};
+
+struct kthread_worker {
+	struct task_struct *task;
+};
+
+struct sched_param {
+	int sched_priority;
+};
+
+#define SCHED_FIFO		1
+#define MAX_RT_PRIO		100
+#define MAX_USER_RT_PRIO	100
+
+#define kthread_init_work(w, f)	((w)->func = (f), (w)->pending = false)
+#define kthread_queue_work(wk, w) ((w)->pending = true)
+#define kthread_flush_work(w)	do { } while (0)
+#define kthread_cancel_work_sync(w) ((w)->pending = false)
+#define kthread_destroy_worker(wk) kfree(wk)
+#define sched_setscheduler(t, p, s) ({ 0; })
+
+static inline struct kthread_worker *
+kthread_create_worker(unsigned int flags, const char *fmt, ...)
+{
+	struct kthread_worker *worker = kzalloc(sizeof(*worker), GFP_KERNEL);
+
+	return worker ? worker : ERR_PTR(-ENOMEM);
+}
+
+/* Notifiers */
+
+#define NOTIFY_DONE		0x0000
+#define NOTIFY_OK		0x0001
+
+struct notifier_block {
+	int (*notifier_call)(struct notifier_block *nb, unsigned long event,
+			     void *data);
+	struct notifier_block *next;
+	int priority;
+};
+
+struct blocking_notifier_head {
+	struct notifier_block *head;
+};
+
+#define BLOCKING_INIT_NOTIFIER_HEAD(h)	((h)->head = NULL)
+
+int blocking_notifier_chain_register(struct blocking_notifier_head *nh,
+				     struct notifier_block *nb);
+int blocking_notifier_chain_unregister(struct blocking_notifier_head *nh,
+				       struct notifier_block *nb);
+int blocking_notifier_call_chain(struct blocking_notifier_head *nh,
+				 unsigned long val, void *v);
+
+/* Library routines */
+
+void sort(void *base, size_t num, size_t size,
+	  int (*cmp)(const void *, const void *),
+	  void (*swap_fn)(void *, void *, int));
+void *bsearch(const void *key, const void *base, size_t num, size_t size,
+	      int (*cmp)(const void *key, const void *elt));
+u32 crc32_le(u32 crc, const void *p, size_t len);
+u32 jhash(const void *key, u32 length, u32 initval);
+int kstrtoint(const char *s, unsigned int base, int *res);
+int kstrtouint(const char *s, unsigned int base, unsigned int *res);
+int kstrtobool(const char *s, bool *res);
+
+#define strlcpy(d, s, n)	snprintf(d, n, "%s", s)
+#define scnprintf		snprintf
+
+/* Firmware, served from a table the tests fill in */
+
+struct firmware {
+	size_t size;
+	const u8 *data;
+};
+
+int request_firmware(const struct firmware **fw, const char *name,
+		     struct device *dev);
+void release_firmware(const struct firmware *fw);
+void kernel_test_add_firmware(const char *name, const void *data,
+			      size_t size);
+void kernel_test_clear_firmware(void);
+extern unsigned int kernel_test_firmware_requests;
+
+#define dev_coredumpv(dev, data, len, gfp)	vfree(data)
+
+/* Device tree, nothing is ever found */
+
+struct fwnode_handle {
+	int dummy;
+};
+
+struct device_node {
+	const char *name;
+	struct fwnode_handle fwnode;
+};
+
+struct property {
+	const char *name;
+};
+
+#define of_node_put(np)		do { } while (0)
+#define of_get_child_by_name(np, n)	((struct device_node *)NULL)
+#define of_get_next_child(np, prev)	((struct device_node *)NULL)
+#define of_get_property(np, n, l)	((const void *)NULL)
+#define of_property_read_bool(np, n)	false
+#define of_property_read_u32(np, n, v)	(-EINVAL)
+#define of_property_read_u32_index(np, n, i, v)	(-EINVAL)
+#define of_property_read_string(np, n, s)	(-EINVAL)
+#define of_property_count_u32_elems(np, n)	(-EINVAL)
+#define of_property_read_u32_array(np, n, v, c)	(-EINVAL)
+#define of_property_for_each_u32(np, n, prop, cur, u) \
+	for (prop = NULL, cur = NULL; cur; )
+#define for_each_child_of_node(parent, child) \
+	for (child = NULL; child; )
+#define fwnode_property_present(f, n)	false
+#define fwnode_property_read_u32(f, n, v)	({ -EINVAL; })
+#define fwnode_property_read_u32_array(f, n, v, c) (-EINVAL)
+#define device_property_read_u32(d, n, v)	(-EINVAL)
+#define device_property_read_bool(d, n)	false
+#define device_property_present(d, n)	false
+#define device_property_read_u32_array(d, n, v, c) ({ -EINVAL; })
+#define device_property_count_u32(d, n)	(-EINVAL)
+
+/* Runtime PM always succeeds */
+
+#define pm_runtime_get_sync(dev)	({ (void)(dev); 0; })
+#define pm_runtime_put_autosuspend(dev)	({ (void)(dev); 0; })
+#define pm_runtime_suspended(dev)	false
+#define pm_runtime_mark_last_busy(dev)	do { } while (0)
+#define pm_runtime_put(dev)		({ 0; })
+#define pm_runtime_put_sync(dev)	0
+#define pm_runtime_get_noresume(dev)	do { } while (0)
+#define pm_runtime_put_noidle(dev)	do { } while (0)
+#define pm_runtime_enable(dev)		do { } while (0)
+#define pm_runtime_disable(dev)		do { } while (0)
+#define pm_runtime_idle(dev)		({ 0; })
+
+/* debugfs and seq_file, nothing is created */
+
+struct dentry {
+	int dummy;
+};
+
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct seq_file {
+	void *private;
+};
+
+struct file_operations {
+	void *owner;
+	int (*open)(struct inode *inode, struct file *file);
+	int (*release)(struct inode *inode, struct file *file);
+	ssize_t (*read)(struct file *file, char __user *buf, size_t count,
+			loff_t *ppos);
+	ssize_t (*write)(struct file *file, const char __user *buf,
+			 size_t count, loff_t *ppos);
+	loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+};
+
+#define S_IRUGO			0444
+#define S_IWUSR			0200
+#define S_IRUSR			0400
+#define S_IWUGO			0222
+
+#define debugfs_create_dir(n, p)		((struct dentry *)NULL)
+#define debugfs_create_file(n, m, p, d, f)	((struct dentry *)NULL)
+#define debugfs_create_file_size(n, m, p, d, f, s) ((struct dentry *)NULL)
+#define debugfs_create_u32(n, m, p, v)		((struct dentry *)NULL)
+#define debugfs_create_u64(n, m, p, v)		((struct dentry *)NULL)
+#define debugfs_create_x32(n, m, p, v)		((struct dentry *)NULL)
+#define debugfs_create_bool(n, m, p, v)		((struct dentry *)NULL)
+#define debugfs_create_blob(n, m, p, b)		((struct dentry *)NULL)
+#define debugfs_remove_recursive(d)		do { } while (0)
+#define debugfs_remove(d)			do { } while (0)
+
+#define seq_printf(m, ...)	((void)(m))
+#define seq_puts(m, s)		((void)(m))
+#define seq_read		NULL
+#define seq_lseek		NULL
+#define default_llseek		NULL
+#define single_open(f, show, d)	0
+#define single_release		NULL
+#define simple_open		NULL
+
+ssize_t simple_read_from_buffer(void __user *to, size_t count, loff_t *ppos,
+				const void *from, size_t available);
+
+/* Regulators and GPIOs are never present */
+
+struct regulator {
+	int dummy;
+};
+
+struct gpio_desc {
+	int dummy;
+};
+
+struct regulator_bulk_data {
+	const char *supply;
+	struct regulator *consumer;
+};
+
+struct gpio_chip {
+	const char *label;
+	struct device *parent;
+	struct device_node *of_node;
+	void *owner;
+	int (*get_direction)(struct gpio_chip *chip, unsigned int offset);
+	int (*direction_input)(struct gpio_chip *chip, unsigned int offset);
+	int (*direction_output)(struct gpio_chip *chip, unsigned int offset,
+				int value);
+	int (*get)(struct gpio_chip *chip, unsigned int offset);
+	int (*get_multiple)(struct gpio_chip *chip, unsigned long *mask,
+			    unsigned long *bits);
+	void (*set)(struct gpio_chip *chip, unsigned int offset, int value);
+	void (*set_multiple)(struct gpio_chip *chip, unsigned long *mask,
+			     unsigned long *bits);
+	int base;
+	u16 ngpio;
+	bool can_sleep;
+	void *data;
+};
+
+static inline void *gpiochip_get_data(struct gpio_chip *chip)
+{
+	return chip->data;
+}
+
+#define devm_gpiochip_add_data(dev, chip, d)	((chip)->data = (d), 0)
+
+#define GPIOF_OUT_INIT_LOW		0x0
+#define GPIOF_OUT_INIT_HIGH		0x2
+
+#define devm_regulator_get(dev, id)	((struct regulator *)NULL)
+#define regulator_enable(r)		0
+#define regulator_disable(r)		({ 0; })
+#define regulator_is_enabled(r)		1
+#define regulator_allow_bypass(r, b)	0
+#define devm_get_gpiod_from_child(dev, id, child) \
+	((struct gpio_desc *)NULL)
+#define gpio_to_desc(g)			((struct gpio_desc *)NULL)
+#define gpiod_set_value(g, v)		do { } while (0)
+#define gpiod_set_value_cansleep(g, v)	do { } while (0)
+#define gpio_is_valid(g)		((g) > 0)
+#define devm_gpio_request_one(dev, g, f, l)	(-ENODEV)
+#define gpio_export(g, d)		0
+#define gpio_export_link(dev, n, g)	0
+#define gpio_set_value_cansleep(g, v)	do { } while (0)
+
+/* IRQs */
+
+typedef enum irqreturn {
+	IRQ_NONE,
+	IRQ_HANDLED,
+	IRQ_WAKE_THREAD,
+} irqreturn_t;
+
+typedef irqreturn_t (*irq_handler_t)(int irq, void *data);
+
+/* Platform devices, probe is never run by the tests */
+
+struct platform_device {
+	const char *name;
+	struct device dev;
+};
+
+struct platform_driver {
+	int (*probe)(struct platform_device *pdev);
+	int (*remove)(struct platform_device *pdev);
+	struct {
+		const char *name;
+		void *owner;
+		const void *pm;
+		const void *of_match_table;
+	} driver;
+};
+
+#define to_platform_device(d) \
+	container_of(d, struct platform_device, dev)
+#define platform_get_drvdata(pdev)	dev_get_drvdata(&(pdev)->dev)
+#define platform_set_drvdata(pdev, d)	dev_set_drvdata(&(pdev)->dev, d)
+
+struct device_attribute {
+	const char *name;
+};
+
+#define DEVICE_ATTR(_name, _mode, _show, _store) \
+	struct device_attribute dev_attr_##_name = { .name = #_name }
+#define device_create_file(dev, attr)	0
+#define device_remove_file(dev, attr)	do { } while (0)
+
+/* Input and extcon devices, reports go nowhere */
+
+#define EV_KEY			0x01
+#define EV_SW			0x05
+#define KEY_VOLUMEDOWN		114
+#define KEY_VOLUMEUP		115
+#define KEY_MEDIA		226
+#define KEY_VOICECOMMAND	0x246
+#define SW_HEADPHONE_INSERT	0x02
+#define SW_MICROPHONE_INSERT	0x04
+#define SW_LINEOUT_INSERT	0x06
+#define SW_JACK_PHYSICAL_INSERT	0x07
+
+struct input_dev {
+	const char *name;
+	const char *phys;
+	struct device dev;
+};
+
+#define devm_input_allocate_device(dev)	((struct input_dev *)NULL)
+#define input_register_device(input)	0
+#define input_set_capability(input, type, code)	do { } while (0)
+#define input_report_key(input, code, v)	do { } while (0)
+#define input_report_switch(input, code, v)	do { } while (0)
+#define input_sync(input)		do { } while (0)
+
+#define EXTCON_NONE		0
+#define EXTCON_JACK_MICROPHONE	20
+#define EXTCON_JACK_HEADPHONE	21
+#define EXTCON_JACK_LINE_OUT	22
+#define EXTCON_MECHANICAL	60
+
+struct extcon_dev {
+	int dummy;
+};
+
+#define devm_extcon_dev_allocate(dev, cable)	((struct extcon_dev *)NULL)
+#define devm_extcon_dev_register(dev, edev)	0
+#define extcon_dev_register(edev)		0
+#define extcon_set_state_sync(edev, id, state)	0
+
+/* Power supplies, none is ever found */
+
+#define PSY_EVENT_PROP_CHANGED	0
+
+enum power_supply_type {
+	POWER_SUPPLY_TYPE_USB = 4,
+	POWER_SUPPLY_TYPE_USB_PD = 9,
+};
+
+enum power_supply_property {
+	POWER_SUPPLY_PROP_TYPEC_MODE = 60,
+};
+
+enum power_supply_typec_mode {
+	POWER_SUPPLY_TYPEC_SINK_AUDIO_ADAPTER = 6,
+};
+
+union power_supply_propval {
+	int intval;
+	const char *strval;
+};
+
+struct power_supply_desc {
+	const char *name;
+	enum power_supply_type type;
+};
+
+struct power_supply {
+	const struct power_supply_desc *desc;
+};
+
+#define power_supply_get_by_name(n)	((struct power_supply *)NULL)
+#define power_supply_get_property(psy, p, v)	(-ENODEV)
+#define power_supply_put(psy)		do { } while (0)
+#define power_supply_reg_notifier(nb)	({ 0; })
+#define power_supply_unreg_notifier(nb)	do { } while (0)
+
+/* Tracepoints compile to nothing */
+
+#define TP_PROTO(args...)	args
+#define TP_ARGS(args...)	args
+#define DECLARE_EVENT_CLASS(name, proto, args, tstruct, assign, print)
+#define DEFINE_EVENT(template, name, proto, args) \
+	static inline void trace_##name(proto) { }
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+	DEFINE_EVENT(name, name, PARAMS(proto), PARAMS(args))
+#define PARAMS(args...)		args
+
+/* Fake register map, see regmap.c */
+
+#include "regmap.h"
+
+#include "sound.h"
+
+#endif
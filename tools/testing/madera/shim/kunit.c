@@ -0,0 +1,75 @@
+/*
+ * kunit.c -- Subset of the KUnit API for host tests of Madera drivers
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <setjmp.h>
+
+#include "kernel.h"
+#include "kunit.h"
+
+static jmp_buf kunit_abort_env;
+
+void kunit_fail(struct kunit *test, const char *file, int line,
+		const char *fmt, ...)
+{
+	va_list ap;
+
+	test->failed = true;
+
+	printf("    # %s: %s:%d: ", test->name, file, line);
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	putchar('\n');
+}
+
+void kunit_abort(struct kunit *test)
+{
+	longjmp(kunit_abort_env, 1);
+}
+
+/* Report in KTAP, as a kernel KUnit run would */
+int kunit_run_suite(struct kunit_suite *suite)
+{
+	struct kunit_case *test_case;
+	struct kunit test;
+	int n = 0, failed = 0;
+
+	for (test_case = suite->test_cases; test_case->run_case; test_case++)
+		n++;
+
+	printf("TAP version 14\n1..1\n");
+	printf("    # Subtest: %s\n    1..%d\n", suite->name, n);
+
+	n = 0;
+	for (test_case = suite->test_cases; test_case->run_case; test_case++) {
+		memset(&test, 0, sizeof(test));
+		test.name = test_case->name;
+
+		if (suite->init && suite->init(&test)) {
+			test.failed = true;
+		} else {
+			if (!setjmp(kunit_abort_env))
+				test_case->run_case(&test);
+
+			if (suite->exit)
+				suite->exit(&test);
+		}
+
+		printf("    %s %d - %s\n", test.failed ? "not ok" : "ok", ++n,
+		       test_case->name);
+
+		if (test.failed)
+			failed++;
+	}
+
+	printf("%s 1 - %s\n", failed ? "not ok" : "ok", suite->name);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * kunit.h -- Subset of the KUnit API for host tests of Madera drivers
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Test cases are written against the KUnit interface, so they can move to
+ * a kernel with KUnit once the drivers do. Each test binary defines one
+ * suite with kunit_test_suite(), which provides main().
+ */
+
+#ifndef MADERA_TEST_KUNIT_H
+#define MADERA_TEST_KUNIT_H
+
+struct kunit {
+	void *priv;
+	const char *name;
+	bool failed;
+};
+
+struct kunit_case {
+	void (*run_case)(struct kunit *test);
+	const char *name;
+};
+
+struct kunit_suite {
+	const char *name;
+	int (*init)(struct kunit *test);
+	void (*exit)(struct kunit *test);
+	struct kunit_case *test_cases;
+};
+
+#define KUNIT_CASE(fn)		{ .run_case = fn, .name = #fn }
+
+void kunit_fail(struct kunit *test, const char *file, int line,
+		const char *fmt, ...) __printf(4, 5);
+void kunit_abort(struct kunit *test) __attribute__((noreturn));
+int kunit_run_suite(struct kunit_suite *suite);
+
+#define KUNIT_BINARY_CHECK(test, abort, left, op, right, fmt, ...)	\
+	do {								\
+		long long __l = (long long)(left);			\
+		long long __r = (long long)(right);			\
+									\
+		if (!(__l op __r)) {					\
+			kunit_fail(test, __FILE__, __LINE__,		\
+				   "%s %s %s: %lld vs %lld " fmt,	\
+				   #left, #op, #right, __l, __r,	\
+				   ##__VA_ARGS__);			\
+			if (abort)					\
+				kunit_abort(test);			\
+		}							\
+	} while (0)
+
+#define KUNIT_EXPECT_EQ(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, ==, r, "")
+#define KUNIT_EXPECT_NE(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, !=, r, "")
+#define KUNIT_EXPECT_LT(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, <, r, "")
+#define KUNIT_EXPECT_LE(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, <=, r, "")
+#define KUNIT_EXPECT_GT(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, >, r, "")
+#define KUNIT_EXPECT_GE(t, l, r)	KUNIT_BINARY_CHECK(t, 0, l, >=, r, "")
+#define KUNIT_EXPECT_TRUE(t, c)		KUNIT_EXPECT_EQ(t, !!(c), 1)
+#define KUNIT_EXPECT_FALSE(t, c)	KUNIT_EXPECT_EQ(t, !!(c), 0)
+#define KUNIT_EXPECT_LE_MSG(t, l, r, fmt, ...) \
+	KUNIT_BINARY_CHECK(t, 0, l, <=, r, fmt, ##__VA_ARGS__)
+#define KUNIT_EXPECT_EQ_MSG(t, l, r, fmt, ...) \
+	KUNIT_BINARY_CHECK(t, 0, l, ==, r, fmt, ##__VA_ARGS__)
+
+#define KUNIT_ASSERT_EQ(t, l, r)	KUNIT_BINARY_CHECK(t, 1, l, ==, r, "")
+#define KUNIT_ASSERT_NE(t, l, r)	KUNIT_BINARY_CHECK(t, 1, l, !=, r, "")
+#define KUNIT_ASSERT_TRUE(t, c)		KUNIT_ASSERT_EQ(t, !!(c), 1)
+#define KUNIT_ASSERT_NOT_ERR_OR_NULL(t, p) \
+	KUNIT_BINARY_CHECK(t, 1, IS_ERR_OR_NULL(p), ==, 0, "")
+
+#define kunit_test_suite(suite)			\
+	int main(void)				\
+	{					\
+		return kunit_run_suite(&suite);	\
+	}
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ * regmap.c -- Fake register map for host tests of Madera drivers
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "kernel.h"
+
+struct regmap *regmap_test_init(unsigned int val_bytes,
+				unsigned int reg_stride, bool cache)
+{
+	struct regmap *map = kzalloc(sizeof(*map), GFP_KERNEL);
+
+	if (!map)
+		return NULL;
+
+	map->val_bytes = val_bytes;
+	map->reg_stride = reg_stride;
+	map->cache = cache;
+
+	return map;
+}
+
+void regmap_test_exit(struct regmap *map)
+{
+	int i;
+
+	if (!map)
+		return;
+
+	for (i = 0; i < map->n_windows; i++)
+		kfree(map->windows[i].vals);
+
+	kfree(map);
+}
+
+int regmap_test_add_window(struct regmap *map, unsigned int base,
+			   unsigned int nregs)
+{
+	struct regmap_test_window *win;
+
+	if (map->n_windows == REGMAP_TEST_MAX_WINDOWS)
+		return -ENOSPC;
+
+	win = &map->windows[map->n_windows];
+	win->vals = kcalloc(nregs, sizeof(*win->vals), GFP_KERNEL);
+	if (!win->vals)
+		return -ENOMEM;
+
+	win->base = base;
+	win->nregs = nregs;
+	map->n_windows++;
+
+	return 0;
+}
+
+void regmap_test_reset_stats(struct regmap *map)
+{
+	map->reads = 0;
+	map->writes = 0;
+	map->async_writes = 0;
+	map->async_completes = 0;
+	map->bytes_read = 0;
+	map->bytes_written = 0;
+}
+
+/* Find the storage for count consecutive registers, NULL if not all mapped */
+static u32 *regmap_test_find(struct regmap *map, unsigned int reg,
+			     size_t count)
+{
+	struct regmap_test_window *win;
+	unsigned int idx;
+	int i;
+
+	if (reg % map->reg_stride)
+		return NULL;
+
+	for (i = 0; i < map->n_windows; i++) {
+		win = &map->windows[i];
+
+		if (reg < win->base)
+			continue;
+
+		idx = (reg - win->base) / map->reg_stride;
+		if (idx + count <= win->nregs)
+			return &win->vals[idx];
+	}
+
+	return NULL;
+}
+
+static u32 regmap_test_mask(struct regmap *map)
+{
+	if (map->val_bytes == 4)
+		return 0xffffffff;
+
+	return (1U << (8 * map->val_bytes)) - 1;
+}
+
+u32 regmap_test_peek(struct regmap *map, unsigned int reg)
+{
+	u32 *val = regmap_test_find(map, reg, 1);
+
+	return val ? *val : 0xdeadbeef;
+}
+
+void regmap_test_poke(struct regmap *map, unsigned int reg, u32 val)
+{
+	u32 *p = regmap_test_find(map, reg, 1);
+
+	if (p)
+		*p = val & regmap_test_mask(map);
+}
+
+static void regmap_test_format(struct regmap *map, void *buf, u32 val)
+{
+	u8 *p = buf;
+	int i;
+
+	for (i = map->val_bytes - 1; i >= 0; i--) {
+		p[i] = val & 0xff;
+		val >>= 8;
+	}
+}
+
+static u32 regmap_test_parse(struct regmap *map, const void *buf)
+{
+	const u8 *p = buf;
+	u32 val = 0;
+	unsigned int i;
+
+	for (i = 0; i < map->val_bytes; i++)
+		val = (val << 8) | p[i];
+
+	return val;
+}
+
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val)
+{
+	u32 *p = regmap_test_find(map, reg, 1);
+
+	if (!p)
+		return -EIO;
+
+	if (!map->cache) {
+		map->reads++;
+		map->bytes_read += map->val_bytes;
+	}
+
+	*val = *p;
+
+	return 0;
+}
+
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val)
+{
+	u32 *p = regmap_test_find(map, reg, 1);
+
+	if (!p)
+		return -EIO;
+
+	map->writes++;
+	map->bytes_written += map->val_bytes;
+
+	*p = val & regmap_test_mask(map);
+
+	return 0;
+}
+
+int regmap_raw_read(struct regmap *map, unsigned int reg, void *val,
+		    size_t val_len)
+{
+	size_t count = val_len / map->val_bytes;
+	u32 *p;
+	size_t i;
+
+	if (val_len % map->val_bytes)
+		return -EINVAL;
+
+	p = regmap_test_find(map, reg, count);
+	if (!p)
+		return -EIO;
+
+	/* The core splits reads larger than the bus allows */
+	if (map->raw_read_max)
+		map->reads += DIV_ROUND_UP(val_len, map->raw_read_max);
+	else
+		map->reads++;
+	map->bytes_read += val_len;
+
+	for (i = 0; i < count; i++)
+		regmap_test_format(map, (u8 *)val + i * map->val_bytes, p[i]);
+
+	return 0;
+}
+
+int regmap_raw_write(struct regmap *map, unsigned int reg, const void *val,
+		     size_t val_len)
+{
+	size_t count = val_len / map->val_bytes;
+	u32 *p;
+	size_t i;
+
+	if (val_len % map->val_bytes)
+		return -EINVAL;
+
+	p = regmap_test_find(map, reg, count);
+	if (!p)
+		return -EIO;
+
+	map->writes++;
+	map->bytes_written += val_len;
+
+	for (i = 0; i < count; i++)
+		p[i] = regmap_test_parse(map,
+					 (const u8 *)val + i * map->val_bytes);
+
+	return 0;
+}
+
+int regmap_raw_write_async(struct regmap *map, unsigned int reg,
+			   const void *val, size_t val_len)
+{
+	int ret = regmap_raw_write(map, reg, val, val_len);
+
+	if (!ret) {
+		map->async_writes++;
+		map->async_pending++;
+	}
+
+	return ret;
+}
+
+int regmap_async_complete(struct regmap *map)
+{
+	if (map->async_pending) {
+		map->async_completes++;
+		map->async_pending = 0;
+	}
+
+	return 0;
+}
+
+int regmap_bulk_read(struct regmap *map, unsigned int reg, void *val,
+		     size_t val_count)
+{
+	u32 *p = regmap_test_find(map, reg, val_count);
+	size_t i;
+
+	if (!p)
+		return -EIO;
+
+	/* A cached map reads each register from the cache */
+	if (!map->cache) {
+		map->reads++;
+		map->bytes_read += val_count * map->val_bytes;
+	}
+
+	for (i = 0; i < val_count; i++) {
+		switch (map->val_bytes) {
+		case 2:
+			((u16 *)val)[i] = p[i];
+			break;
+		default:
+			((u32 *)val)[i] = p[i];
+			break;
+		}
+	}
+
+	return 0;
+}
+
+int regmap_bulk_write(struct regmap *map, unsigned int reg, const void *val,
+		      size_t val_count)
+{
+	u32 *p = regmap_test_find(map, reg, val_count);
+	size_t i;
+
+	if (!p)
+		return -EIO;
+
+	map->writes++;
+	map->bytes_written += val_count * map->val_bytes;
+
+	for (i = 0; i < val_count; i++) {
+		switch (map->val_bytes) {
+		case 2:
+			p[i] = ((const u16 *)val)[i];
+			break;
+		default:
+			p[i] = ((const u32 *)val)[i];
+			break;
+		}
+	}
+
+	return 0;
+}
+
+int regmap_multi_reg_write(struct regmap *map, const struct reg_sequence *regs,
+			   int num_regs)
+{
+	int i, ret;
+
+	for (i = 0; i < num_regs; i++) {
+		ret = regmap_write(map, regs[i].reg, regs[i].def);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int regmap_update_bits_base(struct regmap *map, unsigned int reg,
+			    unsigned int mask, unsigned int val,
+			    bool *change, bool async, bool force)
+{
+	unsigned int orig, tmp;
+	int ret;
+
+	if (change)
+		*change = false;
+
+	ret = regmap_read(map, reg, &orig);
+	if (ret)
+		return ret;
+
+	tmp = (orig & ~mask) | (val & mask);
+	if (!force && tmp == orig)
+		return 0;
+
+	ret = regmap_write(map, reg, tmp);
+	if (ret)
+		return ret;
+
+	if (async) {
+		map->async_writes++;
+		map->async_pending++;
+	}
+
+	if (change)
+		*change = true;
+
+	return 0;
+}
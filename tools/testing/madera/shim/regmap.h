@@ -0,0 +1,118 @@
+/*
+ * regmap.h -- Fake register map for host tests of Madera drivers
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef MADERA_TEST_REGMAP_H
+#define MADERA_TEST_REGMAP_H
+
+#define REGMAP_TEST_MAX_WINDOWS	8
+
+struct reg_sequence {
+	unsigned int reg;
+	unsigned int def;
+	unsigned int delay_us;
+};
+
+struct reg_default {
+	unsigned int reg;
+	unsigned int def;
+};
+
+struct regmap_test_window {
+	unsigned int base;
+	unsigned int nregs;
+	u32 *vals;
+};
+
+/*
+ * A register map made of windows of registers, formatted big endian for
+ * raw access like the Madera SPI and I2C buses. Every bus transaction and
+ * the bytes it carried are counted. A cached map serves reads of single
+ * registers without touching the bus, as REGCACHE_RBTREE does for the
+ * Madera control registers.
+ */
+struct regmap {
+	unsigned int val_bytes;
+	unsigned int reg_stride;
+	bool cache;
+	size_t raw_read_max;
+
+	struct regmap_test_window windows[REGMAP_TEST_MAX_WINDOWS];
+	int n_windows;
+
+	unsigned int reads;
+	unsigned int writes;
+	unsigned int async_writes;
+	unsigned int async_completes;
+	size_t bytes_read;
+	size_t bytes_written;
+	int async_pending;
+};
+
+struct regmap *regmap_test_init(unsigned int val_bytes,
+				unsigned int reg_stride, bool cache);
+void regmap_test_exit(struct regmap *map);
+int regmap_test_add_window(struct regmap *map, unsigned int base,
+			   unsigned int nregs);
+void regmap_test_reset_stats(struct regmap *map);
+u32 regmap_test_peek(struct regmap *map, unsigned int reg);
+void regmap_test_poke(struct regmap *map, unsigned int reg, u32 val);
+
+int regmap_read(struct regmap *map, unsigned int reg, unsigned int *val);
+int regmap_write(struct regmap *map, unsigned int reg, unsigned int val);
+int regmap_raw_read(struct regmap *map, unsigned int reg, void *val,
+		    size_t val_len);
+int regmap_raw_write(struct regmap *map, unsigned int reg, const void *val,
+		     size_t val_len);
+int regmap_raw_write_async(struct regmap *map, unsigned int reg,
+			   const void *val, size_t val_len);
+int regmap_bulk_read(struct regmap *map, unsigned int reg, void *val,
+		     size_t val_count);
+int regmap_bulk_write(struct regmap *map, unsigned int reg, const void *val,
+		      size_t val_count);
+int regmap_multi_reg_write(struct regmap *map, const struct reg_sequence *regs,
+			   int num_regs);
+int regmap_update_bits_base(struct regmap *map, unsigned int reg,
+			    unsigned int mask, unsigned int val,
+			    bool *change, bool async, bool force);
+int regmap_async_complete(struct regmap *map);
+
+#define regmap_update_bits(map, reg, mask, val) \
+	regmap_update_bits_base(map, reg, mask, val, NULL, false, false)
+#define regmap_update_bits_async(map, reg, mask, val) \
+	regmap_update_bits_base(map, reg, mask, val, NULL, true, false)
+#define regmap_update_bits_check(map, reg, mask, val, change) \
+	regmap_update_bits_base(map, reg, mask, val, change, false, false)
+#define regmap_update_bits_check_async(map, reg, mask, val, change) \
+	regmap_update_bits_base(map, reg, mask, val, change, true, false)
+#define regmap_write_bits(map, reg, mask, val) \
+	regmap_update_bits_base(map, reg, mask, val, NULL, false, true)
+
+static inline int regmap_get_val_bytes(struct regmap *map)
+{
+	return map->val_bytes;
+}
+
+static inline int regmap_get_reg_stride(struct regmap *map)
+{
+	return map->reg_stride;
+}
+
+static inline size_t regmap_get_raw_read_max(struct regmap *map)
+{
+	return map->raw_read_max;
+}
+
+#define regcache_cache_only(map, enable)	do { } while (0)
+#define regcache_cache_bypass(map, enable)	do { } while (0)
+#define regcache_mark_dirty(map)		do { } while (0)
+#define regcache_sync(map)			0
+#define regcache_drop_region(map, min, max)	0
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * sound.c -- Minimal ALSA and ASoC API for building Madera drivers on the host
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "kernel.h"
+
+int snd_pcm_format_width(snd_pcm_format_t format)
+{
+	switch (format) {
+	case SNDRV_PCM_FORMAT_S16_LE:
+		return 16;
+	case SNDRV_PCM_FORMAT_S20_3LE:
+		return 20;
+	case SNDRV_PCM_FORMAT_S24_LE:
+		return 24;
+	case SNDRV_PCM_FORMAT_S32_LE:
+		return 32;
+	default:
+		return -EINVAL;
+	}
+}
+
+int snd_soc_params_to_bclk(struct snd_pcm_hw_params *params)
+{
+	return params_rate(params) * params_channels(params) *
+	       snd_pcm_format_width(params_format(params));
+}
+
+/* Controls are not registered on the host, so no TLV is ever accessed */
+int snd_soc_bytes_tlv_callback(struct snd_kcontrol *kcontrol, int op_flag,
+			       unsigned int size, unsigned int __user *tlv)
+{
+	return -ENXIO;
+}
+
+/*
+ * Controls are never called from userspace on the host, but the drivers'
+ * own handlers chain to the core ones
+ */
+#define SND_SOC_TEST_CTL(fn, arg)					\
+	int fn(struct snd_kcontrol *kcontrol, struct arg *ucontrol)	\
+	{								\
+		return -EINVAL;						\
+	}
+
+SND_SOC_TEST_CTL(snd_soc_info_enum_double, snd_ctl_elem_info)
+SND_SOC_TEST_CTL(snd_soc_get_enum_double, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_put_enum_double, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_dapm_get_enum_double, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_dapm_put_enum_double, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_info_volsw, snd_ctl_elem_info)
+SND_SOC_TEST_CTL(snd_soc_get_volsw, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_put_volsw, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_info_volsw_range, snd_ctl_elem_info)
+SND_SOC_TEST_CTL(snd_soc_get_volsw_range, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_put_volsw_range, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_bytes_info, snd_ctl_elem_info)
+SND_SOC_TEST_CTL(snd_soc_bytes_get, snd_ctl_elem_value)
+SND_SOC_TEST_CTL(snd_soc_bytes_put, snd_ctl_elem_value)
+
+/* Codec register I/O goes to the component's register map */
+int snd_soc_component_update_bits(struct snd_soc_component *component,
+				  unsigned int reg, unsigned int mask,
+				  unsigned int val)
+{
+	bool change;
+	int ret;
+
+	ret = regmap_update_bits_check(component->regmap, reg, mask, val,
+				       &change);
+	if (ret < 0)
+		return ret;
+
+	return change;
+}
+
+unsigned int snd_soc_read(struct snd_soc_codec *codec, unsigned int reg)
+{
+	unsigned int val;
+
+	if (regmap_read(codec->component.regmap, reg, &val))
+		return -1;
+
+	return val;
+}
+
+int snd_soc_write(struct snd_soc_codec *codec, unsigned int reg,
+		  unsigned int val)
+{
+	return regmap_write(codec->component.regmap, reg, val);
+}
+
+int snd_soc_update_bits(struct snd_soc_codec *codec, unsigned int reg,
+			unsigned int mask, unsigned int val)
+{
+	return snd_soc_component_update_bits(&codec->component, reg, mask,
+					     val);
+}
+
+int snd_soc_test_bits(struct snd_soc_codec *codec, unsigned int reg,
+		      unsigned int mask, unsigned int value)
+{
+	unsigned int old = snd_soc_read(codec, reg);
+
+	return (old & mask) != (value & mask);
+}
@@ -0,0 +1,540 @@
+/*
+ * sound.h -- Minimal ALSA and ASoC API for host tests of Madera drivers
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Control and widget definitions collapse to empty initialisers, so the
+ * drivers' tables compile but register nothing.
+ */
+
+#ifndef MADERA_TEST_SOUND_H
+#define MADERA_TEST_SOUND_H
+
+/* Controls */
+
+#define SNDRV_CTL_ELEM_ID_NAME_MAXLEN		44
+#define SNDRV_CTL_ELEM_IFACE_MIXER		2
+#define SNDRV_CTL_ELEM_TYPE_INTEGER		2
+#define SNDRV_CTL_ELEM_TYPE_BYTES		4
+#define SNDRV_CTL_ELEM_ACCESS_READ		(1 << 0)
+#define SNDRV_CTL_ELEM_ACCESS_WRITE		(1 << 1)
+#define SNDRV_CTL_ELEM_ACCESS_READWRITE		(3 << 0)
+#define SNDRV_CTL_ELEM_ACCESS_VOLATILE		(1 << 2)
+#define SNDRV_CTL_ELEM_ACCESS_TLV_READ		(1 << 4)
+#define SNDRV_CTL_ELEM_ACCESS_TLV_WRITE		(1 << 5)
+#define SNDRV_CTL_ELEM_ACCESS_TLV_CALLBACK	(1 << 28)
+
+struct snd_kcontrol;
+struct snd_ctl_elem_info;
+struct snd_ctl_elem_value;
+
+typedef int (snd_kcontrol_info_t)(struct snd_kcontrol *kcontrol,
+				  struct snd_ctl_elem_info *uinfo);
+typedef int (snd_kcontrol_get_t)(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol);
+typedef int (snd_kcontrol_put_t)(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol);
+typedef int (snd_kcontrol_tlv_rw_t)(struct snd_kcontrol *kcontrol,
+				    int op_flag, unsigned int size,
+				    unsigned int __user *tlv);
+
+struct snd_ctl_elem_info {
+	int type;
+	unsigned int count;
+	union {
+		struct {
+			long min;
+			long max;
+			long step;
+		} integer;
+	} value;
+};
+
+struct snd_ctl_elem_value {
+	union {
+		union {
+			long value[128];
+		} integer;
+		union {
+			unsigned int item[128];
+		} enumerated;
+		union {
+			unsigned char data[512];
+		} bytes;
+	} value;
+};
+
+struct snd_kcontrol_new {
+	int iface;
+	const char *name;
+	unsigned int access;
+	snd_kcontrol_info_t *info;
+	snd_kcontrol_get_t *get;
+	snd_kcontrol_put_t *put;
+	union {
+		snd_kcontrol_tlv_rw_t *c;
+		const unsigned int *p;
+	} tlv;
+	unsigned long private_value;
+};
+
+struct snd_kcontrol {
+	unsigned long private_value;
+	void *private_data;
+};
+
+struct soc_mixer_control {
+	int min, max, platform_max;
+	int reg, rreg;
+	unsigned int shift, rshift;
+	unsigned int sign_bit;
+	unsigned int invert:1;
+	unsigned int autodisable:1;
+};
+
+struct soc_bytes {
+	int base;
+	int num_regs;
+	u32 mask;
+};
+
+struct soc_bytes_ext {
+	int max;
+	int (*get)(struct snd_kcontrol *kcontrol, unsigned int __user *bytes,
+		   unsigned int size);
+	int (*put)(struct snd_kcontrol *kcontrol,
+		   const unsigned int __user *bytes, unsigned int size);
+};
+
+struct soc_enum {
+	int reg;
+	unsigned char shift_l;
+	unsigned char shift_r;
+	unsigned int items;
+	unsigned int mask;
+	const char * const *texts;
+	const unsigned int *values;
+	unsigned int autodisable:1;
+};
+
+#define SOC_ENUM_SINGLE(xreg, xshift, xitems, xtexts) \
+	{ .reg = xreg, .shift_l = xshift, .shift_r = xshift, \
+	  .items = xitems, .texts = xtexts }
+#define SOC_ENUM_SINGLE_EXT(xitems, xtexts) \
+	{ .items = xitems, .texts = xtexts }
+#define SOC_VALUE_ENUM_SINGLE(xreg, xshift, xmask, xitems, xtexts, xvalues) \
+	{ .reg = xreg, .shift_l = xshift, .shift_r = xshift, \
+	  .mask = xmask, .items = xitems, .texts = xtexts, .values = xvalues }
+#define SOC_ENUM_SINGLE_DECL(name, xreg, xshift, xtexts) \
+	const struct soc_enum name = SOC_ENUM_SINGLE(xreg, xshift, \
+						     ARRAY_SIZE(xtexts), xtexts)
+#define SOC_VALUE_ENUM_SINGLE_DECL(name, xreg, xshift, xmask, xtexts, \
+				   xvalues) \
+	const struct soc_enum name = SOC_VALUE_ENUM_SINGLE(xreg, xshift, \
+				xmask, ARRAY_SIZE(xtexts), xtexts, xvalues)
+#define SOC_VALUE_ENUM_SINGLE_AUTODISABLE_DECL(name, xreg, xshift, xmask, \
+					       xtexts, xvalues) \
+	SOC_VALUE_ENUM_SINGLE_DECL(name, xreg, xshift, xmask, xtexts, xvalues)
+
+/* Every control macro is an initialiser naming the control and nothing else */
+#define SOC_KCONTROL(xname)	{ .iface = SNDRV_CTL_ELEM_IFACE_MIXER, \
+				  .name = xname }
+#define SOC_SINGLE(xname, ...)			SOC_KCONTROL(xname)
+#define SOC_SINGLE_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_SINGLE_EXT(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_SINGLE_EXT_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_SINGLE_RANGE_TLV(xname, ...)	SOC_KCONTROL(xname)
+#define SOC_SINGLE_SX_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DOUBLE(xname, ...)			SOC_KCONTROL(xname)
+#define SOC_DOUBLE_R(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DOUBLE_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DOUBLE_R_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_ENUM(xname, ...)			SOC_KCONTROL(xname)
+#define SOC_ENUM_EXT(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_VALUE_ENUM(xname, ...)		SOC_KCONTROL(xname)
+#define SND_SOC_BYTES(xname, ...)		SOC_KCONTROL(xname)
+#define SND_SOC_BYTES_MASK(xname, ...)		SOC_KCONTROL(xname)
+#define SND_SOC_BYTES_EXT(xname, ...)		SOC_KCONTROL(xname)
+#define SND_SOC_BYTES_TLV(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DAPM_SINGLE(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DAPM_SINGLE_AUTODISABLE(xname, ...)	SOC_KCONTROL(xname)
+#define SOC_DAPM_ENUM(xname, ...)		SOC_KCONTROL(xname)
+#define SOC_DAPM_ENUM_EXT(xname, ...)		SOC_KCONTROL(xname)
+
+#define DECLARE_TLV_DB_SCALE(name, min, step, mute) \
+	unsigned int name[] = { 1, 8, min, step }
+#define DECLARE_TLV_DB_RANGE(name, ...) \
+	unsigned int name[] = { 3, 0 }
+
+int snd_soc_info_enum_double(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_info *uinfo);
+int snd_soc_get_enum_double(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol);
+int snd_soc_put_enum_double(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol);
+int snd_soc_dapm_get_enum_double(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol);
+int snd_soc_dapm_put_enum_double(struct snd_kcontrol *kcontrol,
+				 struct snd_ctl_elem_value *ucontrol);
+int snd_soc_info_volsw(struct snd_kcontrol *kcontrol,
+		       struct snd_ctl_elem_info *uinfo);
+int snd_soc_get_volsw(struct snd_kcontrol *kcontrol,
+		      struct snd_ctl_elem_value *ucontrol);
+int snd_soc_put_volsw(struct snd_kcontrol *kcontrol,
+		      struct snd_ctl_elem_value *ucontrol);
+int snd_soc_info_volsw_range(struct snd_kcontrol *kcontrol,
+			     struct snd_ctl_elem_info *uinfo);
+int snd_soc_get_volsw_range(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol);
+int snd_soc_put_volsw_range(struct snd_kcontrol *kcontrol,
+			    struct snd_ctl_elem_value *ucontrol);
+int snd_soc_bytes_info(struct snd_kcontrol *kcontrol,
+		       struct snd_ctl_elem_info *uinfo);
+int snd_soc_bytes_get(struct snd_kcontrol *kcontrol,
+		      struct snd_ctl_elem_value *ucontrol);
+int snd_soc_bytes_put(struct snd_kcontrol *kcontrol,
+		      struct snd_ctl_elem_value *ucontrol);
+int snd_soc_bytes_tlv_callback(struct snd_kcontrol *kcontrol, int op_flag,
+			       unsigned int size, unsigned int __user *tlv);
+
+/* PCM */
+
+typedef int snd_pcm_format_t;
+
+#define SNDRV_PCM_FORMAT_S16_LE		2
+#define SNDRV_PCM_FORMAT_S24_LE		6
+#define SNDRV_PCM_FORMAT_S32_LE		10
+#define SNDRV_PCM_FORMAT_S20_3LE	34
+#define SNDRV_PCM_FMTBIT_S16_LE		(1ULL << SNDRV_PCM_FORMAT_S16_LE)
+#define SNDRV_PCM_FMTBIT_S24_LE		(1ULL << SNDRV_PCM_FORMAT_S24_LE)
+#define SNDRV_PCM_FMTBIT_S32_LE		(1ULL << SNDRV_PCM_FORMAT_S32_LE)
+#define SNDRV_PCM_FMTBIT_S20_3LE	(1ULL << SNDRV_PCM_FORMAT_S20_3LE)
+#define SNDRV_PCM_RATE_KNOT		(1 << 31)
+#define SNDRV_PCM_RATE_8000_192000	0x3ffe
+#define SNDRV_PCM_STREAM_PLAYBACK	0
+#define SNDRV_PCM_STREAM_CAPTURE	1
+#define SNDRV_PCM_STATE_XRUN		4
+#define SNDRV_PCM_TRIGGER_STOP		0
+#define SNDRV_PCM_TRIGGER_START		1
+#define SNDRV_PCM_HW_PARAM_RATE		19
+
+struct snd_pcm_hw_params {
+	unsigned int rate;
+	unsigned int channels;
+	snd_pcm_format_t format;
+};
+
+#define params_rate(p)		((p)->rate)
+#define params_channels(p)	((p)->channels)
+#define params_format(p)	((p)->format)
+#define params_width(p)		snd_pcm_format_width(params_format(p))
+
+int snd_pcm_format_width(snd_pcm_format_t format);
+
+struct snd_pcm_runtime {
+	void *private_data;
+};
+
+struct snd_pcm_substream {
+	int stream;
+	struct snd_pcm_runtime *runtime;
+};
+
+struct snd_pcm_hw_constraint_list {
+	unsigned int count;
+	const unsigned int *list;
+	unsigned int mask;
+};
+
+#define snd_pcm_hw_constraint_list(r, c, v, l)	0
+
+/* Compressed */
+
+#define SND_COMPRESS_PLAYBACK		0
+#define SND_COMPRESS_CAPTURE		1
+#define SND_AUDIOCODEC_BESPOKE		((__u32) 0x0000000E)
+#define MAX_NUM_CODECS			32
+#define MAX_NUM_CODEC_DESCRIPTORS	32
+#define MAX_NUM_BITRATES		32
+#define MAX_NUM_SAMPLE_RATES		32
+
+struct snd_compressed_buffer {
+	__u32 fragment_size;
+	__u32 fragments;
+};
+
+struct snd_codec {
+	__u32 id;
+	__u32 ch_in;
+	__u32 ch_out;
+	__u32 sample_rate;
+	__u32 format;
+};
+
+struct snd_compr_params {
+	struct snd_compressed_buffer buffer;
+	struct snd_codec codec;
+};
+
+struct snd_codec_desc {
+	__u32 max_ch;
+	__u32 sample_rates[MAX_NUM_SAMPLE_RATES];
+	__u32 num_sample_rates;
+	__u32 bit_rate[MAX_NUM_BITRATES];
+	__u32 num_bitrates;
+	__u32 rate_control;
+	__u32 profiles;
+	__u32 modes;
+	__u32 formats;
+	__u32 min_buffer;
+};
+
+struct snd_compr_caps {
+	__u32 num_codecs;
+	__u32 direction;
+	__u32 min_fragment_size;
+	__u32 max_fragment_size;
+	__u32 min_fragments;
+	__u32 max_fragments;
+	__u32 codecs[MAX_NUM_CODECS];
+	__u32 reserved[11];
+};
+
+struct snd_compr_tstamp {
+	__u32 byte_offset;
+	__u32 copied_total;
+	__u32 pcm_frames;
+	__u32 pcm_io_frames;
+	__u32 sampling_rate;
+};
+
+struct snd_compr_runtime {
+	void *private_data;
+};
+
+struct snd_compr_stream {
+	int direction;
+	struct snd_compr_runtime *runtime;
+};
+
+#define snd_compr_fragment_elapsed(stream)	do { } while (0)
+static inline int snd_compr_stop_error(struct snd_compr_stream *stream,
+				       int state)
+{
+	return 0;
+}
+
+/* ASoC */
+
+#define SND_SOC_NOPM			-1
+
+#define SND_SOC_DAIFMT_I2S		1
+#define SND_SOC_DAIFMT_LEFT_J		3
+#define SND_SOC_DAIFMT_DSP_A		4
+#define SND_SOC_DAIFMT_DSP_B		5
+#define SND_SOC_DAIFMT_NB_NF		(0 << 8)
+#define SND_SOC_DAIFMT_NB_IF		(2 << 8)
+#define SND_SOC_DAIFMT_IB_NF		(3 << 8)
+#define SND_SOC_DAIFMT_IB_IF		(4 << 8)
+#define SND_SOC_DAIFMT_CBM_CFM		(1 << 12)
+#define SND_SOC_DAIFMT_CBS_CFM		(2 << 12)
+#define SND_SOC_DAIFMT_CBM_CFS		(3 << 12)
+#define SND_SOC_DAIFMT_CBS_CFS		(4 << 12)
+#define SND_SOC_DAIFMT_FORMAT_MASK	0x000f
+#define SND_SOC_DAIFMT_INV_MASK		0x0f00
+#define SND_SOC_DAIFMT_MASTER_MASK	0xf000
+
+#define SND_SOC_DAPM_PRE_PMU		0x1
+#define SND_SOC_DAPM_POST_PMU		0x2
+#define SND_SOC_DAPM_PRE_PMD		0x4
+#define SND_SOC_DAPM_POST_PMD		0x8
+
+enum snd_soc_dapm_type {
+	snd_soc_dapm_input = 0,
+	snd_soc_dapm_output,
+	snd_soc_dapm_mux,
+	snd_soc_dapm_mixer,
+	snd_soc_dapm_pga,
+	snd_soc_dapm_out_drv,
+	snd_soc_dapm_supply,
+	snd_soc_dapm_spk,
+};
+
+struct snd_soc_codec;
+struct snd_soc_dapm_context;
+
+struct snd_soc_dapm_widget {
+	enum snd_soc_dapm_type id;
+	const char *name;
+	int reg;
+	unsigned char shift;
+	int (*event)(struct snd_soc_dapm_widget *w,
+		     struct snd_kcontrol *kcontrol, int event);
+	unsigned short event_flags;
+	struct snd_soc_dapm_context *dapm;
+};
+
+struct snd_soc_dapm_route {
+	const char *sink;
+	const char *control;
+	const char *source;
+};
+
+#define SND_SOC_DAPM_WIDGET(xid, wname)	{ .id = xid, .name = wname }
+#define SND_SOC_DAPM_PGA_E(wname, ...) \
+	SND_SOC_DAPM_WIDGET(snd_soc_dapm_pga, wname)
+#define SND_SOC_DAPM_SPK(wname, ...) \
+	SND_SOC_DAPM_WIDGET(snd_soc_dapm_spk, wname)
+#define SND_SOC_DAPM_MUX(wname, ...) \
+	SND_SOC_DAPM_WIDGET(snd_soc_dapm_mux, wname)
+#define SND_SOC_DAPM_MIXER(wname, ...) \
+	SND_SOC_DAPM_WIDGET(snd_soc_dapm_mixer, wname)
+
+struct snd_soc_component {
+	const char *name_prefix;
+	struct dentry *debugfs_root;
+	struct regmap *regmap;
+	int val_bytes;
+};
+
+struct snd_soc_dapm_context {
+	struct snd_soc_card *card;
+	struct snd_soc_component *component;
+	struct snd_soc_codec *codec;
+};
+
+struct snd_soc_codec {
+	struct device *dev;
+	struct snd_soc_component component;
+	struct snd_soc_dapm_context dapm;
+	void *drvdata;
+};
+
+struct snd_soc_pcm_stream {
+	const char *stream_name;
+	u64 formats;
+	unsigned int rates;
+	unsigned int channels_min;
+	unsigned int channels_max;
+};
+
+struct snd_soc_dai_driver {
+	int id;
+	const char *name;
+	unsigned int base;
+	struct snd_soc_pcm_stream playback;
+	struct snd_soc_pcm_stream capture;
+};
+
+struct snd_soc_dai {
+	int id;
+	const char *name;
+	struct device *dev;
+	struct snd_soc_codec *codec;
+	struct snd_soc_dai_driver *driver;
+	unsigned int active;
+	unsigned int playback_active;
+	unsigned int capture_active;
+};
+
+struct snd_soc_dai_ops {
+	int (*startup)(struct snd_pcm_substream *substream,
+		       struct snd_soc_dai *dai);
+	int (*set_fmt)(struct snd_soc_dai *dai, unsigned int fmt);
+	int (*set_tdm_slot)(struct snd_soc_dai *dai, unsigned int tx_mask,
+			    unsigned int rx_mask, int slots, int slot_width);
+	int (*hw_params)(struct snd_pcm_substream *substream,
+			 struct snd_pcm_hw_params *params,
+			 struct snd_soc_dai *dai);
+	int (*set_sysclk)(struct snd_soc_dai *dai, int clk_id,
+			  unsigned int freq, int dir);
+	int (*set_tristate)(struct snd_soc_dai *dai, int tristate);
+	int (*set_channel_map)(struct snd_soc_dai *dai,
+			       unsigned int tx_num, unsigned int *tx_slot,
+			       unsigned int rx_num, unsigned int *rx_slot);
+	int (*get_channel_map)(struct snd_soc_dai *dai,
+			       unsigned int *tx_num, unsigned int *tx_slot,
+			       unsigned int *rx_num, unsigned int *rx_slot);
+};
+
+#define snd_soc_codec_get_drvdata(c)	((c)->drvdata)
+#define snd_soc_codec_get_dapm(c)	(&(c)->dapm)
+#define snd_soc_dapm_to_codec(d)	((d)->codec)
+#define snd_soc_kcontrol_codec(k) \
+	((struct snd_soc_codec *)(k)->private_data)
+#define snd_soc_dapm_kcontrol_codec(k)	snd_soc_kcontrol_codec(k)
+#define snd_soc_dapm_kcontrol_dapm(k)	(&snd_soc_kcontrol_codec(k)->dapm)
+#define snd_kcontrol_chip(k)		((k)->private_data)
+
+static inline int snd_soc_add_codec_controls(struct snd_soc_codec *codec,
+					     const struct snd_kcontrol_new *k,
+					     unsigned int n)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_new_controls(struct snd_soc_dapm_context *d,
+					    const struct snd_soc_dapm_widget *w,
+					    int n)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_add_routes(struct snd_soc_dapm_context *d,
+					  const struct snd_soc_dapm_route *r,
+					  int n)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_del_routes(struct snd_soc_dapm_context *d,
+					  const struct snd_soc_dapm_route *r,
+					  int n)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_sync(struct snd_soc_dapm_context *d)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_enable_pin(struct snd_soc_dapm_context *d,
+					  const char *pin)
+{
+	return 0;
+}
+
+static inline int snd_soc_dapm_disable_pin(struct snd_soc_dapm_context *d,
+					   const char *pin)
+{
+	return 0;
+}
+
+static inline int
+snd_soc_dapm_force_enable_pin(struct snd_soc_dapm_context *d, const char *pin)
+{
+	return 0;
+}
+
+#define snd_soc_dapm_mutex_lock(d)		do { } while (0)
+#define snd_soc_dapm_mutex_unlock(d)		do { } while (0)
+#define snd_soc_dapm_mux_update_power(d, k, m, e, u)	0
+
+int snd_soc_params_to_bclk(struct snd_pcm_hw_params *params);
+int snd_soc_component_update_bits(struct snd_soc_component *component,
+				  unsigned int reg, unsigned int mask,
+				  unsigned int val);
+unsigned int snd_soc_read(struct snd_soc_codec *codec, unsigned int reg);
+int snd_soc_write(struct snd_soc_codec *codec, unsigned int reg,
+		  unsigned int val);
+int snd_soc_update_bits(struct snd_soc_codec *codec, unsigned int reg,
+			unsigned int mask, unsigned int val);
+int snd_soc_test_bits(struct snd_soc_codec *codec, unsigned int reg,
+		      unsigned int mask, unsigned int value);
+
+#endif
@@ -0,0 +1,558 @@
+/*
+ * wm_adsp_test.c -- Host tests for Wolfson ADSP support
+ *
+ * Copyright 2019 Cirrus Logic, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * wm_adsp.c is built into the test so its static helpers can be reached.
+ * The DSP sits on a fake register map laid out like a CS35L41 HALO core,
+ * and every bus transaction is counted.
+ */
+
+#include "wm_adsp.c"
+
+#include "kunit.h"
+
+#define WM_ADSP_TEST_CTRL_BASE		0x02B80000
+#define WM_ADSP_TEST_SYSINFO_BASE	0x025E0000
+#define WM_ADSP_TEST_PM_BASE		0x03800000
+#define WM_ADSP_TEST_XM_PACK_BASE	0x02000000
+#define WM_ADSP_TEST_YM_PACK_BASE	0x02C00000
+#define WM_ADSP_TEST_XM_BASE		0x02800000
+#define WM_ADSP_TEST_YM_BASE		0x03400000
+#define WM_ADSP_TEST_REG_BASE		0x00001000
+#define WM_ADSP_TEST_MEM_SIZE		0x10000
+
+#define WM_ADSP_TEST_HOST_BUF		0x100
+#define WM_ADSP_TEST_ALG_ID		0x0000f20a
+#define WM_ADSP_TEST_ALG_YM		0x20
+
+static const struct wm_adsp_region wm_adsp_test_regions[] = {
+	{ .type = WMFW_HALO_PM_PACKED, .base = WM_ADSP_TEST_PM_BASE },
+	{ .type = WMFW_HALO_XM_PACKED, .base = WM_ADSP_TEST_XM_PACK_BASE },
+	{ .type = WMFW_HALO_YM_PACKED, .base = WM_ADSP_TEST_YM_PACK_BASE },
+	{ .type = WMFW_ADSP2_XM, .base = WM_ADSP_TEST_XM_BASE },
+	{ .type = WMFW_ADSP2_YM, .base = WM_ADSP_TEST_YM_BASE },
+};
+
+struct wm_adsp_test {
+	struct device dev;
+	struct regmap *regmap;
+	struct wm_adsp dsp;
+
+	struct wm_adsp_fw_defs fw;
+	struct wm_adsp_alg_region alg_region;
+
+	struct wm_adsp_buffer_region regions[ARRAY_SIZE(default_regions)];
+	struct wm_adsp_compr_buf buf;
+	struct wm_adsp_compr compr;
+	u32 raw_buf[8];
+};
+
+static unsigned int wm_adsp_test_xm(unsigned int word)
+{
+	return WM_ADSP_TEST_XM_BASE + (word * 4);
+}
+
+static int wm_adsp_test_init(struct kunit *test)
+{
+	static const struct {
+		unsigned int base;
+		unsigned int size;
+	} layout[] = {
+		{ WM_ADSP_TEST_XM_BASE, WM_ADSP_TEST_MEM_SIZE },
+		{ WM_ADSP_TEST_YM_BASE, WM_ADSP_TEST_MEM_SIZE },
+		{ WM_ADSP_TEST_PM_BASE, WM_ADSP_TEST_MEM_SIZE },
+		{ WM_ADSP_TEST_SYSINFO_BASE, 0x100 },
+		{ WM_ADSP_TEST_CTRL_BASE + HALO_MPU_XMEM_ACCESS_0, 0x3000 },
+		{ WM_ADSP_TEST_REG_BASE, 0x100 },
+	};
+	struct wm_adsp_test *priv;
+	struct wm_adsp *dsp;
+	int i, ret;
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	test->priv = priv;
+
+	priv->dev.name = "wm_adsp_test";
+
+	/* The DSP memories are 32-bit registers on a 4 byte stride */
+	priv->regmap = regmap_test_init(4, 4, false);
+	if (!priv->regmap)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(layout); i++) {
+		ret = regmap_test_add_window(priv->regmap, layout[i].base,
+					     layout[i].size / 4);
+		if (ret)
+			return ret;
+	}
+
+	priv->fw.file = "ctrl";
+	priv->fw.num_caps = ARRAY_SIZE(ctrl_caps);
+	priv->fw.caps = ctrl_caps;
+
+	dsp = &priv->dsp;
+	dsp->part = "cs35l41";
+	dsp->num = 1;
+	dsp->type = WMFW_HALO;
+	dsp->dev = &priv->dev;
+	dsp->regmap = priv->regmap;
+	dsp->base = WM_ADSP_TEST_CTRL_BASE;
+	dsp->base_sysinfo = WM_ADSP_TEST_SYSINFO_BASE;
+	dsp->mem = wm_adsp_test_regions;
+	dsp->num_mems = ARRAY_SIZE(wm_adsp_test_regions);
+	dsp->n_rx_channels = 8;
+	dsp->n_tx_channels = 8;
+	dsp->firmwares = &priv->fw;
+	dsp->num_firmwares = 1;
+	INIT_LIST_HEAD(&dsp->alg_regions);
+	INIT_LIST_HEAD(&dsp->ctl_list);
+	mutex_init(&dsp->pwr_lock);
+
+	priv->alg_region.alg = WM_ADSP_TEST_ALG_ID;
+	priv->alg_region.type = WMFW_ADSP2_YM;
+	priv->alg_region.base = WM_ADSP_TEST_ALG_YM;
+	list_add(&priv->alg_region.list, &dsp->alg_regions);
+
+	/* Two XM regions followed by one YM region, 0x100 words each */
+	priv->regions[0].mem_type = WMFW_ADSP2_XM;
+	priv->regions[0].base_addr = 0x400;
+	priv->regions[0].offset = 0;
+	priv->regions[0].cumulative_size = 0x100;
+	priv->regions[1].mem_type = WMFW_ADSP2_XM;
+	priv->regions[1].base_addr = 0x600;
+	priv->regions[1].offset = 0x100;
+	priv->regions[1].cumulative_size = 0x200;
+	priv->regions[2].mem_type = WMFW_ADSP2_YM;
+	priv->regions[2].base_addr = 0x100;
+	priv->regions[2].offset = 0x200;
+	priv->regions[2].cumulative_size = 0x300;
+
+	priv->buf.dsp = dsp;
+	priv->buf.regions = priv->regions;
+	priv->buf.host_buf_ptr = WM_ADSP_TEST_HOST_BUF;
+	priv->buf.read_index = -1;
+
+	priv->compr.dsp = dsp;
+	priv->compr.buf = &priv->buf;
+	priv->compr.raw_buf = priv->raw_buf;
+	priv->compr.size.fragment_size = sizeof(priv->raw_buf) / 4 *
+					 WM_ADSP_DATA_WORD_SIZE;
+	priv->buf.compr = &priv->compr;
+
+	return 0;
+}
+
+static void wm_adsp_test_exit(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+
+	if (!priv)
+		return;
+
+	kernel_test_clear_firmware();
+	wm_adsp_reg_seq_free(priv->dsp.mpu_seq);
+	wm_adsp_reg_seq_free(priv->dsp.arb_seq);
+	mutex_destroy(&priv->dsp.pwr_lock);
+	regmap_test_exit(priv->regmap);
+	kfree(priv);
+}
+
+static void wm_adsp_test_buffer_avail(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp_compr_buf *buf = &priv->buf;
+	unsigned int field = WM_ADSP_TEST_HOST_BUF;
+
+	/* Write pointer has wrapped behind the read pointer */
+	regmap_test_poke(priv->regmap, wm_adsp_test_xm(field +
+			 HOST_BUFFER_FIELD(next_read_index)), 0x250);
+	regmap_test_poke(priv->regmap, wm_adsp_test_xm(field +
+			 HOST_BUFFER_FIELD(next_write_index)), 0x40);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_adsp_buffer_update_avail(buf));
+	KUNIT_EXPECT_EQ(test, 0x250, buf->read_index);
+	KUNIT_EXPECT_EQ(test, 0x300 + 0x40 - 1 - 0x250, buf->avail);
+
+	/* Both indexes read, one word each */
+	KUNIT_EXPECT_EQ(test, 2U, priv->regmap->reads);
+	KUNIT_EXPECT_EQ(test, 8U, priv->regmap->bytes_read);
+
+	/* A negative read index means the firmware has not started yet */
+	buf->read_index = -1;
+	buf->avail = 0;
+	regmap_test_poke(priv->regmap, wm_adsp_test_xm(field +
+			 HOST_BUFFER_FIELD(next_read_index)), 0xffffff);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_adsp_buffer_update_avail(buf));
+	KUNIT_EXPECT_EQ(test, -1, buf->read_index);
+	KUNIT_EXPECT_EQ(test, 0, buf->avail);
+}
+
+static void wm_adsp_test_capture_block(struct kunit *test)
+{
+	static const u32 words[] = {
+		0x00112233, 0x00445566, 0xff778899, 0x00aabbcc,
+	};
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp_compr_buf *buf = &priv->buf;
+	struct wm_adsp *dsp = &priv->dsp;
+	u8 *packed = (u8 *)priv->raw_buf;
+	u32 expect;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(words); i++)
+		regmap_test_poke(priv->regmap, wm_adsp_test_xm(0x410 + i),
+				 words[i]);
+
+	buf->read_index = 0x10;
+	buf->avail = 0x20;
+
+	KUNIT_ASSERT_EQ(test, (int)ARRAY_SIZE(words),
+			wm_adsp_buffer_capture_block(&priv->compr,
+						     ARRAY_SIZE(words)));
+
+	/* Padding byte dropped, in the host order the compressed API reads */
+	for (i = 0; i < ARRAY_SIZE(words); i++) {
+		expect = words[i] & 0x00ffffffu;
+		KUNIT_EXPECT_EQ(test, 0,
+				memcmp(packed + (i * WM_ADSP_DATA_WORD_SIZE),
+				       &expect, WM_ADSP_DATA_WORD_SIZE));
+	}
+
+	KUNIT_EXPECT_EQ(test, 0x14, buf->read_index);
+	KUNIT_EXPECT_EQ(test, 0x1c, buf->avail);
+	KUNIT_EXPECT_EQ(test, 0x14U,
+			regmap_test_peek(priv->regmap, wm_adsp_test_xm(
+				WM_ADSP_TEST_HOST_BUF +
+				HOST_BUFFER_FIELD(next_read_index))));
+
+	/* One block read and one read index update per fragment */
+	KUNIT_EXPECT_EQ(test, 1U, priv->regmap->reads);
+	KUNIT_EXPECT_EQ(test, 1U, priv->regmap->writes);
+	KUNIT_EXPECT_EQ(test, 1U, dsp->bus_stats[WM_ADSP_BUS_STREAM].ops);
+}
+
+static void wm_adsp_test_capture_region_end(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp_compr_buf *buf = &priv->buf;
+
+	/* Reads stop at the end of a region and wrap at the buffer end */
+	buf->read_index = 0x1fe;
+	buf->avail = 0x20;
+
+	KUNIT_EXPECT_EQ(test, 2,
+			wm_adsp_buffer_capture_block(&priv->compr, 8));
+	KUNIT_EXPECT_EQ(test, 0x200, buf->read_index);
+
+	buf->read_index = 0x2fe;
+
+	KUNIT_EXPECT_EQ(test, 2,
+			wm_adsp_buffer_capture_block(&priv->compr, 8));
+	KUNIT_EXPECT_EQ(test, 0, buf->read_index);
+	KUNIT_EXPECT_EQ(test, 0x1c, buf->avail);
+}
+
+/* Append a wmfw region, the type sits in the top byte of the offset */
+static size_t wm_adsp_test_wmfw_region(u8 *p, int type, unsigned int offset,
+				       const void *data, size_t len)
+{
+	struct wmfw_region *region = (struct wmfw_region *)p;
+
+	region->offset = cpu_to_le32((type << 24) | offset);
+	region->len = cpu_to_le32(len);
+	memcpy(region->data, data, len);
+
+	return sizeof(*region) + len;
+}
+
+static void wm_adsp_test_load(struct kunit *test)
+{
+	static const u8 xm[] = {
+		0x00, 0x11, 0x22, 0x33, 0x00, 0x44, 0x55, 0x66,
+	};
+	static const u8 pm[] = {
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+		0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+	};
+	static const char info[] = "test firmware";
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp *dsp = &priv->dsp;
+	struct wmfw_header *header;
+	struct wmfw_adsp2_sizes *sizes;
+	u8 file[256] = { 0 };
+	size_t pos;
+
+	header = (struct wmfw_header *)file;
+	memcpy(header->magic, "WMFW", 4);
+	header->len = cpu_to_le32(sizeof(*header) + sizeof(*sizes) +
+				  sizeof(struct wmfw_footer));
+	header->ver = 3;
+	header->core = WMFW_HALO;
+
+	sizes = (struct wmfw_adsp2_sizes *)&header[1];
+	sizes->xm = cpu_to_le32(0x1000);
+	sizes->ym = cpu_to_le32(0x1000);
+	sizes->pm = cpu_to_le32(0x800);
+
+	pos = le32_to_cpu(header->len);
+	pos += wm_adsp_test_wmfw_region(&file[pos], WMFW_INFO_TEXT, 0,
+					info, sizeof(info) - 1);
+	pos += wm_adsp_test_wmfw_region(&file[pos], WMFW_ADSP2_XM, 0x10,
+					xm, sizeof(xm));
+	pos += wm_adsp_test_wmfw_region(&file[pos], WMFW_HALO_PM_PACKED, 4,
+					pm, sizeof(pm));
+
+	kernel_test_add_firmware("cs35l41-dsp1-ctrl.wmfw", file, pos);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_adsp_load(dsp));
+	KUNIT_EXPECT_EQ(test, 3, dsp->fw_ver);
+
+	/* XM words are addressed 4 bytes apart, packed PM words 5 apart */
+	KUNIT_EXPECT_EQ(test, 0x00112233U,
+			regmap_test_peek(priv->regmap, wm_adsp_test_xm(0x10)));
+	KUNIT_EXPECT_EQ(test, 0x00445566U,
+			regmap_test_peek(priv->regmap, wm_adsp_test_xm(0x11)));
+	KUNIT_EXPECT_EQ(test, 0x01020304U,
+			regmap_test_peek(priv->regmap,
+					 WM_ADSP_TEST_PM_BASE + (4 * 5)));
+	KUNIT_EXPECT_EQ(test, 0x11121314U,
+			regmap_test_peek(priv->regmap,
+					 WM_ADSP_TEST_PM_BASE + (4 * 5) + 16));
+
+	/* One queued write per memory region, completed once */
+	KUNIT_EXPECT_EQ(test, 2U, priv->regmap->writes);
+	KUNIT_EXPECT_EQ(test, 2U, priv->regmap->async_writes);
+	KUNIT_EXPECT_EQ(test, 1U, priv->regmap->async_completes);
+	KUNIT_EXPECT_EQ(test, 0U, priv->regmap->reads);
+
+	KUNIT_EXPECT_EQ(test, 1U, dsp->bus_stats[WM_ADSP_BUS_WMFW].ops);
+	KUNIT_EXPECT_EQ(test, 2U,
+			dsp->bus_stats[WM_ADSP_BUS_WMFW].transactions);
+	KUNIT_EXPECT_EQ(test, sizeof(xm) + sizeof(pm),
+			dsp->bus_stats[WM_ADSP_BUS_WMFW].bytes);
+}
+
+static void wm_adsp_test_load_bad_core(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+	struct wmfw_header *header;
+	u8 file[64] = { 0 };
+
+	header = (struct wmfw_header *)file;
+	memcpy(header->magic, "WMFW", 4);
+	header->len = cpu_to_le32(sizeof(*header) +
+				  sizeof(struct wmfw_adsp2_sizes) +
+				  sizeof(struct wmfw_footer));
+	header->ver = 3;
+	header->core = WMFW_ADSP2;
+
+	kernel_test_add_firmware("cs35l41-dsp1-ctrl.wmfw", file, sizeof(file));
+
+	KUNIT_EXPECT_EQ(test, -EINVAL, wm_adsp_load(&priv->dsp));
+	KUNIT_EXPECT_EQ(test, 0U, priv->regmap->writes);
+}
+
+/* Append a coefficient block, blocks are padded to whole words */
+static size_t wm_adsp_test_coeff_block(u8 *p, int type, unsigned int offset,
+				       unsigned int id, const void *data,
+				       size_t len)
+{
+	struct wmfw_coeff_item *blk = (struct wmfw_coeff_item *)p;
+
+	blk->offset = cpu_to_le16(offset);
+	blk->type = cpu_to_le16(type);
+	blk->id = cpu_to_le32(id);
+	blk->len = cpu_to_le32(len);
+	memcpy(blk->data, data, len);
+
+	return ALIGN(sizeof(*blk) + len, 4);
+}
+
+static void wm_adsp_test_load_coeff(struct kunit *test)
+{
+	static const u8 coeffs[] = {
+		0x00, 0xaa, 0xbb, 0xcc, 0x00, 0xdd, 0xee, 0xff,
+	};
+	static const u8 reg[] = { 0x00, 0x00, 0x12, 0x34 };
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp *dsp = &priv->dsp;
+	struct wmfw_coeff_hdr *hdr;
+	u8 file[256] = { 0 };
+	unsigned int ym;
+	size_t pos;
+
+	hdr = (struct wmfw_coeff_hdr *)file;
+	memcpy(hdr->magic, "WMDR", 4);
+	hdr->len = cpu_to_le32(sizeof(*hdr));
+	hdr->rev = cpu_to_be32(1);
+
+	pos = sizeof(*hdr);
+	pos += wm_adsp_test_coeff_block(&file[pos], WMFW_ADSP2_YM, 8,
+					WM_ADSP_TEST_ALG_ID,
+					coeffs, sizeof(coeffs));
+	pos += wm_adsp_test_coeff_block(&file[pos], WMFW_ABSOLUTE << 8,
+					WM_ADSP_TEST_REG_BASE + 0x10, 0,
+					reg, sizeof(reg));
+	/* No algorithm to place this in, so it is skipped */
+	pos += wm_adsp_test_coeff_block(&file[pos], WMFW_ADSP2_YM, 0,
+					WM_ADSP_TEST_ALG_ID + 1,
+					coeffs, sizeof(coeffs));
+
+	kernel_test_add_firmware("cs35l41-dsp1-ctrl.bin", file, pos);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_adsp_load_coeff(dsp));
+
+	/* Blocks land at the algorithm base plus the byte offset */
+	ym = WM_ADSP_TEST_YM_BASE + (WM_ADSP_TEST_ALG_YM * 4) + 8;
+	KUNIT_EXPECT_EQ(test, 0x00aabbccU,
+			regmap_test_peek(priv->regmap, ym));
+	KUNIT_EXPECT_EQ(test, 0x00ddeeffU,
+			regmap_test_peek(priv->regmap, ym + 4));
+	KUNIT_EXPECT_EQ(test, 0x1234U,
+			regmap_test_peek(priv->regmap,
+					 WM_ADSP_TEST_REG_BASE + 0x10));
+
+	KUNIT_EXPECT_EQ(test, 2U, priv->regmap->writes);
+	KUNIT_EXPECT_EQ(test, 1U, priv->regmap->async_completes);
+
+	KUNIT_EXPECT_EQ(test, 1U, dsp->bus_stats[WM_ADSP_BUS_COEFF].ops);
+	KUNIT_EXPECT_EQ(test, 2U,
+			dsp->bus_stats[WM_ADSP_BUS_COEFF].transactions);
+	KUNIT_EXPECT_EQ(test, sizeof(coeffs) + sizeof(reg),
+			dsp->bus_stats[WM_ADSP_BUS_COEFF].bytes);
+}
+
+static void wm_adsp_test_load_coeff_missing(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+
+	/* A firmware without coefficients is not an error */
+	KUNIT_EXPECT_EQ(test, 0, wm_adsp_load_coeff(&priv->dsp));
+	KUNIT_EXPECT_EQ(test, 1U, kernel_test_firmware_requests);
+	KUNIT_EXPECT_EQ(test, 0U, priv->regmap->writes);
+}
+
+static unsigned int wm_adsp_test_ctrl(unsigned int reg)
+{
+	return WM_ADSP_TEST_CTRL_BASE + reg;
+}
+
+static void wm_adsp_test_stream_arb(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp *dsp = &priv->dsp;
+	struct regmap *regmap = priv->regmap;
+	unsigned int reg;
+
+	for (reg = HALO_STREAM_ARB_MSTR0_CONFIG_0;
+	     reg <= HALO_STREAM_ARB_IRQ7_CONFIG_1; reg += 4)
+		regmap_test_poke(regmap, wm_adsp_test_ctrl(reg), 0xffffffff);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_halo_clear_stream_arb(dsp));
+
+	/*
+	 * One write per master, covering all three of its configs, one per
+	 * TX and RX channel config and one per IRQ config pair
+	 */
+	KUNIT_EXPECT_EQ(test, 6 + dsp->n_tx_channels + dsp->n_rx_channels + 8,
+			regmap->writes);
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+
+	KUNIT_EXPECT_EQ(test, 0U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_MSTR0_CONFIG_0)));
+	KUNIT_EXPECT_EQ(test, 0U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_MSTR5_CONFIG_2)));
+	KUNIT_EXPECT_EQ(test, (u32)HALO_STREAM_ARB_MSTR_SEL_DEFAULT,
+			regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_TX8_CONFIG_0)));
+	KUNIT_EXPECT_EQ(test, 0xffffffffU, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_TX8_CONFIG_1)));
+	KUNIT_EXPECT_EQ(test, (u32)HALO_STREAM_ARB_MSTR_SEL_DEFAULT,
+			regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_IRQ7_CONFIG_0)));
+	KUNIT_EXPECT_EQ(test, 0U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_STREAM_ARB_IRQ7_CONFIG_1)));
+
+	/* Later boots reuse the sequence */
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_halo_clear_stream_arb(dsp));
+	KUNIT_EXPECT_EQ(test, 6 + dsp->n_tx_channels + dsp->n_rx_channels + 8,
+			regmap->writes);
+}
+
+static void wm_adsp_test_mpu(struct kunit *test)
+{
+	struct wm_adsp_test *priv = test->priv;
+	struct wm_adsp *dsp = &priv->dsp;
+	struct regmap *regmap = priv->regmap;
+
+	regmap_test_poke(regmap, WM_ADSP_TEST_SYSINFO_BASE +
+			 HALO_SYS_INFO_XM_SRAM_SIZE, 0x8000);
+	regmap_test_poke(regmap, WM_ADSP_TEST_SYSINFO_BASE +
+			 HALO_SYS_INFO_YM_SRAM_SIZE, 0x4000);
+	regmap_test_poke(regmap, WM_ADSP_TEST_SYSINFO_BASE +
+			 HALO_SYS_INFO_XM_BANK_SIZE, 0x2000);
+	regmap_test_poke(regmap, WM_ADSP_TEST_SYSINFO_BASE +
+			 HALO_SYS_INFO_YM_BANK_SIZE, 0x2000);
+	regmap_test_poke(regmap, wm_adsp_test_ctrl(HALO_MPU_LOCK_CONFIG),
+			 0xffffffff);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_halo_configure_mpu(dsp));
+
+	/* Both bank sizes in one read, then the two memory sizes */
+	KUNIT_EXPECT_EQ(test, 3U, regmap->reads);
+
+	/*
+	 * Two unlock codes, the access registers in four runs split by the
+	 * gaps between the XREG and YREG registers, one last YREG and the lock
+	 */
+	KUNIT_EXPECT_EQ(test, 8U, regmap->writes);
+
+	KUNIT_EXPECT_EQ(test, 0xfU, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_MPU_XMEM_ACCESS_0)));
+	KUNIT_EXPECT_EQ(test, 0x3U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_MPU_YMEM_ACCESS_0)));
+	KUNIT_EXPECT_EQ(test, 0U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_MPU_YREG_ACCESS_3)));
+	KUNIT_EXPECT_EQ(test, 0U, regmap_test_peek(regmap,
+			wm_adsp_test_ctrl(HALO_MPU_LOCK_CONFIG)));
+
+	/* Later boots skip the sysinfo reads */
+	regmap_test_reset_stats(regmap);
+
+	KUNIT_ASSERT_EQ(test, 0, wm_halo_configure_mpu(dsp));
+	KUNIT_EXPECT_EQ(test, 0U, regmap->reads);
+	KUNIT_EXPECT_EQ(test, 8U, regmap->writes);
+}
+
+static struct kunit_case wm_adsp_test_cases[] = {
+	KUNIT_CASE(wm_adsp_test_buffer_avail),
+	KUNIT_CASE(wm_adsp_test_capture_block),
+	KUNIT_CASE(wm_adsp_test_capture_region_end),
+	KUNIT_CASE(wm_adsp_test_load),
+	KUNIT_CASE(wm_adsp_test_load_bad_core),
+	KUNIT_CASE(wm_adsp_test_load_coeff),
+	KUNIT_CASE(wm_adsp_test_load_coeff_missing),
+	KUNIT_CASE(wm_adsp_test_stream_arb),
+	KUNIT_CASE(wm_adsp_test_mpu),
+	{}
+};
+
+static struct kunit_suite wm_adsp_test_suite = {
+	.name = "wm_adsp",
+	.init = wm_adsp_test_init,
+	.exit = wm_adsp_test_exit,
+	.test_cases = wm_adsp_test_cases,
+};
+
+kunit_test_suite(wm_adsp_test_suite);